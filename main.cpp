@@ -11,552 +11,9384 @@
 #include <iomanip>
 #include <sstream>
 #include <random>
-#include <memory> // Para std::unique_ptr
-#include <limits> // Para std::numeric_limits
+#include <memory>    // Para std::unique_ptr
+#include <limits>    // Para std::numeric_limits
+#include <algorithm> // Para std::clamp
+#include <array>     // Para std::array
+#include <cstdint>   // Para std::intptr_t
+#include <fstream>   // Para std::ofstream
+#include <filesystem> // Para std::filesystem::temp_directory_path
+#include <charconv>  // Para std::to_chars
+#include <functional> // Para std::greater
+#include <deque>     // Para std::deque
+#include <cmath>     // Para std::ceil
+#include <cstdio>    // Para std::snprintf
+#include <cstring>   // Para std::memcpy
+#include <cstddef>   // Para offsetof
+#include <cstdlib>   // Para std::malloc e std::free
+#include <new>       // Para std::bad_alloc e std::align_val_t
+#include <type_traits> // Para std::is_trivially_copyable_v
+#include <ctime>     // Para std::strftime
+#include <string_view> // Para std::string_view
+#ifndef _WIN32
+#include <fcntl.h>    // Para open
+#include <sys/mman.h> // Para mmap, msync e munmap
+#include <unistd.h>   // Para ftruncate e close
+#include <sys/stat.h> // Para fstat
+#include <sys/socket.h> // Para socket, bind, listen e accept
+#include <netinet/in.h> // Para sockaddr_in
+#include <arpa/inet.h>  // Para htons e htonl
+#include <poll.h>       // Para poll
+#endif
+
+#ifdef SPOOL_RASTREAMENTO
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>    // Para __rdtsc
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // Para __rdtsc
+#endif
+#endif
+
+// Recursos e trechos do caminho quente acompanhados pelo rastreamento
+enum class RecursoRastro : std::uint8_t
+{
+    MutexBuffer,     // Mutex do buffer do spool
+    CoutMutex,       // Mutex da saída padrão
+    MutexDocumentos, // Mutex dos documentos divididos
+    MutexFichas,     // Mutex dos baldes de fichas do limite de taxa
+    CondVarBuffer,   // Variável de condição do buffer, compartilhada por processos e impressoras
+    Enfileirar,      // Envio de pedidos ao spool (argumento: pedidos oferecidos)
+    Retirar          // Retirada de pedidos pelas impressoras (argumento: impressora)
+};
+
+// Resumo do trace exportado, para o resumo JSON
+struct ResumoRastro
+{
+    std::uint64_t threads = 0;      // Threads que registraram eventos
+    std::uint64_t eventos = 0;      // Eventos exportados
+    std::uint64_t sobrescritos = 0; // Eventos mais antigos perdidos por buffer cheio
+};
+
+// Rastreamento do caminho quente, compilado só com -DSPOOL_RASTREAMENTO: sem a macro, os mutexes
+// instrumentados são std::mutex, as esperas usam o predicado da própria variável de condição e as
+// macros de rastro somem. Cada thread grava seus eventos, com o contador de ciclos (TSC), em um
+// buffer circular próprio, sem locks; ao final da execução, o trace vai para um arquivo no formato
+// do Chrome (chrome://tracing, ui.perfetto.dev).
+#ifdef SPOOL_RASTREAMENTO
+
+// Contador de ciclos do processador; supõe TSC invariante, sincronizado entre os núcleos. Em outras
+// arquiteturas, usa o steady_clock em ns.
+inline std::uint64_t ler_tsc()
+{
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Fase de um evento de rastro
+enum class FaseRastro : std::uint8_t
+{
+    Espera,    // Espera para travar um mutex (só quando ele estava ocupado)
+    Posse,     // Mutex travado
+    Despertar, // Espera na variável de condição até acordar (argumento: 1 = a condição valia)
+    Trecho     // Trecho do caminho do spool
+};
+
+// Evento de rastro com início e fim em ciclos
+struct EventoRastro
+{
+    std::uint64_t inicio;   // TSC no início
+    std::uint64_t fim;      // TSC no fim
+    std::int32_t argumento; // Argumento, conforme o recurso e a fase
+    RecursoRastro recurso;  // Recurso ou trecho
+    FaseRastro fase;        // Fase
+};
+
+// Buffer circular de eventos de uma única thread: ao encher, sobrescreve os mais antigos, para que o
+// trace guarde o fim da execução (onde o spool travou)
+class BufferRastroThread
+{
+public:
+    static constexpr std::size_t CAPACIDADE = 1 << 15; // Potência de 2
+
+    explicit BufferRastroThread(int id_thread) : id(id_thread), eventos(new EventoRastro[CAPACIDADE]) {}
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    BufferRastroThread(const BufferRastroThread &) = delete;
+    BufferRastroThread &operator=(const BufferRastroThread &) = delete;
+
+    // Grava um evento (só a thread dona escreve)
+    void registrar(const EventoRastro &evento)
+    {
+        std::uint64_t posicao = total.load(std::memory_order_relaxed);
+        eventos[posicao & (CAPACIDADE - 1)] = evento;
+        total.store(posicao + 1, std::memory_order_release);
+    }
+
+    const int id;                           // Identificador da thread no trace
+    std::unique_ptr<EventoRastro[]> eventos; // Eventos, em ordem circular
+    std::atomic<std::uint64_t> total{0};     // Eventos gravados desde o início
+};
+
+// Nome de um recurso ou trecho no trace
+const char *nome_recurso_rastro(RecursoRastro recurso)
+{
+    switch (recurso)
+    {
+    case RecursoRastro::MutexBuffer:
+        return "mutex_buffer";
+    case RecursoRastro::CoutMutex:
+        return "cout_mutex";
+    case RecursoRastro::MutexDocumentos:
+        return "mutex_documentos";
+    case RecursoRastro::MutexFichas:
+        return "mutex_fichas";
+    case RecursoRastro::CondVarBuffer:
+        return "cond_var_buffer";
+    case RecursoRastro::Enfileirar:
+        return "add_pedidos";
+    case RecursoRastro::Retirar:
+        return "get_pedidos";
+    }
+    return "";
+}
+
+// Coleta os eventos das threads enquanto ativo e os exporta no formato de trace do Chrome
+class Rastreador
+{
+public:
+    // Começa a registrar; o instante inicial é o zero do trace e a primeira referência da calibração
+    void ativar()
+    {
+        relogio_inicio = std::chrono::steady_clock::now();
+        tsc_inicio = ler_tsc();
+        ligado.store(true, std::memory_order_release);
+    }
+
+    // Grava um evento no buffer da thread atual (nada, se desativado)
+    void registrar(RecursoRastro recurso, FaseRastro fase, std::uint64_t inicio, std::uint64_t fim, std::int32_t argumento = 0)
+    {
+        if (!ligado.load(std::memory_order_relaxed))
+            return;
+        buffer_da_thread()->registrar(EventoRastro{inicio, fim, argumento, recurso, fase});
+    }
+
+    // Para de registrar e grava o trace (as threads rastreadas já terminaram). Os ciclos viram µs pela
+    // razão entre o TSC e o steady_clock medida do início até agora.
+    ResumoRastro exportar(const std::string &arquivo)
+    {
+        ligado.store(false, std::memory_order_relaxed);
+        std::uint64_t tsc_fim = ler_tsc();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - relogio_inicio).count();
+        double us_por_ciclo = tsc_fim > tsc_inicio ? ns / 1000.0 / static_cast<double>(tsc_fim - tsc_inicio) : 0.0;
+
+        ResumoRastro resumo;
+        std::ofstream saida(arquivo);
+        std::string texto = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool primeiro = true;
+        char linha[256];
+        std::lock_guard<std::mutex> lock(mutex_buffers);
+        for (const auto &buffer : buffers)
+        {
+            std::uint64_t total = buffer->total.load(std::memory_order_acquire);
+            std::uint64_t inicio = total > BufferRastroThread::CAPACIDADE ? total - BufferRastroThread::CAPACIDADE : 0;
+            ++resumo.threads;
+            resumo.eventos += total - inicio;
+            resumo.sobrescritos += inicio;
+            std::snprintf(linha, sizeof(linha),
+                          "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                          primeiro ? "" : ",", buffer->id, buffer->id);
+            texto += linha;
+            primeiro = false;
+            for (std::uint64_t i = inicio; i < total; ++i)
+            {
+                const EventoRastro &evento = buffer->eventos[i & (BufferRastroThread::CAPACIDADE - 1)];
+                double ts = static_cast<double>(evento.inicio - tsc_inicio) * us_por_ciclo;
+                double dur = static_cast<double>(evento.fim - evento.inicio) * us_por_ciclo;
+                formatar_evento(linha, sizeof(linha), evento, buffer->id, ts, dur);
+                texto += linha;
+            }
+            if (texto.size() > (1 << 20))
+            {
+                saida << texto;
+                texto.clear();
+            }
+        }
+        texto += "\n]}\n";
+        saida << texto;
+        saida.close();
+        if (!saida)
+            throw std::runtime_error("não foi possível gravar o trace em '" + arquivo + "'");
+        return resumo;
+    }
+
+private:
+    std::atomic<bool> ligado{false};                          // Registro ativo
+    std::chrono::steady_clock::time_point relogio_inicio;     // Zero do trace no steady_clock
+    std::uint64_t tsc_inicio = 0;                             // Zero do trace em ciclos
+    std::vector<std::unique_ptr<BufferRastroThread>> buffers; // Um buffer por thread, nunca reaproveitado
+    std::mutex mutex_buffers;                                 // Protege a lista (só no primeiro evento da thread)
+
+    // Buffer da thread atual, criado no primeiro evento; cada thread vira uma linha própria no trace
+    BufferRastroThread *buffer_da_thread()
+    {
+        thread_local BufferRastroThread *buffer = nullptr;
+        if (buffer)
+            return buffer;
+        std::lock_guard<std::mutex> lock(mutex_buffers);
+        buffers.push_back(std::make_unique<BufferRastroThread>(static_cast<int>(buffers.size()) + 1));
+        buffer = buffers.back().get();
+        return buffer;
+    }
+
+    // Um evento completo ("ph":"X") do trace, com o tempo em µs desde a ativação
+    static void formatar_evento(char *linha, std::size_t tamanho, const EventoRastro &evento, int id_thread, double ts,
+                                double dur)
+    {
+        const char *nome = nome_recurso_rastro(evento.recurso);
+        switch (evento.fase)
+        {
+        case FaseRastro::Espera:
+        case FaseRastro::Posse:
+            std::snprintf(linha, tamanho, ",\n{\"name\":\"%s %s\",\"cat\":\"mutex\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                          evento.fase == FaseRastro::Espera ? "espera" : "posse", nome, ts, dur, id_thread);
+            break;
+        case FaseRastro::Despertar:
+            std::snprintf(linha, tamanho, ",\n{\"name\":\"%s %s\",\"cat\":\"condicao\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"condicao_satisfeita\":%s}}",
+                          evento.argumento ? "despertar" : "despertar inútil", nome, ts, dur, id_thread,
+                          evento.argumento ? "true" : "false");
+            break;
+        case FaseRastro::Trecho:
+            std::snprintf(linha, tamanho, ",\n{\"name\":\"%s\",\"cat\":\"spool\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"%s\":%d}}",
+                          nome, ts, dur, id_thread, evento.recurso == RecursoRastro::Enfileirar ? "pedidos" : "impressora",
+                          evento.argumento);
+            break;
+        }
+    }
+};
+
+// Rastreador global; só registra depois de ativar() (opção --rastro)
+Rastreador rastreador;
+
+// Mutex que registra a espera (quando já estava travado) e o tempo de posse a cada uso
+template <RecursoRastro Recurso>
+class MutexRastreado
+{
+public:
+    MutexRastreado() = default;
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    MutexRastreado(const MutexRastreado &) = delete;
+    MutexRastreado &operator=(const MutexRastreado &) = delete;
+
+    void lock()
+    {
+        if (!mutex.try_lock())
+        {
+            std::uint64_t inicio = ler_tsc();
+            mutex.lock();
+            inicio_posse = ler_tsc();
+            rastreador.registrar(Recurso, FaseRastro::Espera, inicio, inicio_posse);
+            return;
+        }
+        inicio_posse = ler_tsc();
+    }
+
+    bool try_lock()
+    {
+        if (!mutex.try_lock())
+            return false;
+        inicio_posse = ler_tsc();
+        return true;
+    }
+
+    void unlock()
+    {
+        std::uint64_t inicio = inicio_posse;
+        std::uint64_t fim = ler_tsc();
+        mutex.unlock();
+        rastreador.registrar(Recurso, FaseRastro::Posse, inicio, fim);
+    }
+
+private:
+    std::mutex mutex;               // Mutex real
+    std::uint64_t inicio_posse = 0; // Início da posse atual (só quem detém o mutex escreve e lê)
+};
+
+// Trecho do caminho do spool, registrado do construtor ao destrutor
+class TrechoRastro
+{
+public:
+    TrechoRastro(RecursoRastro trecho, std::int32_t argumento) : recurso(trecho), valor(argumento), inicio(ler_tsc()) {}
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    TrechoRastro(const TrechoRastro &) = delete;
+    TrechoRastro &operator=(const TrechoRastro &) = delete;
+
+    ~TrechoRastro()
+    {
+        rastreador.registrar(recurso, FaseRastro::Trecho, inicio, ler_tsc(), valor);
+    }
+
+private:
+    RecursoRastro recurso; // Trecho rastreado
+    std::int32_t valor;    // Argumento do trecho
+    std::uint64_t inicio;  // TSC no início
+};
+
+// A variável de condição aceita o mutex instrumentado, que registra a posse também em volta das esperas
+template <RecursoRastro Recurso>
+using MutexInstrumentado = MutexRastreado<Recurso>;
+using CondicaoInstrumentada = std::condition_variable_any;
+
+#define SPOOL_RASTRO_TRECHO(trecho, argumento) TrechoRastro trecho_rastro((trecho), static_cast<std::int32_t>(argumento))
+#else
+template <RecursoRastro Recurso>
+using MutexInstrumentado = std::mutex;
+using CondicaoInstrumentada = std::condition_variable;
+
+#define SPOOL_RASTRO_TRECHO(trecho, argumento) ((void)0)
+#endif
+
+// Espera na variável de condição até que o predicado valha. Com o rastreamento, registra cada
+// despertar e se a condição valia: um despertar inútil volta a dormir, como os de um notify_one
+// que acorda o lado errado de uma variável compartilhada por produtores e consumidores.
+template <typename Condicao, typename Trava, typename Predicado>
+void esperar_condicao([[maybe_unused]] RecursoRastro recurso, Condicao &cond_var, Trava &lock, Predicado pronto)
+{
+#ifdef SPOOL_RASTREAMENTO
+    while (!pronto())
+    {
+        std::uint64_t inicio = ler_tsc();
+        cond_var.wait(lock);
+        bool satisfeita = pronto();
+        rastreador.registrar(recurso, FaseRastro::Despertar, inicio, ler_tsc(), satisfeita ? 1 : 0);
+        if (satisfeita)
+            return;
+    }
+#else
+    cond_var.wait(lock, pronto);
+#endif
+}
+
+// Versão de esperar_condicao com prazo; retorna o valor final do predicado
+template <typename Condicao, typename Trava, typename Predicado>
+bool esperar_condicao_ate([[maybe_unused]] RecursoRastro recurso, Condicao &cond_var, Trava &lock,
+                          std::chrono::steady_clock::time_point prazo, Predicado pronto)
+{
+#ifdef SPOOL_RASTREAMENTO
+    while (!pronto())
+    {
+        std::uint64_t inicio = ler_tsc();
+        bool expirou = cond_var.wait_until(lock, prazo) == std::cv_status::timeout;
+        bool satisfeita = pronto();
+        rastreador.registrar(recurso, FaseRastro::Despertar, inicio, ler_tsc(), satisfeita ? 1 : 0);
+        if (satisfeita || expirou)
+            return satisfeita;
+    }
+    return true;
+#else
+    return cond_var.wait_until(lock, prazo, pronto);
+#endif
+}
+
+// Mutex global para sincronizar o acesso ao std::cout
+using MutexSaida = MutexInstrumentado<RecursoRastro::CoutMutex>;
+MutexSaida cout_mutex;
+
+// Contador global de alocações no heap, lido pela verificação de alocações do benchmark. Só existe no
+// build de benchmark (-DSPOOL_CONTAR_ALOCACOES, alvo spool_benchmark do CMake), para que o programa
+// comum não pague um incremento atômico compartilhado por alocação. Substitui os operadores new e
+// delete comuns e alinhados (as versões de array e nothrow da biblioteca passam por eles), alocando
+// com std::malloc ou, com alinhamento, com a função alinhada do sistema. Os operadores ficam fora de
+// linha aos pares: com só um lado embutido, o GCC acusa um falso par malloc/delete incompatível.
+#ifdef SPOOL_CONTAR_ALOCACOES
+std::atomic<std::uint64_t> alocacoes_heap(0);
+
+[[gnu::noinline]] void *operator new(std::size_t tamanho)
+{
+    alocacoes_heap.fetch_add(1, std::memory_order_relaxed);
+    if (void *memoria = std::malloc(tamanho == 0 ? 1 : tamanho))
+        return memoria;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *memoria) noexcept
+{
+    std::free(memoria);
+}
+
+[[gnu::noinline]] void operator delete(void *memoria, std::size_t) noexcept
+{
+    std::free(memoria);
+}
+
+[[gnu::noinline]] void *operator new(std::size_t tamanho, std::align_val_t alinhamento)
+{
+    alocacoes_heap.fetch_add(1, std::memory_order_relaxed);
+    std::size_t bytes = static_cast<std::size_t>(alinhamento);
+#ifdef _WIN32
+    void *memoria = _aligned_malloc(tamanho == 0 ? 1 : tamanho, bytes);
+#else
+    // aligned_alloc exige um tamanho múltiplo do alinhamento
+    void *memoria = std::aligned_alloc(bytes, (std::max<std::size_t>(tamanho, 1) + bytes - 1) / bytes * bytes);
+#endif
+    if (memoria == nullptr)
+        throw std::bad_alloc();
+    return memoria;
+}
+
+[[gnu::noinline]] void operator delete(void *memoria, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(memoria);
+#else
+    std::free(memoria);
+#endif
+}
+
+[[gnu::noinline]] void operator delete(void *memoria, std::size_t, std::align_val_t alinhamento) noexcept
+{
+    operator delete(memoria, alinhamento);
+}
+#endif
+
+// Níveis de log, do menos para o mais detalhado
+enum class NivelLog : std::uint8_t
+{
+    Silencioso = 0, // Nenhuma mensagem durante a execução
+    Resumo = 1,     // Descartes e eventos de ciclo de vida (processos, impressoras, encerramento)
+    Detalhado = 2   // Inclui as mensagens por pedido
+};
+
+// Tipos de evento do logger; cada tipo tem um formato de saída fixo e campos inteiros
+enum class TipoEvento : std::uint8_t
+{
+    PedidoGerado,            // Campos: processo, pedido, páginas, prioridade
+    PedidoRecebido,          // Campos: processo, pedido, páginas, prioridade
+    PedidoDescartado,        // Campos: processo, pedido
+    PedidoLimitado,          // Campos: processo, pedido
+    PedidoDespejado,         // Campos: processo, pedido, prioridade do pedido que entrou no lugar
+    PedidoCancelado,         // Campos: processo, pedido
+    DescarteNotificado,      // Campos: processo, pedido
+    ImpressaoIniciada,       // Campos: impressora, processo, pedido, páginas, prioridade
+    ImpressaoConcluida,      // Campos: impressora, processo, pedido
+    ImpressaoInterrompida,   // Campos: impressora, processo, pedido, páginas restantes, prioridade do
+                             // pedido que a interrompeu (0 = fim do prazo de drenagem)
+    DrenagemEsgotada,        // Campos: pedidos descartados do buffer
+    ImpressoraEncerrando,    // Campos: impressora
+    ProcessoFinalizado,      // Campos: processo
+    MonitorIniciado,         // Campos: tempo limite de inatividade (s)
+    EncerramentoSemTrabalho, // Sem campos
+    EncerramentoInatividade  // Campos: tempo limite de inatividade (s)
+};
+
+// Evento estruturado: a formatação do texto só acontece na thread de escrita
+struct EventoLog
+{
+    std::int64_t instante;   // steady_clock em ns, ordena eventos de threads diferentes
+    TipoEvento tipo;         // Tipo do evento
+    NivelLog nivel;          // Nível do evento
+    std::int32_t campos[5];  // Campos do evento, conforme o tipo
+};
+
+// As mensagens por pedido podem ser removidas na compilação com -DSPOOL_LOG_SILENCIOSO
+#ifdef SPOOL_LOG_SILENCIOSO
+#define SPOOL_LOG_PEDIDO(...) ((void)0)
+#else
+#define SPOOL_LOG_PEDIDO(...) logger.registrar(NivelLog::Detalhado, __VA_ARGS__)
+#endif
+
+// Buffer circular de eventos de uma única thread (um produtor, um consumidor)
+class BufferLogThread
+{
+public:
+    static constexpr std::size_t CAPACIDADE = 1024; // Potência de 2
+
+    // Tenta inserir um evento; retorna false se o buffer estiver cheio
+    bool tentar_inserir(const EventoLog &evento)
+    {
+        std::size_t cauda = posicao_cauda.load(std::memory_order_relaxed);
+        if (cauda - posicao_cabeca.load(std::memory_order_acquire) == CAPACIDADE)
+            return false;
+        eventos[cauda & (CAPACIDADE - 1)] = evento;
+        posicao_cauda.store(cauda + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Move todos os eventos publicados para o destino (usado apenas pela thread de escrita)
+    void drenar(std::vector<EventoLog> &destino)
+    {
+        std::size_t cabeca = posicao_cabeca.load(std::memory_order_relaxed);
+        std::size_t cauda = posicao_cauda.load(std::memory_order_acquire);
+        for (; cabeca != cauda; ++cabeca)
+            destino.push_back(eventos[cabeca & (CAPACIDADE - 1)]);
+        posicao_cabeca.store(cabeca, std::memory_order_release);
+    }
+
+    // Indica que o buffer passou de 3/4 da capacidade
+    bool quase_cheio() const
+    {
+        return posicao_cauda.load(std::memory_order_relaxed) - posicao_cabeca.load(std::memory_order_relaxed) >
+               CAPACIDADE * 3 / 4;
+    }
+
+    // Indica que todos os eventos já foram drenados
+    bool vazio() const
+    {
+        return posicao_cauda.load(std::memory_order_acquire) == posicao_cabeca.load(std::memory_order_acquire);
+    }
+
+    std::atomic<bool> em_uso{true}; // false quando a thread dona terminou e o buffer pode ser reaproveitado
+
+private:
+    std::array<EventoLog, CAPACIDADE> eventos;                // Eventos armazenados
+    alignas(64) std::atomic<std::size_t> posicao_cabeca{0}; // Próximo evento a drenar
+    alignas(64) std::atomic<std::size_t> posicao_cauda{0};  // Próxima posição de escrita
+};
+
+// Logger assíncrono: as threads publicam eventos em buffers próprios, sem locks, e uma
+// thread de escrita formata e grava tudo na saída. Se o buffer de uma thread estiver
+// cheio o evento é descartado e contado, para que a thread nunca espere pela saída.
+class Logger
+{
+public:
+    Logger() = default;
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    ~Logger()
+    {
+        encerrar();
+    }
+
+    // Define o nível de log em tempo de execução
+    void definir_nivel(NivelLog novo_nivel)
+    {
+        nivel.store(novo_nivel, std::memory_order_relaxed);
+    }
+
+    // Indica se eventos do nível informado serão registrados
+    bool habilitado(NivelLog nivel_evento) const
+    {
+        return nivel_evento <= nivel.load(std::memory_order_relaxed);
+    }
+
+    // Registra um evento estruturado sem bloquear
+    void registrar(NivelLog nivel_evento, TipoEvento tipo, std::int32_t a = 0, std::int32_t b = 0,
+                   std::int32_t c = 0, std::int32_t d = 0, std::int32_t e = 0)
+    {
+        if (!habilitado(nivel_evento))
+            return;
+        EventoLog evento{std::chrono::steady_clock::now().time_since_epoch().count(), tipo, nivel_evento, {a, b, c, d, e}};
+        BufferLogThread *buffer = buffer_da_thread();
+        if (!buffer->tentar_inserir(evento))
+        {
+            eventos_descartados.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (buffer->quase_cheio())
+            cond_var_escrita.notify_one(); // Antecipa a próxima drenagem
+    }
+
+    // Inicia a thread de escrita
+    void iniciar(std::ostream &saida_log = std::cout)
+    {
+        encerrar();
+        saida = &saida_log;
+        parar = false;
+        thread_escrita = std::thread(&Logger::escrever_continuamente, this);
+    }
+
+    // Grava os eventos pendentes e encerra a thread de escrita
+    void encerrar()
+    {
+        if (!thread_escrita.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_escrita);
+            parar = true;
+        }
+        cond_var_escrita.notify_one();
+        thread_escrita.join();
+    }
+
+    // Quantidade de eventos descartados por buffer cheio
+    std::uint64_t descartados() const
+    {
+        return eventos_descartados.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<NivelLog> nivel{NivelLog::Detalhado};          // Nível de log atual
+    std::atomic<std::uint64_t> eventos_descartados{0};         // Eventos perdidos por buffer cheio
+    std::vector<std::unique_ptr<BufferLogThread>> buffers;     // Buffers de todas as threads (nunca liberados)
+    std::mutex mutex_buffers;                                  // Protege a lista de buffers (só no registro da thread)
+    std::ostream *saida = &std::cout;                          // Destino das mensagens
+    std::thread thread_escrita;                                // Thread de escrita
+    std::mutex mutex_escrita;                                  // Mutex da espera da thread de escrita
+    std::condition_variable cond_var_escrita;                  // Acorda a thread de escrita
+    bool parar = false;                                        // Pedido de encerramento da thread de escrita
+
+    // Associação entre a thread atual e seu buffer; libera o buffer quando a thread termina
+    struct VinculoThread
+    {
+        BufferLogThread *buffer = nullptr;
+        ~VinculoThread()
+        {
+            if (buffer)
+                buffer->em_uso.store(false, std::memory_order_release);
+        }
+    };
+
+    // Obtém o buffer da thread atual, reaproveitando buffers vazios de threads encerradas
+    BufferLogThread *buffer_da_thread()
+    {
+        thread_local VinculoThread vinculo;
+        if (vinculo.buffer)
+            return vinculo.buffer;
+
+        std::lock_guard<std::mutex> lock(mutex_buffers);
+        for (auto &buffer : buffers)
+        {
+            if (!buffer->em_uso.load(std::memory_order_acquire) && buffer->vazio())
+            {
+                buffer->em_uso.store(true, std::memory_order_relaxed);
+                vinculo.buffer = buffer.get();
+                return vinculo.buffer;
+            }
+        }
+        buffers.push_back(std::make_unique<BufferLogThread>());
+        vinculo.buffer = buffers.back().get();
+        return vinculo.buffer;
+    }
+
+    // Laço da thread de escrita: drena os buffers periodicamente ou quando algum está quase cheio
+    void escrever_continuamente()
+    {
+        std::vector<EventoLog> eventos;
+        std::string texto;
+        std::unique_lock<std::mutex> lock(mutex_escrita);
+        while (!parar)
+        {
+            lock.unlock();
+            bool houve_eventos = escrever_pendentes(eventos, texto);
+            lock.lock();
+            if (!houve_eventos && !parar)
+                cond_var_escrita.wait_for(lock, std::chrono::milliseconds(5));
+        }
+        lock.unlock();
+        escrever_pendentes(eventos, texto); // Drenagem final
+    }
+
+    // Drena todos os buffers, ordena os eventos pelo instante e grava o texto de uma vez
+    bool escrever_pendentes(std::vector<EventoLog> &eventos, std::string &texto)
+    {
+        std::vector<BufferLogThread *> ativos;
+        {
+            std::lock_guard<std::mutex> lock(mutex_buffers);
+            for (auto &buffer : buffers)
+                ativos.push_back(buffer.get());
+        }
+
+        eventos.clear();
+        for (BufferLogThread *buffer : ativos)
+            buffer->drenar(eventos);
+        if (eventos.empty())
+            return false;
+
+        std::stable_sort(eventos.begin(), eventos.end(), [](const EventoLog &a, const EventoLog &b)
+                         { return a.instante < b.instante; });
+        texto.clear();
+        for (const EventoLog &evento : eventos)
+            formatar_evento(texto, evento);
+
+        std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+        saida->write(texto.data(), static_cast<std::streamsize>(texto.size()));
+        saida->flush();
+        return true;
+    }
+
+    // Acrescenta um inteiro ao texto sem alocações temporárias
+    static void acrescentar_inteiro(std::string &texto, std::int32_t valor)
+    {
+        char digitos[16];
+        auto resultado = std::to_chars(digitos, digitos + sizeof(digitos), valor);
+        texto.append(digitos, resultado.ptr);
+    }
+
+    // Acrescenta ao texto o nome do documento derivado do processo e do pedido
+    static void formatar_documento(std::string &texto, std::int32_t id_processo, std::int32_t id_pedido)
+    {
+        texto += "arquivo_";
+        acrescentar_inteiro(texto, id_processo);
+        texto += '_';
+        acrescentar_inteiro(texto, id_pedido);
+    }
+
+    // Acrescenta " com N páginas, prioridade P.\n"
+    static void formatar_paginas_prioridade(std::string &texto, std::int32_t paginas, std::int32_t prioridade)
+    {
+        texto += " com ";
+        acrescentar_inteiro(texto, paginas);
+        texto += " páginas, prioridade ";
+        acrescentar_inteiro(texto, prioridade);
+        texto += ".\n";
+    }
+
+    // Converte um evento estruturado no texto exibido
+    static void formatar_evento(std::string &texto, const EventoLog &evento)
+    {
+        const std::int32_t *c = evento.campos;
+        const char *separador = "-----------------------------------------\n";
+        switch (evento.tipo)
+        {
+        case TipoEvento::PedidoGerado:
+            texto += separador;
+            texto += "Processo ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " gerou pedido ";
+            formatar_documento(texto, c[0], c[1]);
+            formatar_paginas_prioridade(texto, c[2], c[3]);
+            texto += separador;
+            texto += "\n";
+            break;
+        case TipoEvento::PedidoRecebido:
+            texto += separador;
+            texto += "Spool recebeu pedido ";
+            formatar_documento(texto, c[0], c[1]);
+            formatar_paginas_prioridade(texto, c[2], c[3]);
+            texto += separador;
+            texto += "\n";
+            break;
+        case TipoEvento::PedidoDescartado:
+            texto += "Buffer cheio. Pedido ";
+            formatar_documento(texto, c[0], c[1]);
+            texto += " foi descartado.\n\n";
+            break;
+        case TipoEvento::PedidoLimitado:
+            texto += "Limite de taxa do processo ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " atingido. Pedido ";
+            formatar_documento(texto, c[0], c[1]);
+            texto += " foi recusado.\n\n";
+            break;
+        case TipoEvento::PedidoDespejado:
+            texto += "Buffer cheio. Pedido ";
+            formatar_documento(texto, c[0], c[1]);
+            texto += " foi despejado para dar lugar a um pedido de prioridade ";
+            acrescentar_inteiro(texto, c[2]);
+            texto += ".\n\n";
+            break;
+        case TipoEvento::PedidoCancelado:
+            texto += "Pedido ";
+            formatar_documento(texto, c[0], c[1]);
+            texto += " foi cancelado antes da impressão.\n\n";
+            break;
+        case TipoEvento::DescarteNotificado:
+            texto += "Processo ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " notificou que o pedido ";
+            formatar_documento(texto, c[0], c[1]);
+            texto += " foi descartado.\n\n";
+            break;
+        case TipoEvento::ImpressaoIniciada:
+            texto += separador;
+            texto += "Impressora ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " iniciou processamento de ";
+            formatar_documento(texto, c[1], c[2]);
+            formatar_paginas_prioridade(texto, c[3], c[4]);
+            texto += separador;
+            texto += "\n";
+            break;
+        case TipoEvento::ImpressaoConcluida:
+            texto += separador;
+            texto += "Impressora ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " concluiu processamento de ";
+            formatar_documento(texto, c[1], c[2]);
+            texto += ".\n";
+            texto += separador;
+            texto += "\n";
+            break;
+        case TipoEvento::ImpressaoInterrompida:
+            texto += "Impressora ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " interrompeu ";
+            formatar_documento(texto, c[1], c[2]);
+            texto += " com ";
+            acrescentar_inteiro(texto, c[3]);
+            if (c[4] > 0)
+            {
+                texto += " páginas restantes para imprimir um pedido de prioridade ";
+                acrescentar_inteiro(texto, c[4]);
+                texto += ".\n\n";
+            }
+            else
+            {
+                texto += " páginas restantes: prazo de drenagem esgotado.\n\n";
+            }
+            break;
+        case TipoEvento::DrenagemEsgotada:
+            texto += "Prazo de drenagem esgotado. ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " pedidos pendentes foram descartados do buffer.\n\n";
+            break;
+        case TipoEvento::ImpressoraEncerrando:
+            texto += "Impressora ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " está encerrando.\n\n";
+            break;
+        case TipoEvento::ProcessoFinalizado:
+            texto += "Processo ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " finalizou.\n\n";
+            break;
+        case TipoEvento::MonitorIniciado:
+            texto += "Relatório será gerado quando todos os processos finalizarem e a fila esvaziar, ou após ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " segundos sem novos pedidos.\n\n";
+            break;
+        case TipoEvento::EncerramentoSemTrabalho:
+            texto += "\nTodos os processos finalizaram e a fila foi esvaziada. Sinalizando encerramento.\n\n";
+            break;
+        case TipoEvento::EncerramentoInatividade:
+            texto += "\nNenhuma nova solicitação de impressão recebida por ";
+            acrescentar_inteiro(texto, c[0]);
+            texto += " segundos. Sinalizando encerramento.\n\n";
+            break;
+        }
+    }
+};
+
+// Logger global usado por Spool, Impressora e Processo
+Logger logger;
+
+// Níveis de prioridade aceitos pelo spool
+constexpr int PRIORIDADE_MINIMA = 1;
+constexpr int PRIORIDADE_MAXIMA = 5;
+constexpr int NUM_PRIORIDADES = PRIORIDADE_MAXIMA - PRIORIDADE_MINIMA + 1;
+
+// Índice (0 a NUM_PRIORIDADES - 1) do nível de uma prioridade, limitada à faixa aceita
+inline int indice_prioridade(int prioridade)
+{
+    return std::clamp(prioridade, PRIORIDADE_MINIMA, PRIORIDADE_MAXIMA) - PRIORIDADE_MINIMA;
+}
+
+// Estrutura que define um pedido de impressão. É um registro compacto e trivialmente copiável
+// (sem strings nem ponteiros): passar um pedido pelo spool não aloca memória, e o nome do
+// documento é derivado do processo e do pedido com nome_documento() só quando é exibido.
+struct Pedido
+{
+    int id;                                                 // Identificador único do pedido
+    int num_paginas;                                        // Número de páginas do documento
+    std::int16_t prioridade;                                // Prioridade do pedido (1 a 5)
+    std::int16_t parte = 0;                                 // Parte de um documento dividido (0 = documento inteiro)
+    int id_processo;                                        // Identificador do processo que gerou o pedido
+    std::chrono::system_clock::time_point hora_solicitacao; // Horário da solicitação
+    std::uint64_t sequencia = 0;                            // Sequência no diário do spool (0 = sem diário)
+
+    // Sobrecarga do operador < para definir a ordem de prioridade na fila
+    bool operator<(const Pedido &outro) const
+    {
+        // Maior prioridade (valor maior) tem precedência
+        if (prioridade == outro.prioridade)
+        {
+            // Se as prioridades forem iguais, o pedido mais antigo tem precedência
+            return hora_solicitacao > outro.hora_solicitacao;
+        }
+        return prioridade < outro.prioridade;
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<Pedido>, "Pedido deve ser copiado sem alocações");
+static_assert(sizeof(Pedido) == 32, "Pedido deve caber em meia linha de cache");
+
+// Estrutura que armazena os dados de um pedido processado (linha montada a partir das colunas no relatório)
+struct RegistroImpressao
+{
+    int id_pedido;                                          // Identificador do pedido no processo
+    int num_paginas;                                        // Número de páginas
+    int id_processo;                                        // Identificador do processo solicitante
+    int id_impressora;                                      // Identificador da impressora utilizada
+    std::chrono::system_clock::time_point hora_solicitacao; // Horário da solicitação
+    std::chrono::system_clock::time_point hora_inicio;      // Horário de início da impressão
+    std::chrono::milliseconds tempo_total;                  // Tempo total de impressão
+    int prioridade;                                         // Prioridade do pedido
+    int parte;                                              // Parte de um documento dividido (0 = documento inteiro)
+};
+
+// Nome do documento derivado do processo e do pedido (os registros não guardam strings)
+std::string nome_documento(int id_processo, int id_pedido)
+{
+    return "arquivo_" + std::to_string(id_processo) + "_" + std::to_string(id_pedido);
+}
+
+// Histograma de latências no estilo HDR: faixas logarítmicas (potências de 2) divididas em 32 sub-faixas
+// lineares, com erro relativo de até ~3%, de 0 a ~2^41 µs. Cada histograma tem um único escritor (a thread
+// da impressora); os contadores são atômicos relaxados para que possam ser lidos durante a execução.
+class Histograma
+{
+public:
+    static constexpr int BITS_SUBFAIXA = 5;                   // 32 sub-faixas por potência de 2
+    static constexpr int SUBFAIXAS = 1 << BITS_SUBFAIXA;
+    static constexpr int MAIOR_EXPOENTE = 40;                 // Maior potência de 2 representada (~12 dias em µs)
+    static constexpr int NUM_FAIXAS = (MAIOR_EXPOENTE - BITS_SUBFAIXA + 2) * SUBFAIXAS;
+
+    Histograma() = default;
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    Histograma(const Histograma &) = delete;
+    Histograma &operator=(const Histograma &) = delete;
+
+    // Registra um valor em microssegundos (só o escritor do histograma chama)
+    void registrar(std::int64_t valor_us)
+    {
+        std::uint64_t valor = static_cast<std::uint64_t>(std::clamp<std::int64_t>(valor_us, 0, VALOR_MAXIMO));
+        incrementar(faixas[indice(valor)], 1);
+        incrementar(total, 1);
+        incrementar(soma, valor);
+        if (valor > maior.load(std::memory_order_relaxed))
+            maior.store(valor, std::memory_order_relaxed);
+    }
+
+    // Acumula os contadores de outro histograma neste
+    void mesclar(const Histograma &outro)
+    {
+        for (int i = 0; i < NUM_FAIXAS; ++i)
+        {
+            std::uint64_t quantidade = outro.faixas[i].load(std::memory_order_relaxed);
+            if (quantidade > 0)
+                faixas[i].fetch_add(quantidade, std::memory_order_relaxed);
+        }
+        total.fetch_add(outro.total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        soma.fetch_add(outro.soma.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        std::uint64_t maior_outro = outro.maior.load(std::memory_order_relaxed);
+        if (maior_outro > maior.load(std::memory_order_relaxed))
+            maior.store(maior_outro, std::memory_order_relaxed);
+    }
+
+    // Quantidade de valores registrados
+    std::uint64_t contagem() const
+    {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    // Maior valor registrado, em µs
+    std::int64_t maximo() const
+    {
+        return static_cast<std::int64_t>(maior.load(std::memory_order_relaxed));
+    }
+
+    // Média dos valores registrados, em µs
+    double media() const
+    {
+        std::uint64_t quantidade = contagem();
+        return quantidade > 0 ? static_cast<double>(soma.load(std::memory_order_relaxed)) / quantidade : 0.0;
+    }
+
+    // Percentil (0 a 100), em µs: limite superior da faixa que contém o valor, limitado ao máximo
+    std::int64_t percentil(double p) const
+    {
+        std::uint64_t quantidade = contagem();
+        if (quantidade == 0)
+            return 0;
+        std::uint64_t alvo = static_cast<std::uint64_t>(std::ceil(p / 100.0 * quantidade));
+        alvo = std::clamp<std::uint64_t>(alvo, 1, quantidade);
+        std::uint64_t acumulado = 0;
+        for (int i = 0; i < NUM_FAIXAS; ++i)
+        {
+            acumulado += faixas[i].load(std::memory_order_relaxed);
+            if (acumulado >= alvo)
+                return std::min(limite_superior(i), maximo());
+        }
+        return maximo();
+    }
+
+private:
+    static constexpr std::int64_t VALOR_MAXIMO = (std::int64_t(1) << (MAIOR_EXPOENTE + 1)) - 1;
+
+    std::array<std::atomic<std::uint64_t>, NUM_FAIXAS> faixas{}; // Contagem por faixa
+    std::atomic<std::uint64_t> total{0};                        // Quantidade de valores
+    std::atomic<std::uint64_t> soma{0};                         // Soma dos valores, para a média
+    std::atomic<std::uint64_t> maior{0};                        // Maior valor
+
+    // Um único escritor: leitura e escrita relaxadas, sem instrução atômica de leitura-modificação
+    static void incrementar(std::atomic<std::uint64_t> &contador, std::uint64_t valor)
+    {
+        contador.store(contador.load(std::memory_order_relaxed) + valor, std::memory_order_relaxed);
+    }
+
+    // Valores abaixo de 2 * SUBFAIXAS têm faixa própria; acima, a faixa guarda os BITS_SUBFAIXA + 1
+    // bits mais significativos do valor
+    static int indice(std::uint64_t valor)
+    {
+        if (valor < 2 * SUBFAIXAS)
+            return static_cast<int>(valor);
+        int expoente = 63;
+        while ((valor >> expoente) == 0)
+            --expoente;
+        int deslocamento = expoente - BITS_SUBFAIXA;
+        return deslocamento * SUBFAIXAS + static_cast<int>(valor >> deslocamento);
+    }
+
+    // Maior valor que cai na faixa
+    static std::int64_t limite_superior(int indice_faixa)
+    {
+        if (indice_faixa < 2 * SUBFAIXAS)
+            return indice_faixa;
+        int deslocamento = indice_faixa / SUBFAIXAS - 1;
+        std::int64_t mantissa = indice_faixa % SUBFAIXAS + SUBFAIXAS;
+        return ((mantissa + 1) << deslocamento) - 1;
+    }
+};
+
+// Percentis reportados para cada histograma de latência
+constexpr std::array<double, 4> PERCENTIS_RELATORIO = {50.0, 90.0, 99.0, 99.9};
+
+// Métricas que podem ser registradas por prioridade
+enum class MetricaLatencia : std::uint8_t
+{
+    Espera,      // Tempo na fila: início da impressão - solicitação
+    Servico,     // Tempo de impressão
+    PontaAPonta, // Espera + impressão
+};
+constexpr int NUM_METRICAS_LATENCIA = 3;
+
+// Histogramas de latência de uma impressora, por métrica e por prioridade
+class LatenciasImpressora
+{
+public:
+    // Registra as latências de um pedido impresso. A parte de um documento dividido conta na espera e
+    // na impressão; o ponta a ponta só é registrado quando o pedido conclui o documento, e como as
+    // partes herdam a solicitação do documento, é o ponta a ponta do documento inteiro. O trecho que
+    // retoma uma impressão interrompida não conta de novo na espera.
+    void registrar(int prioridade, std::int64_t espera_us, std::int64_t servico_us, bool conclui_documento = true,
+                   bool retomada = false)
+    {
+        int p = indice_prioridade(prioridade);
+        if (!retomada)
+            histogramas[static_cast<int>(MetricaLatencia::Espera)][p].registrar(espera_us);
+        histogramas[static_cast<int>(MetricaLatencia::Servico)][p].registrar(servico_us);
+        if (conclui_documento)
+            histogramas[static_cast<int>(MetricaLatencia::PontaAPonta)][p].registrar(espera_us + servico_us);
+    }
+
+    // Histograma de uma métrica para uma prioridade
+    const Histograma &histograma(MetricaLatencia metrica, int prioridade) const
+    {
+        return histogramas[static_cast<int>(metrica)][prioridade - PRIORIDADE_MINIMA];
+    }
+
+private:
+    std::array<std::array<Histograma, NUM_PRIORIDADES>, NUM_METRICAS_LATENCIA> histogramas;
+};
+
+// Esperas de uma prioridade comparadas ao limite, contando cada documento uma vez
+struct EsperasLimite
+{
+    std::size_t documentos = 0; // Documentos medidos
+    std::size_t acima = 0;      // Documentos que esperaram mais que o limite
+};
+
+// Registros de uma impressora em colunas (struct-of-arrays), divididas em blocos de tamanho fixo.
+// Só a thread da impressora acrescenta registros, então não há lock; os blocos nunca são
+// realocados, e as colunas das impressoras só são mescladas na geração do relatório.
+// A quantidade, as páginas, o estado ocupado/ociosa e os histogramas são atômicos de escritor único,
+// para que as métricas ao vivo os leiam durante a execução.
+class ColunasImpressora
+{
+public:
+    static constexpr std::size_t TAMANHO_BLOCO = 4096; // Registros por bloco
+
+    ColunasImpressora() = default;
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    ColunasImpressora(const ColunasImpressora &) = delete;
+    ColunasImpressora &operator=(const ColunasImpressora &) = delete;
+
+    // Acrescenta o registro de um pedido impresso e suas latências; conclui_documento é falso para as
+    // partes de um documento dividido que não são a última a terminar e para os trechos de uma impressão
+    // interrompida que não são o último. retomada indica o trecho que continua uma impressão interrompida.
+    void acrescentar(const Pedido &pedido, std::chrono::system_clock::time_point hora_inicio,
+                     std::chrono::microseconds tempo_total, bool conclui_documento = true, bool retomada = false)
+    {
+        std::size_t indice = quantidade.load(std::memory_order_relaxed);
+        std::size_t posicao = indice % TAMANHO_BLOCO;
+        if (posicao == 0)
+            blocos.push_back(std::make_unique<Bloco>()); // Zerado uma vez a cada TAMANHO_BLOCO registros
+        Bloco &bloco = *blocos.back();
+        bloco.id_pedido[posicao] = pedido.id;
+        bloco.id_processo[posicao] = pedido.id_processo;
+        bloco.num_paginas[posicao] = pedido.num_paginas;
+        bloco.prioridade[posicao] = static_cast<std::int8_t>(pedido.prioridade);
+        bloco.parte[posicao] = pedido.parte;
+        bloco.retomada[posicao] = retomada;
+        bloco.hora_solicitacao[posicao] = pedido.hora_solicitacao.time_since_epoch().count();
+        bloco.hora_inicio[posicao] = hora_inicio.time_since_epoch().count();
+        bloco.tempo_total_ms[posicao] = static_cast<std::int32_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(tempo_total).count());
+        quantidade.store(indice + 1, std::memory_order_relaxed);
+        paginas_impressas.store(paginas_impressas.load(std::memory_order_relaxed) + pedido.num_paginas,
+                                std::memory_order_relaxed);
+        if (conclui_documento)
+            documentos.store(documentos.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        auto espera = std::chrono::duration_cast<std::chrono::microseconds>(hora_inicio - pedido.hora_solicitacao);
+        latencias_impressora.registrar(pedido.prioridade, espera.count(), tempo_total.count(), conclui_documento, retomada);
+        tempo_ocupado += tempo_total;
+        if (indice == 0 || pedido.hora_solicitacao < primeira_solicitacao)
+            primeira_solicitacao = pedido.hora_solicitacao;
+        ultimo_termino = std::max(ultimo_termino, hora_inicio + tempo_total);
+    }
+
+    // Marca a impressora como ocupada (imprimindo) ou ociosa
+    void marcar_ocupada(bool imprimindo)
+    {
+        ocupada_agora.store(imprimindo, std::memory_order_relaxed);
+    }
+
+    // Indica se a impressora está imprimindo
+    bool ocupada() const
+    {
+        return ocupada_agora.load(std::memory_order_relaxed);
+    }
+
+    // Histogramas de latência desta impressora
+    const LatenciasImpressora &latencias() const
+    {
+        return latencias_impressora;
+    }
+
+    // Soma dos tempos de impressão, para a utilização da impressora
+    std::chrono::microseconds tempo_impressao() const
+    {
+        return tempo_ocupado;
+    }
+
+    // Horário da solicitação mais antiga registrada (válido com tamanho() > 0)
+    std::chrono::system_clock::time_point inicio_janela() const
+    {
+        return primeira_solicitacao;
+    }
+
+    // Horário do último término registrado (válido com tamanho() > 0)
+    std::chrono::system_clock::time_point fim_janela() const
+    {
+        return ultimo_termino;
+    }
+
+    // Quantidade de registros armazenados
+    std::size_t tamanho() const
+    {
+        return quantidade.load(std::memory_order_relaxed);
+    }
+
+    // Total de páginas impressas
+    std::int64_t total_paginas() const
+    {
+        return paginas_impressas.load(std::memory_order_relaxed);
+    }
+
+    // Documentos concluídos por esta impressora: os inteiros e os divididos cuja última parte ela imprimiu
+    std::size_t documentos_concluidos() const
+    {
+        return documentos.load(std::memory_order_relaxed);
+    }
+
+    // Instante de término do registro, usado para mesclar as colunas na ordem de conclusão
+    std::chrono::system_clock::time_point hora_fim(std::size_t indice) const
+    {
+        const Bloco &bloco = *blocos[indice / TAMANHO_BLOCO];
+        std::size_t posicao = indice % TAMANHO_BLOCO;
+        return std::chrono::system_clock::time_point(std::chrono::system_clock::duration(bloco.hora_inicio[posicao])) +
+               std::chrono::milliseconds(bloco.tempo_total_ms[posicao]);
+    }
+
+    // Monta a linha de um registro
+    RegistroImpressao registro(std::size_t indice, int id_impressora) const
+    {
+        const Bloco &bloco = *blocos[indice / TAMANHO_BLOCO];
+        std::size_t posicao = indice % TAMANHO_BLOCO;
+        RegistroImpressao registro;
+        registro.id_pedido = bloco.id_pedido[posicao];
+        registro.num_paginas = bloco.num_paginas[posicao];
+        registro.id_processo = bloco.id_processo[posicao];
+        registro.id_impressora = id_impressora;
+        registro.hora_solicitacao = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(bloco.hora_solicitacao[posicao]));
+        registro.hora_inicio = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(bloco.hora_inicio[posicao]));
+        registro.tempo_total = std::chrono::milliseconds(bloco.tempo_total_ms[posicao]);
+        registro.prioridade = bloco.prioridade[posicao];
+        registro.parte = bloco.parte[posicao];
+        return registro;
+    }
+
+    // Documentos da prioridade cuja espera na fila passou do limite (contagem exata, sobre as colunas).
+    // A espera do documento é a do seu primeiro registro: os trechos retomados não voltam à fila e as
+    // partes seguintes de um documento dividido herdam a solicitação dele.
+    EsperasLimite esperas_acima(int prioridade, std::chrono::microseconds limite) const
+    {
+        std::int64_t limite_relogio = std::chrono::duration_cast<std::chrono::system_clock::duration>(limite).count();
+        EsperasLimite esperas;
+        for (std::size_t indice = 0; indice < tamanho(); ++indice)
+        {
+            const Bloco &bloco = *blocos[indice / TAMANHO_BLOCO];
+            std::size_t posicao = indice % TAMANHO_BLOCO;
+            if (bloco.prioridade[posicao] != prioridade || bloco.retomada[posicao] || bloco.parte[posicao] > 1)
+                continue;
+            ++esperas.documentos;
+            if (bloco.hora_inicio[posicao] - bloco.hora_solicitacao[posicao] > limite_relogio)
+                ++esperas.acima;
+        }
+        return esperas;
+    }
+
+    // Memória ocupada pelas colunas, em bytes
+    std::size_t memoria_bytes() const
+    {
+        return blocos.size() * sizeof(Bloco) + blocos.capacity() * sizeof(std::unique_ptr<Bloco>);
+    }
+
+private:
+    // Um bloco de colunas; os horários são contagens do system_clock desde a época
+    struct Bloco
+    {
+        std::array<std::int32_t, TAMANHO_BLOCO> id_pedido;
+        std::array<std::int32_t, TAMANHO_BLOCO> id_processo;
+        std::array<std::int32_t, TAMANHO_BLOCO> num_paginas;
+        std::array<std::int8_t, TAMANHO_BLOCO> prioridade;
+        std::array<std::int16_t, TAMANHO_BLOCO> parte;
+        std::array<bool, TAMANHO_BLOCO> retomada;
+        std::array<std::int64_t, TAMANHO_BLOCO> hora_solicitacao;
+        std::array<std::int64_t, TAMANHO_BLOCO> hora_inicio;
+        std::array<std::int32_t, TAMANHO_BLOCO> tempo_total_ms;
+    };
+
+    std::vector<std::unique_ptr<Bloco>> blocos;       // Blocos de colunas, em ordem de conclusão
+    std::atomic<std::size_t> quantidade{0};           // Quantidade de registros
+    std::atomic<std::int64_t> paginas_impressas{0};   // Páginas impressas, substitui o mapa global por impressora
+    std::atomic<std::size_t> documentos{0};           // Documentos concluídos
+    std::atomic<bool> ocupada_agora{false};           // Imprimindo neste momento
+    LatenciasImpressora latencias_impressora;   // Espera, impressão e ponta a ponta por prioridade
+    std::chrono::microseconds tempo_ocupado{0}; // Soma dos tempos de impressão
+    std::chrono::system_clock::time_point primeira_solicitacao; // Solicitação mais antiga
+    std::chrono::system_clock::time_point ultimo_termino;       // Término mais recente
+};
+
+// Conjunto dos registros de todas as impressoras, uma coluna independente por impressora
+class RegistrosImpressao
+{
+public:
+    // Construtor que cria as colunas das impressoras 1..num_impressoras
+    explicit RegistrosImpressao(int num_impressoras)
+    {
+        for (int i = 0; i < num_impressoras; ++i)
+            colunas_impressoras.push_back(std::make_unique<ColunasImpressora>());
+    }
+
+    // Colunas da impressora (identificadores começam em 1)
+    ColunasImpressora &colunas(int id_impressora)
+    {
+        return *colunas_impressoras[id_impressora - 1];
+    }
+
+    const ColunasImpressora &colunas(int id_impressora) const
+    {
+        return *colunas_impressoras[id_impressora - 1];
+    }
+
+    // Quantidade de impressoras
+    int num_impressoras() const
+    {
+        return static_cast<int>(colunas_impressoras.size());
+    }
+
+    // Quantidade total de registros
+    std::size_t total() const
+    {
+        std::size_t soma = 0;
+        for (const auto &colunas : colunas_impressoras)
+            soma += colunas->tamanho();
+        return soma;
+    }
+
+    // Quantidade de documentos concluídos; difere de total() quando há documentos divididos em partes
+    std::size_t documentos() const
+    {
+        std::size_t soma = 0;
+        for (const auto &colunas : colunas_impressoras)
+            soma += colunas->documentos_concluidos();
+        return soma;
+    }
+
+    // Total de páginas impressas por todas as impressoras
+    std::int64_t total_paginas() const
+    {
+        std::int64_t soma = 0;
+        for (const auto &colunas : colunas_impressoras)
+            soma += colunas->total_paginas();
+        return soma;
+    }
+
+    // Duração da janela observada, da solicitação mais antiga ao último término, em segundos
+    double duracao_janela_s() const
+    {
+        bool vazia = true;
+        std::chrono::system_clock::time_point inicio, fim;
+        for (const auto &colunas : colunas_impressoras)
+        {
+            if (colunas->tamanho() == 0)
+                continue;
+            if (vazia || colunas->inicio_janela() < inicio)
+                inicio = colunas->inicio_janela();
+            if (vazia || colunas->fim_janela() > fim)
+                fim = colunas->fim_janela();
+            vazia = false;
+        }
+        return vazia ? 0.0 : std::chrono::duration<double>(fim - inicio).count();
+    }
+
+    // Acumula em destino os histogramas de uma métrica (prioridade ou impressora 0 = todas)
+    void acumular_latencias(MetricaLatencia metrica, int prioridade, int id_impressora, Histograma &destino) const
+    {
+        for (int i = 1; i <= num_impressoras(); ++i)
+        {
+            if (id_impressora != 0 && id_impressora != i)
+                continue;
+            for (int p = PRIORIDADE_MINIMA; p <= PRIORIDADE_MAXIMA; ++p)
+            {
+                if (prioridade == 0 || prioridade == p)
+                    destino.mesclar(colunas(i).latencias().histograma(metrica, p));
+            }
+        }
+    }
+
+    // Documentos da prioridade, em todas as impressoras, medidos e que esperaram mais que o limite
+    EsperasLimite esperas_acima(int prioridade, std::chrono::microseconds limite) const
+    {
+        EsperasLimite soma;
+        for (const auto &colunas : colunas_impressoras)
+        {
+            EsperasLimite esperas = colunas->esperas_acima(prioridade, limite);
+            soma.documentos += esperas.documentos;
+            soma.acima += esperas.acima;
+        }
+        return soma;
+    }
+
+    // Visita os registros de todas as impressoras em ordem de conclusão (cada coluna já está ordenada),
+    // mesclando as colunas sob demanda, sem montar o vetor completo
+    template <typename Visitante>
+    void percorrer(Visitante &&visitar) const
+    {
+        using Cursor = std::pair<std::chrono::system_clock::time_point, int>; // (término, impressora)
+        std::priority_queue<Cursor, std::vector<Cursor>, std::greater<Cursor>> proximos;
+        std::vector<std::size_t> posicoes(colunas_impressoras.size(), 0);
+        for (int i = 0; i < num_impressoras(); ++i)
+        {
+            if (colunas_impressoras[i]->tamanho() > 0)
+                proximos.emplace(colunas_impressoras[i]->hora_fim(0), i);
+        }
+
+        while (!proximos.empty())
+        {
+            int i = proximos.top().second;
+            proximos.pop();
+            const ColunasImpressora &origem = *colunas_impressoras[i];
+            visitar(origem.registro(posicoes[i], i + 1));
+            if (++posicoes[i] < origem.tamanho())
+                proximos.emplace(origem.hora_fim(posicoes[i]), i);
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<ColunasImpressora>> colunas_impressoras; // Uma alocação por impressora, sem falso compartilhamento
+};
+
+// Formata horários no relógio local com memória do último segundo: localtime só é chamado quando o
+// segundo muda, e os registros, em ordem de conclusão, ficam quase sempre no mesmo segundo
+class FormatadorHorario
+{
+public:
+    // Escreve "HH:MM:SS" em destino e retorna o fim
+    char *hora(std::chrono::system_clock::time_point instante, char *destino)
+    {
+        atualizar(instante);
+        return std::copy(texto.begin() + 11, texto.begin() + 19, destino);
+    }
+
+    // Escreve "AAAA-MM-DDTHH:MM:SS.mmm" em destino e retorna o fim
+    char *data_hora(std::chrono::system_clock::time_point instante, char *destino)
+    {
+        atualizar(instante);
+        destino = std::copy(texto.begin(), texto.begin() + 19, destino);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(instante.time_since_epoch()).count() % 1000;
+        *destino++ = '.';
+        *destino++ = static_cast<char>('0' + ms / 100);
+        *destino++ = static_cast<char>('0' + ms / 10 % 10);
+        *destino++ = static_cast<char>('0' + ms % 10);
+        return destino;
+    }
+
+private:
+    void atualizar(std::chrono::system_clock::time_point instante)
+    {
+        std::time_t segundo = std::chrono::system_clock::to_time_t(instante);
+        if (segundo == segundo_formatado)
+            return;
+        std::tm tm;
+#ifdef _WIN32
+        localtime_s(&tm, &segundo); // Função segura para Windows
+#else
+        localtime_r(&segundo, &tm); // Função segura para Unix/Linux
+#endif
+        std::strftime(texto.data(), texto.size(), "%Y-%m-%dT%H:%M:%S", &tm);
+        segundo_formatado = segundo;
+    }
+
+    std::time_t segundo_formatado = std::numeric_limits<std::time_t>::min(); // Segundo em texto
+    std::array<char, 20> texto{};                                            // "AAAA-MM-DDTHH:MM:SS"
+};
+
+// Formato dos registros gravados pelo EscritorRelatorio
+enum class FormatoRelatorio : std::uint8_t
+{
+    Texto = 1,      // Bloco legível por documento (formato original do relatório)
+    Csv = 2,        // Uma linha por documento, com cabeçalho
+    JsonLinhas = 3, // Um objeto JSON por linha
+    Binario = 4     // Cabeçalho e registros de tamanho fixo (CabecalhoRelatorioBinario, RegistroBinario)
+};
+
+// Nome do formato do relatório, como aceito na linha de comando
+const char *nome_formato(FormatoRelatorio formato)
+{
+    switch (formato)
+    {
+    case FormatoRelatorio::Texto:
+        return "texto";
+    case FormatoRelatorio::Csv:
+        return "csv";
+    case FormatoRelatorio::JsonLinhas:
+        return "jsonl";
+    case FormatoRelatorio::Binario:
+        return "binario";
+    }
+    return "";
+}
+
+// Cabeçalho do relatório binário, seguido de `registros` registros de `tamanho_registro` bytes.
+// Inteiros na ordem de bytes da máquina que gravou (little-endian nas plataformas usuais).
+struct CabecalhoRelatorioBinario
+{
+    char assinatura[8] = {'S', 'P', 'O', 'O', 'L', 'R', 'B', '\0'}; // Identifica o arquivo
+    std::uint32_t versao = 1;                                        // Versão do formato
+    std::uint32_t tamanho_registro = 0;                              // sizeof(RegistroBinario)
+    std::uint64_t registros = 0;                                     // Quantidade de registros
+};
+
+// Um documento no relatório binário; horários em µs desde a época do system_clock
+struct RegistroBinario
+{
+    std::int64_t hora_solicitacao_us; // Horário da solicitação
+    std::int64_t hora_inicio_us;      // Horário de início da impressão
+    std::int32_t id_pedido;           // Identificador do pedido no processo
+    std::int32_t id_processo;         // Identificador do processo solicitante
+    std::int32_t num_paginas;         // Número de páginas
+    std::int32_t tempo_total_ms;      // Tempo total de impressão
+    std::int32_t id_impressora;       // Identificador da impressora utilizada
+    std::int8_t prioridade;           // Prioridade do pedido
+    std::int8_t reservado;            // Zero (sem bytes de preenchimento indefinidos)
+    std::int16_t parte;               // Parte de um documento dividido (0 = documento inteiro)
+};
+static_assert(sizeof(CabecalhoRelatorioBinario) == 24, "cabeçalho binário sem preenchimento");
+static_assert(sizeof(RegistroBinario) == 40, "registro binário sem preenchimento");
+
+// Grava os registros de todas as impressoras em ordem de conclusão, em blocos: a mesclagem das colunas
+// enche um bloco por thread, as threads formatam os blocos em paralelo (com a memória do horário de
+// cada uma) e os blocos são gravados na ordem, em uma escrita por bloco. O resultado não depende da
+// quantidade de threads, e a memória usada é a de alguns blocos, não a do relatório inteiro.
+class EscritorRelatorio
+{
+public:
+    static constexpr std::size_t REGISTROS_POR_BLOCO = 16384; // Registros formatados por thread de uma vez
+
+    // Construtor que define a saída, o formato e as threads que formatam (1 = só a thread chamadora)
+    EscritorRelatorio(std::ostream &saida, FormatoRelatorio formato, int num_threads = 1)
+        : saida(saida), formato(formato), blocos(std::max(1, num_threads)), textos(blocos.size()),
+          horarios(blocos.size())
+    {
+        for (auto &bloco : blocos)
+            bloco.reserve(REGISTROS_POR_BLOCO);
+    }
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    EscritorRelatorio(const EscritorRelatorio &) = delete;
+    EscritorRelatorio &operator=(const EscritorRelatorio &) = delete;
+
+    // Grava o cabeçalho do formato e todos os registros. Retorna a quantidade de registros gravados.
+    std::size_t escrever(const RegistrosImpressao &registros)
+    {
+        if (formato == FormatoRelatorio::Csv)
+            saida << "documento,paginas,processo,impressora,prioridade,hora_solicitacao,hora_impressao,tempo_total_ms,parte\n";
+        else if (formato == FormatoRelatorio::Binario)
+        {
+            CabecalhoRelatorioBinario cabecalho;
+            cabecalho.tamanho_registro = sizeof(RegistroBinario);
+            cabecalho.registros = registros.total();
+            saida.write(reinterpret_cast<const char *>(&cabecalho), sizeof(cabecalho));
+        }
+
+        std::size_t gravados = 0;
+        std::size_t atual = 0;
+        registros.percorrer([this, &gravados, &atual](const RegistroImpressao &registro)
+                            {
+                                blocos[atual].push_back(registro);
+                                ++gravados;
+                                if (blocos[atual].size() == REGISTROS_POR_BLOCO && ++atual == blocos.size())
+                                {
+                                    gravar_blocos();
+                                    atual = 0;
+                                } });
+        gravar_blocos();
+        return gravados;
+    }
+
+private:
+    // Formata os blocos cheios (cada um em uma thread) e os grava na ordem
+    void gravar_blocos()
+    {
+        std::vector<std::thread> auxiliares;
+        for (std::size_t i = 1; i < blocos.size() && !blocos[i].empty(); ++i)
+            auxiliares.emplace_back(&EscritorRelatorio::formatar_bloco, this, i);
+        formatar_bloco(0);
+        for (auto &auxiliar : auxiliares)
+            auxiliar.join();
+
+        for (std::size_t i = 0; i < blocos.size() && !blocos[i].empty(); ++i)
+        {
+            saida.write(textos[i].data(), static_cast<std::streamsize>(textos[i].size()));
+            blocos[i].clear();
+        }
+    }
+
+    void formatar_bloco(std::size_t indice)
+    {
+        std::string &texto = textos[indice];
+        texto.clear();
+        char linha[512];
+        for (const RegistroImpressao &registro : blocos[indice])
+        {
+            char *fim = formatar(registro, linha, horarios[indice]);
+            texto.append(linha, fim);
+        }
+    }
+
+    static char *copiar(char *destino, std::string_view texto)
+    {
+        return std::copy(texto.begin(), texto.end(), destino);
+    }
+
+    static char *inteiro(char *destino, long long valor)
+    {
+        return std::to_chars(destino, destino + 20, valor).ptr;
+    }
+
+    static char *documento(char *destino, const RegistroImpressao &registro)
+    {
+        destino = copiar(destino, "arquivo_");
+        destino = inteiro(destino, registro.id_processo);
+        *destino++ = '_';
+        return inteiro(destino, registro.id_pedido);
+    }
+
+    // Formata um registro em destino (espaço de sobra para qualquer formato) e retorna o fim
+    char *formatar(const RegistroImpressao &registro, char *destino, FormatadorHorario &horario) const
+    {
+        switch (formato)
+        {
+        case FormatoRelatorio::Texto:
+            destino = copiar(destino, "-----------------------------------------\nDocumento         : ");
+            destino = documento(destino, registro);
+            destino = copiar(destino, "\nPáginas           : ");
+            destino = inteiro(destino, registro.num_paginas);
+            destino = copiar(destino, "\nProcesso          : ");
+            destino = inteiro(destino, registro.id_processo);
+            destino = copiar(destino, "\nImpressora        : ");
+            destino = inteiro(destino, registro.id_impressora);
+            destino = copiar(destino, "\nPrioridade        : ");
+            destino = inteiro(destino, registro.prioridade);
+            if (registro.parte > 0)
+            {
+                destino = copiar(destino, "\nParte             : ");
+                destino = inteiro(destino, registro.parte);
+            }
+            destino = copiar(destino, "\nHora Solicitação  : ");
+            destino = horario.hora(registro.hora_solicitacao, destino);
+            destino = copiar(destino, "\nHora Impressão    : ");
+            destino = horario.hora(registro.hora_inicio, destino);
+            destino = copiar(destino, "\nTempo Total       : ");
+            destino = inteiro(destino, registro.tempo_total.count());
+            return copiar(destino, "ms\n-----------------------------------------\n\n");
+        case FormatoRelatorio::Csv:
+            destino = documento(destino, registro);
+            *destino++ = ',';
+            destino = inteiro(destino, registro.num_paginas);
+            *destino++ = ',';
+            destino = inteiro(destino, registro.id_processo);
+            *destino++ = ',';
+            destino = inteiro(destino, registro.id_impressora);
+            *destino++ = ',';
+            destino = inteiro(destino, registro.prioridade);
+            *destino++ = ',';
+            destino = horario.data_hora(registro.hora_solicitacao, destino);
+            *destino++ = ',';
+            destino = horario.data_hora(registro.hora_inicio, destino);
+            *destino++ = ',';
+            destino = inteiro(destino, registro.tempo_total.count());
+            *destino++ = ',';
+            destino = inteiro(destino, registro.parte);
+            *destino++ = '\n';
+            return destino;
+        case FormatoRelatorio::JsonLinhas:
+            destino = copiar(destino, "{\"documento\":\"");
+            destino = documento(destino, registro);
+            destino = copiar(destino, "\",\"paginas\":");
+            destino = inteiro(destino, registro.num_paginas);
+            destino = copiar(destino, ",\"processo\":");
+            destino = inteiro(destino, registro.id_processo);
+            destino = copiar(destino, ",\"impressora\":");
+            destino = inteiro(destino, registro.id_impressora);
+            destino = copiar(destino, ",\"prioridade\":");
+            destino = inteiro(destino, registro.prioridade);
+            destino = copiar(destino, ",\"hora_solicitacao\":\"");
+            destino = horario.data_hora(registro.hora_solicitacao, destino);
+            destino = copiar(destino, "\",\"hora_impressao\":\"");
+            destino = horario.data_hora(registro.hora_inicio, destino);
+            destino = copiar(destino, "\",\"tempo_total_ms\":");
+            destino = inteiro(destino, registro.tempo_total.count());
+            destino = copiar(destino, ",\"parte\":");
+            destino = inteiro(destino, registro.parte);
+            return copiar(destino, "}\n");
+        case FormatoRelatorio::Binario:
+        {
+            RegistroBinario binario{};
+            binario.hora_solicitacao_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                              registro.hora_solicitacao.time_since_epoch())
+                                              .count();
+            binario.hora_inicio_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                         registro.hora_inicio.time_since_epoch())
+                                         .count();
+            binario.id_pedido = registro.id_pedido;
+            binario.id_processo = registro.id_processo;
+            binario.num_paginas = registro.num_paginas;
+            binario.tempo_total_ms = static_cast<std::int32_t>(registro.tempo_total.count());
+            binario.id_impressora = registro.id_impressora;
+            binario.prioridade = static_cast<std::int8_t>(registro.prioridade);
+            binario.parte = static_cast<std::int16_t>(registro.parte);
+            std::memcpy(destino, &binario, sizeof(binario));
+            return destino + sizeof(binario);
+        }
+        }
+        return destino;
+    }
+
+    std::ostream &saida;                               // Destino do relatório
+    FormatoRelatorio formato;                          // Formato dos registros
+    std::vector<std::vector<RegistroImpressao>> blocos; // Um bloco de registros por thread
+    std::vector<std::string> textos;                   // Texto formatado de cada bloco
+    std::vector<FormatadorHorario> horarios;           // Memória do horário de cada thread
+};
+
+// Contador global de processos ativos
+std::atomic<int> processos_ativos(0);
+
+// Backends disponíveis para a fila do spool
+enum class BackendSpool
+{
+    Mutex = 1,   // Fila de prioridade única protegida por mutex (comportamento original)
+    LockFree = 2 // Um buffer circular lock-free por nível de prioridade
+};
+
+// Buffer circular limitado, múltiplos produtores e múltiplos consumidores, sem locks.
+// Cada célula guarda um número de sequência que indica se está livre para escrita
+// ou pronta para leitura na volta atual do anel.
+template <typename T>
+class FilaCircularMPMC
+{
+public:
+    // Construtor que arredonda a capacidade para a próxima potência de 2
+    explicit FilaCircularMPMC(std::size_t capacidade_minima)
+    {
+        std::size_t tamanho = 1;
+        while (tamanho < capacidade_minima)
+            tamanho <<= 1;
+        mascara = tamanho - 1;
+        celulas.reset(new Celula[tamanho]);
+        for (std::size_t i = 0; i < tamanho; ++i)
+            celulas[i].sequencia.store(i, std::memory_order_relaxed);
+        posicao_escrita.store(0, std::memory_order_relaxed);
+        posicao_leitura.store(0, std::memory_order_relaxed);
+    }
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    FilaCircularMPMC(const FilaCircularMPMC &) = delete;
+    FilaCircularMPMC &operator=(const FilaCircularMPMC &) = delete;
+
+    // Tenta inserir um elemento; retorna false se o anel estiver cheio
+    bool tentar_inserir(const T &valor)
+    {
+        Celula *celula;
+        std::size_t posicao = posicao_escrita.load(std::memory_order_relaxed);
+        while (true)
+        {
+            celula = &celulas[posicao & mascara];
+            std::size_t sequencia = celula->sequencia.load(std::memory_order_acquire);
+            std::intptr_t diferenca = static_cast<std::intptr_t>(sequencia) - static_cast<std::intptr_t>(posicao);
+            if (diferenca == 0)
+            {
+                if (posicao_escrita.compare_exchange_weak(posicao, posicao + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diferenca < 0)
+            {
+                return false; // A célula ainda não foi consumida na volta anterior
+            }
+            else
+            {
+                posicao = posicao_escrita.load(std::memory_order_relaxed);
+            }
+        }
+        celula->valor = valor;
+        celula->sequencia.store(posicao + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Tenta retirar o elemento mais antigo; retorna false se o anel estiver vazio
+    bool tentar_retirar(T &valor)
+    {
+        Celula *celula;
+        std::size_t posicao = posicao_leitura.load(std::memory_order_relaxed);
+        while (true)
+        {
+            celula = &celulas[posicao & mascara];
+            std::size_t sequencia = celula->sequencia.load(std::memory_order_acquire);
+            std::intptr_t diferenca = static_cast<std::intptr_t>(sequencia) - static_cast<std::intptr_t>(posicao + 1);
+            if (diferenca == 0)
+            {
+                if (posicao_leitura.compare_exchange_weak(posicao, posicao + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diferenca < 0)
+            {
+                return false; // Nenhum elemento publicado nesta posição
+            }
+            else
+            {
+                posicao = posicao_leitura.load(std::memory_order_relaxed);
+            }
+        }
+        valor = std::move(celula->valor);
+        celula->sequencia.store(posicao + mascara + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Celula
+    {
+        std::atomic<std::size_t> sequencia; // Número de sequência da célula
+        T valor;                            // Elemento armazenado
+    };
+
+    std::unique_ptr<Celula[]> celulas;                    // Células do anel
+    std::size_t mascara;                                  // Tamanho do anel - 1
+    alignas(64) std::atomic<std::size_t> posicao_escrita; // Próxima posição de escrita
+    alignas(64) std::atomic<std::size_t> posicao_leitura; // Próxima posição de leitura
+};
+
+// Tipos de registro do diário do spool
+enum class TipoRegistroDiario : std::uint8_t
+{
+    Vazio = 0,       // Posição ainda não escrita
+    Enfileirado = 1, // Pedido aceito no buffer, com todos os campos
+    Retirado = 2,    // Pedido entregue a uma impressora
+    Concluido = 3    // Impressão concluída: o pedido não volta na recuperação
+};
+
+// Registro de tamanho fixo do diário. A soma de verificação é escrita por último, então um registro
+// interrompido por uma queda não confere e é ignorado na recuperação.
+struct RegistroDiario
+{
+    std::uint64_t sequencia;       // Sequência do pedido (posição do seu enfileiramento no diário + 1)
+    std::int64_t hora_solicitacao; // Contagem do system_clock desde a época
+    std::int32_t id_processo;      // Identificador do processo solicitante
+    std::int32_t id_pedido;        // Identificador do pedido no processo
+    std::int32_t num_paginas;      // Número de páginas
+    std::uint8_t tipo;             // TipoRegistroDiario
+    std::int8_t prioridade;        // Prioridade do pedido
+    std::uint16_t reservado;       // Sempre 0
+    std::uint64_t verificacao;     // Soma de verificação dos campos acima (nunca 0 em um registro escrito)
+};
+static_assert(sizeof(RegistroDiario) == 40, "o formato do diário em disco usa registros de 40 bytes");
+
+// Resultado da leitura do diário na abertura
+struct RecuperacaoDiario
+{
+    std::size_t segmentos = 0;             // Segmentos encontrados no diretório
+    std::uint64_t registros_lidos = 0;     // Registros válidos
+    std::uint64_t registros_invalidos = 0; // Registros com soma de verificação errada (escrita interrompida)
+    std::size_t pedidos_recuperados = 0;   // Pedidos enfileirados e não concluídos
+    double duracao_ms = 0.0;               // Tempo da leitura e da reconstrução da fila
+};
+
+// Diário (write-ahead log) opcional do spool: enfileiramentos, retiradas e conclusões são anexados a
+// segmentos de tamanho fixo mapeados em memória. Cada escritor reserva sua posição com um fetch_add e
+// copia o registro direto no mapeamento, sem lock. Uma thread de fundo sincroniza os segmentos com o
+// disco em grupo (msync), a cada intervalo ou a cada lote de registros, e apaga os segmentos antigos
+// sem pedidos pendentes. Os registros vão para o cache de páginas do kernel, então uma queda do processo
+// não perde nada; em uma queda do sistema, perde-se no máximo o último intervalo de sincronização.
+// Na abertura, os segmentos existentes são lidos e os pedidos enfileirados e não concluídos voltam ao
+// spool (inclusive os que estavam sendo impressos: a entrega é "pelo menos uma vez").
+class DiarioSpool
+{
+public:
+    static constexpr std::size_t REGISTROS_POR_SEGMENTO_PADRAO = std::size_t(1) << 20; // 40 MiB por segmento
+    static constexpr std::size_t MAX_SEGMENTOS_ABERTOS = 4096;                          // Segmentos vivos ao mesmo tempo
+
+    // Construtor que abre (ou cria) o diário no diretório e recupera os pedidos pendentes.
+    // intervalo_sincronizacao_ms = 0 desliga o msync e deixa a escrita em disco a cargo do kernel.
+    explicit DiarioSpool(const std::string &diretorio, int intervalo_sincronizacao_ms = 10,
+                         std::size_t registros_por_sincronizacao = 65536,
+                         std::size_t registros_por_segmento = REGISTROS_POR_SEGMENTO_PADRAO)
+        : diretorio(diretorio), intervalo_sincronizacao_ms(intervalo_sincronizacao_ms),
+          registros_por_sincronizacao(std::max<std::size_t>(1, registros_por_sincronizacao)),
+          registros_por_segmento(registros_por_segmento), segmentos(new Segmento[MAX_SEGMENTOS_ABERTOS])
+    {
+        recuperar();
+        thread_fundo = std::thread(&DiarioSpool::executar_fundo, this);
+    }
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    DiarioSpool(const DiarioSpool &) = delete;
+    DiarioSpool &operator=(const DiarioSpool &) = delete;
+
+    // Para a thread de fundo, sincroniza o que falta e fecha os segmentos (os arquivos continuam no disco)
+    ~DiarioSpool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_fundo);
+            parar = true;
+        }
+        cond_var_fundo.notify_one();
+        thread_fundo.join();
+        sincronizar();
+        for (std::uint64_t numero = primeiro_segmento; numero < fim_segmentos; ++numero)
+            fechar_segmento(numero, false);
+    }
+
+    // Anexa o enfileiramento de um pedido e retorna a sequência que o identifica no diário
+    std::uint64_t registrar_enfileirado(const Pedido &pedido)
+    {
+        RegistroDiario registro{};
+        registro.hora_solicitacao = pedido.hora_solicitacao.time_since_epoch().count();
+        registro.id_processo = pedido.id_processo;
+        registro.id_pedido = pedido.id;
+        registro.num_paginas = pedido.num_paginas;
+        registro.tipo = static_cast<std::uint8_t>(TipoRegistroDiario::Enfileirado);
+        registro.prioridade = static_cast<std::int8_t>(pedido.prioridade);
+        return anexar(registro) + 1;
+    }
+
+    // Anexa a retirada de um pedido por uma impressora
+    void registrar_retirado(const Pedido &pedido)
+    {
+        if (pedido.sequencia != 0)
+            anexar_referencia(TipoRegistroDiario::Retirado, pedido.sequencia);
+    }
+
+    // Anexa a conclusão de um pedido; o segmento do enfileiramento pode ser apagado quando não tiver mais pendentes
+    void registrar_concluido(const Pedido &pedido)
+    {
+        if (pedido.sequencia == 0)
+            return;
+        anexar_referencia(TipoRegistroDiario::Concluido, pedido.sequencia);
+        segmento((pedido.sequencia - 1) / registros_por_segmento).pendentes.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Entrega (uma única vez) os pedidos pendentes recuperados na abertura, em ordem de enfileiramento
+    std::vector<Pedido> retirar_recuperados()
+    {
+        return std::move(recuperados);
+    }
+
+    // Estatísticas da recuperação feita na abertura
+    const RecuperacaoDiario &recuperacao() const
+    {
+        return estatisticas;
+    }
+
+    // Segmentos apagados pela compactação desde a abertura
+    std::uint64_t segmentos_removidos() const
+    {
+        return removidos.load(std::memory_order_relaxed);
+    }
+
+    // Sincroniza com o disco tudo o que foi anexado até agora. Os segmentos são sincronizados desde o
+    // início a cada rodada: páginas já limpas não custam nada, e uma escrita que ainda estava em curso
+    // na rodada anterior é coberta pela seguinte.
+    void sincronizar()
+    {
+        std::lock_guard<std::mutex> lock(mutex_sincronizacao);
+        std::uint64_t fim = proxima_posicao.load(std::memory_order_acquire);
+        if (fim == 0)
+            return;
+        std::uint64_t ultimo = (fim - 1) / registros_por_segmento;
+        for (std::uint64_t numero = segmento_sincronizado; numero <= ultimo; ++numero)
+        {
+            Segmento &atual = segmento(numero);
+            RegistroDiario *base = atual.base.load(std::memory_order_acquire);
+            if (base == nullptr || atual.numero.load(std::memory_order_relaxed) != numero)
+                break; // Posição reservada em um segmento que o escritor ainda está abrindo
+            bool completo = numero < ultimo && atual.escritos.load(std::memory_order_acquire) == registros_por_segmento;
+            std::uint64_t registros = std::min<std::uint64_t>(fim - numero * registros_por_segmento, registros_por_segmento);
+            if (intervalo_sincronizacao_ms > 0)
+                sincronizar_mapeamento(base, static_cast<std::size_t>(registros) * sizeof(RegistroDiario));
+            if (completo && numero == segmento_sincronizado)
+                ++segmento_sincronizado;
+        }
+        posicao_sincronizada.store(fim, std::memory_order_relaxed);
+    }
+
+private:
+    // Estado de um segmento aberto; os segmentos ocupam um anel de MAX_SEGMENTOS_ABERTOS posições
+    struct Segmento
+    {
+        std::atomic<RegistroDiario *> base{nullptr}; // Mapeamento do arquivo (nulo quando fechado)
+        std::atomic<std::uint64_t> numero{0};        // Número do segmento que ocupa a posição do anel
+        std::atomic<std::uint64_t> escritos{0};      // Registros já copiados para o segmento
+        std::atomic<std::int64_t> pendentes{0};      // Enfileiramentos do segmento ainda não concluídos
+        int descritor = -1;                          // Arquivo do segmento
+    };
+
+    std::string diretorio;                                     // Diretório dos segmentos
+    int intervalo_sincronizacao_ms;                            // Intervalo entre sincronizações (0 = sem msync)
+    std::size_t registros_por_sincronizacao;                   // Registros que antecipam a sincronização
+    std::size_t registros_por_segmento;                        // Registros por arquivo de segmento
+    std::unique_ptr<Segmento[]> segmentos;                     // Anel de segmentos abertos
+    alignas(64) std::atomic<std::uint64_t> proxima_posicao{0}; // Próxima posição livre do diário
+    alignas(64) std::atomic<std::uint64_t> posicao_sincronizada{0}; // Fim do diário na última sincronização
+    std::atomic<bool> sincronizacao_pedida{false};             // Um escritor completou um lote de registros
+    std::mutex mutex_segmentos;                                // Abertura e fechamento de segmentos
+    std::uint64_t fim_segmentos = 0;                           // Maior segmento aberto + 1
+    std::mutex mutex_sincronizacao;                            // Sincronização e compactação
+    std::uint64_t segmento_sincronizado = 0;                   // Primeiro segmento ainda não completo e sincronizado
+    std::uint64_t primeiro_segmento = 0;                       // Segmento mais antigo ainda no disco
+    std::atomic<std::uint64_t> removidos{0};                   // Segmentos apagados pela compactação
+    std::vector<Pedido> recuperados;                           // Pedidos pendentes lidos na abertura
+    RecuperacaoDiario estatisticas;                            // Resultado da recuperação
+    std::mutex mutex_fundo;                                    // Protege parar
+    std::condition_variable cond_var_fundo;                    // Acorda a thread de fundo
+    bool parar = false;                                        // Pede o fim da thread de fundo
+    std::thread thread_fundo;                                  // Sincronização e compactação
+
+    Segmento &segmento(std::uint64_t numero)
+    {
+        return segmentos[numero % MAX_SEGMENTOS_ABERTOS];
+    }
+
+    std::size_t bytes_segmento() const
+    {
+        return registros_por_segmento * sizeof(RegistroDiario);
+    }
+
+    std::string caminho_segmento(std::uint64_t numero) const
+    {
+        char nome[48];
+        std::snprintf(nome, sizeof(nome), "segmento_%016llu.diario", static_cast<unsigned long long>(numero));
+        return (std::filesystem::path(diretorio) / nome).string();
+    }
+
+    // Extrai o número de um nome "segmento_<número>.diario"
+    static bool ler_numero_segmento(const std::string &nome, std::uint64_t &numero)
+    {
+        const std::string prefixo = "segmento_";
+        const std::string sufixo = ".diario";
+        if (nome.size() <= prefixo.size() + sufixo.size() || nome.compare(0, prefixo.size(), prefixo) != 0 ||
+            nome.compare(nome.size() - sufixo.size(), sufixo.size(), sufixo) != 0)
+            return false;
+        const char *fim = nome.data() + nome.size() - sufixo.size();
+        auto [lido, erro] = std::from_chars(nome.data() + prefixo.size(), fim, numero);
+        return erro == std::errc() && lido == fim;
+    }
+
+    // Soma de verificação dos 32 bytes de dados do registro (mistura no estilo splitmix64)
+    static std::uint64_t calcular_verificacao(const RegistroDiario &registro)
+    {
+        std::uint64_t palavras[offsetof(RegistroDiario, verificacao) / sizeof(std::uint64_t)];
+        std::memcpy(palavras, &registro, sizeof(palavras));
+        std::uint64_t soma = 0x9E3779B97F4A7C15ull;
+        for (std::uint64_t palavra : palavras)
+        {
+            soma = (soma ^ palavra) * 0xBF58476D1CE4E5B9ull;
+            soma ^= soma >> 31;
+        }
+        return soma | 1; // 0 marca uma posição não escrita
+    }
+
+    // Anexa um registro que referencia a sequência de um pedido já enfileirado
+    void anexar_referencia(TipoRegistroDiario tipo, std::uint64_t sequencia)
+    {
+        RegistroDiario registro{};
+        registro.sequencia = sequencia;
+        registro.tipo = static_cast<std::uint8_t>(tipo);
+        anexar(registro);
+    }
+
+    // Reserva a próxima posição e copia o registro para o segmento mapeado. Retorna a posição.
+    std::uint64_t anexar(RegistroDiario &registro)
+    {
+        std::uint64_t posicao = proxima_posicao.fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t numero = posicao / registros_por_segmento;
+        Segmento &destino = segmento(numero);
+        RegistroDiario *base = destino.base.load(std::memory_order_acquire);
+        if (base == nullptr || destino.numero.load(std::memory_order_relaxed) != numero)
+            base = abrir_segmento(numero);
+
+        if (registro.tipo == static_cast<std::uint8_t>(TipoRegistroDiario::Enfileirado))
+        {
+            registro.sequencia = posicao + 1;
+            destino.pendentes.fetch_add(1, std::memory_order_relaxed);
+        }
+        RegistroDiario &celula = base[posicao % registros_por_segmento];
+        std::memcpy(&celula, &registro, offsetof(RegistroDiario, verificacao));
+        // A soma de verificação é escrita depois dos dados: um registro parcial nunca parece completo
+        std::atomic_signal_fence(std::memory_order_release);
+        celula.verificacao = calcular_verificacao(registro);
+        destino.escritos.fetch_add(1, std::memory_order_release);
+
+        // Antecipa a sincronização quando um lote de registros se acumula
+        if (posicao + 1 >= posicao_sincronizada.load(std::memory_order_relaxed) + registros_por_sincronizacao &&
+            !sincronizacao_pedida.exchange(true, std::memory_order_relaxed))
+            cond_var_fundo.notify_one();
+        return posicao;
+    }
+
+    // Abre (criando o arquivo) o segmento, se outro escritor ainda não o abriu
+    RegistroDiario *abrir_segmento(std::uint64_t numero)
+    {
+        std::lock_guard<std::mutex> lock(mutex_segmentos);
+        Segmento &destino = segmento(numero);
+        RegistroDiario *base = destino.base.load(std::memory_order_relaxed);
+        if (base != nullptr)
+        {
+            if (destino.numero.load(std::memory_order_relaxed) == numero)
+                return base;
+            throw std::runtime_error("diário: segmentos demais com pedidos pendentes em '" + diretorio + "'");
+        }
+        base = mapear_segmento(caminho_segmento(numero), true, destino.descritor);
+        destino.escritos.store(0, std::memory_order_relaxed);
+        destino.pendentes.store(0, std::memory_order_relaxed);
+        destino.numero.store(numero, std::memory_order_relaxed);
+        destino.base.store(base, std::memory_order_release);
+        fim_segmentos = std::max(fim_segmentos, numero + 1);
+        return base;
+    }
+
+    // Fecha o segmento e, opcionalmente, apaga o arquivo
+    void fechar_segmento(std::uint64_t numero, bool apagar)
+    {
+        std::lock_guard<std::mutex> lock(mutex_segmentos);
+        Segmento &alvo = segmento(numero);
+        if (alvo.numero.load(std::memory_order_relaxed) == numero)
+        {
+            RegistroDiario *base = alvo.base.exchange(nullptr, std::memory_order_acq_rel);
+            if (base != nullptr)
+                desmapear_segmento(base, alvo.descritor);
+        }
+        if (apagar)
+        {
+            std::error_code erro;
+            std::filesystem::remove(caminho_segmento(numero), erro);
+        }
+    }
+
+    // Mapeia o arquivo de um segmento para leitura e escrita
+    RegistroDiario *mapear_segmento(const std::string &caminho, bool criar, int &descritor)
+    {
+#ifdef _WIN32
+        (void)caminho;
+        (void)criar;
+        (void)descritor;
+        throw std::runtime_error("o diário do spool requer mmap (sistemas POSIX)");
+#else
+        int arquivo = ::open(caminho.c_str(), O_RDWR | (criar ? O_CREAT : 0), 0644);
+        if (arquivo < 0)
+            throw std::runtime_error("diário: não foi possível abrir '" + caminho + "'");
+        if (criar && ::ftruncate(arquivo, static_cast<off_t>(bytes_segmento())) != 0)
+        {
+            ::close(arquivo);
+            throw std::runtime_error("diário: não foi possível reservar '" + caminho + "'");
+        }
+        void *mapa = ::mmap(nullptr, bytes_segmento(), PROT_READ | PROT_WRITE, MAP_SHARED, arquivo, 0);
+        if (mapa == MAP_FAILED)
+        {
+            ::close(arquivo);
+            throw std::runtime_error("diário: não foi possível mapear '" + caminho + "'");
+        }
+        descritor = arquivo;
+        return static_cast<RegistroDiario *>(mapa);
+#endif
+    }
+
+    void desmapear_segmento([[maybe_unused]] RegistroDiario *base, int &descritor)
+    {
+#ifndef _WIN32
+        ::munmap(base, bytes_segmento());
+        ::close(descritor);
+#endif
+        descritor = -1;
+    }
+
+    void sincronizar_mapeamento([[maybe_unused]] RegistroDiario *base, [[maybe_unused]] std::size_t bytes)
+    {
+#ifndef _WIN32
+        ::msync(base, bytes, MS_SYNC);
+#endif
+    }
+
+    // Apaga, do mais antigo em diante, os segmentos completos, sincronizados e sem pedidos pendentes.
+    // Só o prefixo é apagado: as conclusões de um segmento referenciam enfileiramentos anteriores a ele.
+    void compactar()
+    {
+        std::lock_guard<std::mutex> lock(mutex_sincronizacao);
+        while (primeiro_segmento < segmento_sincronizado)
+        {
+            Segmento &antigo = segmento(primeiro_segmento);
+            if (antigo.base.load(std::memory_order_acquire) != nullptr &&
+                antigo.numero.load(std::memory_order_relaxed) == primeiro_segmento &&
+                antigo.pendentes.load(std::memory_order_acquire) > 0)
+                break;
+            fechar_segmento(primeiro_segmento, true);
+            ++primeiro_segmento;
+            removidos.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Abre o próximo segmento antes que um escritor precise dele
+    void preparar_proximo_segmento()
+    {
+        std::uint64_t proximo = proxima_posicao.load(std::memory_order_relaxed) / registros_por_segmento + 1;
+        Segmento &destino = segmento(proximo);
+        if (destino.base.load(std::memory_order_acquire) != nullptr)
+            return; // Já aberto, ou o anel está ocupado por um segmento com pendentes
+        try
+        {
+            abrir_segmento(proximo);
+        }
+        catch (const std::runtime_error &)
+        {
+            // O escritor que chegar ao segmento tenta de novo e relata o erro
+        }
+    }
+
+    // Thread de fundo: commit em grupo a cada intervalo (ou lote de registros) e compactação
+    void executar_fundo()
+    {
+        auto periodo = std::chrono::milliseconds(intervalo_sincronizacao_ms > 0 ? intervalo_sincronizacao_ms : 100);
+        std::unique_lock<std::mutex> lock(mutex_fundo);
+        while (!parar)
+        {
+            cond_var_fundo.wait_for(lock, periodo, [this]()
+                                    { return parar || sincronizacao_pedida.load(std::memory_order_relaxed); });
+            sincronizacao_pedida.store(false, std::memory_order_relaxed);
+            lock.unlock();
+            sincronizar();
+            compactar();
+            preparar_proximo_segmento();
+            lock.lock();
+        }
+    }
+
+    // Lê os segmentos do diretório e reconstrói os pedidos pendentes: enfileirados menos concluídos.
+    // As sequências são posições no diário, então as conclusões são marcadas em um vetor de bits.
+    void recuperar()
+    {
+        auto inicio = std::chrono::steady_clock::now();
+        std::filesystem::create_directories(diretorio);
+
+        std::vector<std::uint64_t> numeros;
+        for (const auto &entrada : std::filesystem::directory_iterator(diretorio))
+        {
+            std::uint64_t numero;
+            if (ler_numero_segmento(entrada.path().filename().string(), numero))
+                numeros.push_back(numero);
+        }
+        std::sort(numeros.begin(), numeros.end());
+        if (!numeros.empty() && numeros.back() - numeros.front() >= MAX_SEGMENTOS_ABERTOS)
+            throw std::runtime_error("diário: segmentos demais em '" + diretorio + "'");
+
+        std::vector<const RegistroDiario *> enfileirados; // Apontam para os mapeamentos, que seguem abertos
+        std::vector<std::uint64_t> concluidos;
+        std::uint64_t fim = numeros.empty() ? 0 : numeros.front() * registros_por_segmento;
+        for (std::uint64_t numero : numeros)
+        {
+            std::string caminho = caminho_segmento(numero);
+            if (std::filesystem::file_size(caminho) != bytes_segmento())
+                throw std::runtime_error("diário: segmento com tamanho inesperado: '" + caminho + "'");
+            Segmento &destino = segmento(numero);
+            const RegistroDiario *registros = mapear_segmento(caminho, false, destino.descritor);
+            destino.escritos.store(registros_por_segmento, std::memory_order_relaxed);
+            destino.numero.store(numero, std::memory_order_relaxed);
+            destino.base.store(const_cast<RegistroDiario *>(registros), std::memory_order_relaxed);
+
+            for (std::size_t i = 0; i < registros_por_segmento; ++i)
+            {
+                const RegistroDiario &registro = registros[i];
+                if (registro.verificacao == 0)
+                    continue; // Posição não escrita
+                if (registro.verificacao != calcular_verificacao(registro))
+                {
+                    ++estatisticas.registros_invalidos;
+                    continue;
+                }
+                ++estatisticas.registros_lidos;
+                fim = numero * registros_por_segmento + i + 1;
+                if (registro.tipo == static_cast<std::uint8_t>(TipoRegistroDiario::Enfileirado))
+                    enfileirados.push_back(&registro);
+                else if (registro.tipo == static_cast<std::uint8_t>(TipoRegistroDiario::Concluido))
+                    concluidos.push_back(registro.sequencia);
+            }
+        }
+
+        // A escrita continua logo depois do último registro válido
+        std::uint64_t atual = fim / registros_por_segmento;
+        for (std::uint64_t numero : numeros)
+        {
+            if (numero >= atual)
+                segmento(numero).escritos.store(numero == atual ? fim - numero * registros_por_segmento : 0,
+                                                std::memory_order_relaxed);
+        }
+
+        if (!enfileirados.empty())
+        {
+            std::uint64_t menor = enfileirados.front()->sequencia;
+            std::vector<bool> concluido(fim + 1 - menor, false);
+            for (std::uint64_t sequencia : concluidos)
+            {
+                if (sequencia >= menor && sequencia <= fim)
+                    concluido[sequencia - menor] = true;
+            }
+            for (const RegistroDiario *registro : enfileirados)
+            {
+                if (concluido[registro->sequencia - menor])
+                    continue;
+                Pedido pedido;
+                pedido.id = registro->id_pedido;
+                pedido.num_paginas = registro->num_paginas;
+                pedido.prioridade = registro->prioridade;
+                pedido.id_processo = registro->id_processo;
+                pedido.hora_solicitacao = std::chrono::system_clock::time_point(
+                    std::chrono::system_clock::duration(registro->hora_solicitacao));
+                pedido.sequencia = registro->sequencia;
+                recuperados.push_back(std::move(pedido));
+                segmento((registro->sequencia - 1) / registros_por_segmento).pendentes.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        proxima_posicao.store(fim, std::memory_order_relaxed);
+        posicao_sincronizada.store(fim, std::memory_order_relaxed);
+        primeiro_segmento = numeros.empty() ? atual : numeros.front();
+        segmento_sincronizado = atual; // Os segmentos anteriores estão completos e já estavam no disco
+        fim_segmentos = numeros.empty() ? atual : numeros.back() + 1;
+
+        estatisticas.segmentos = numeros.size();
+        estatisticas.pedidos_recuperados = recuperados.size();
+        estatisticas.duracao_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count();
+    }
+};
+
+// Tarefa do executor que fica estacionada no spool (ou em um temporizador) em vez de bloquear uma thread.
+// acordar() pode ser chamado de qualquer thread; executar() roda a tarefa até ela precisar esperar de novo.
+class TarefaRetomavel
+{
+public:
+    virtual ~TarefaRetomavel() = default;
+    virtual void acordar() = 0;
+    virtual void executar() = 0;
+};
+
+// Política de admissão para um pedido que chega com o buffer cheio
+enum class PoliticaAdmissao : std::uint8_t
+{
+    Bloquear = 1,                // Espera por uma vaga até o prazo e então descarta (comportamento original)
+    Rejeitar = 2,                // Descarta na hora
+    DespejarMenorPrioridade = 3, // Despeja o pedido mais antigo da menor prioridade abaixo da do novo pedido
+    DespejarMaisAntigo = 4       // Despeja o pedido mais antigo entre as prioridades abaixo da do novo pedido
+};
+
+// Parâmetros da admissão de pedidos no spool
+struct ConfiguracaoAdmissao
+{
+    PoliticaAdmissao politica = PoliticaAdmissao::Bloquear; // Política com o buffer cheio
+    int prazo_ms = 1000;                                    // Espera máxima por vaga (Bloquear e despejo sem vítima)
+    double taxa_por_processo = 0.0;                         // Pedidos/s admitidos por processo (0 = sem limite)
+    int rajada_por_processo = 1;                            // Capacidade do balde de fichas de cada processo
+};
+
+// Nome da política, como aceito na linha de comando
+const char *nome_politica(PoliticaAdmissao politica)
+{
+    switch (politica)
+    {
+    case PoliticaAdmissao::Bloquear:
+        return "bloquear";
+    case PoliticaAdmissao::Rejeitar:
+        return "rejeitar";
+    case PoliticaAdmissao::DespejarMenorPrioridade:
+        return "despejar-menor-prioridade";
+    case PoliticaAdmissao::DespejarMaisAntigo:
+        return "despejar-mais-antigo";
+    }
+    return "";
+}
+
+// Totais de admissão de uma execução
+struct ResumoAdmissao
+{
+    std::uint64_t aceitos = 0;    // Pedidos colocados no buffer
+    std::uint64_t rejeitados = 0; // Pedidos descartados por falta de vaga
+    std::uint64_t limitados = 0;  // Pedidos recusados pelo limite de taxa do processo
+    std::uint64_t despejados = 0; // Pedidos tirados do buffer para dar lugar a outros mais prioritários
+};
+
+// Contadores de admissão, atualizados pelos produtores (uma vez por lote)
+struct ContadoresAdmissao
+{
+    std::atomic<std::uint64_t> aceitos{0};    // Pedidos colocados no buffer
+    std::atomic<std::uint64_t> rejeitados{0}; // Pedidos descartados por falta de vaga
+    std::atomic<std::uint64_t> limitados{0};  // Pedidos recusados pelo limite de taxa do processo
+    std::atomic<std::uint64_t> despejados{0}; // Pedidos tirados do buffer para dar lugar a outros mais prioritários
+
+    ResumoAdmissao ler() const
+    {
+        return ResumoAdmissao{aceitos.load(), rejeitados.load(), limitados.load(), despejados.load()};
+    }
+};
+
+// Balde de fichas (token bucket) de um processo: recebe taxa fichas por segundo, até a rajada,
+// e cada pedido admitido consome uma ficha
+struct BaldeFichas
+{
+    double fichas;              // Fichas disponíveis
+    std::int64_t atualizado_us; // Instante da última recarga
+
+    bool consumir(std::int64_t agora_us, double taxa, int rajada)
+    {
+        fichas = std::min(static_cast<double>(rajada), fichas + (agora_us - atualizado_us) * taxa / 1e6);
+        atualizado_us = agora_us;
+        if (fichas < 1.0)
+            return false;
+        fichas -= 1.0;
+        return true;
+    }
+};
+
+// Escalonamento anti-inanição da fila com mutex. Com envelhecimento, cada envelhecimento_ms de espera
+// vale um nível a mais de prioridade; com espera máxima, um pedido que já consumiu 3/4 do limite da sua
+// prioridade passa à frente (o quarto restante cobre a impressão em curso nas impressoras ocupadas).
+struct ConfiguracaoEscalonamento
+{
+    int envelhecimento_ms = 0;                           // Espera que vale um nível de prioridade (0 = estática)
+    std::array<int, NUM_PRIORIDADES> espera_maxima_ms{}; // Limite de espera por prioridade, 1 a 5 (0 = sem limite)
+
+    // Indica se a ordem depende do tempo de espera
+    bool dinamico() const
+    {
+        if (envelhecimento_ms > 0)
+            return true;
+        for (int limite : espera_maxima_ms)
+        {
+            if (limite > 0)
+                return true;
+        }
+        return false;
+    }
+};
+
+// FIFO em anel que dobra de tamanho quando enche e nunca encolhe. Depois de atingir a ocupação
+// máxima, inserir e retirar não alocam; a std::deque, ao contrário, libera e aloca um bloco novo
+// a cada poucos elementos que atravessam a fila.
+template <typename T>
+class FilaCircular
+{
+public:
+    FilaCircular() = default;
+
+    bool vazia() const
+    {
+        return quantidade == 0;
+    }
+
+    std::size_t tamanho() const
+    {
+        return quantidade;
+    }
+
+    // Elemento mais antigo (a fila não pode estar vazia)
+    T &frente()
+    {
+        return celulas[inicio];
+    }
+
+    const T &frente() const
+    {
+        return celulas[inicio];
+    }
+
+    void inserir(T valor)
+    {
+        if (quantidade == capacidade)
+            crescer();
+        celulas[(inicio + quantidade) & (capacidade - 1)] = std::move(valor);
+        ++quantidade;
+    }
+
+    // Remove o elemento mais antigo (a fila não pode estar vazia)
+    void retirar_frente()
+    {
+        inicio = (inicio + 1) & (capacidade - 1);
+        --quantidade;
+    }
+
+    // Garante espaço para ao menos minimo elementos sem novas alocações
+    void reservar(std::size_t minimo)
+    {
+        while (capacidade < minimo)
+            crescer();
+    }
+
+private:
+    static constexpr std::size_t CAPACIDADE_INICIAL = 16; // Potência de 2
+
+    std::unique_ptr<T[]> celulas; // Células do anel
+    std::size_t capacidade = 0;   // Tamanho do anel (potência de 2)
+    std::size_t inicio = 0;       // Posição do elemento mais antigo
+    std::size_t quantidade = 0;   // Elementos na fila
+
+    // Dobra o anel, copiando os elementos em ordem para o início
+    void crescer()
+    {
+        std::size_t nova_capacidade = capacidade == 0 ? CAPACIDADE_INICIAL : 2 * capacidade;
+        std::unique_ptr<T[]> novas(new T[nova_capacidade]);
+        for (std::size_t i = 0; i < quantidade; ++i)
+            novas[i] = std::move(celulas[(inicio + i) & (capacidade - 1)]);
+        celulas = std::move(novas);
+        capacidade = nova_capacidade;
+        inicio = 0;
+    }
+};
+
+// Fila do backend com mutex: uma fila FIFO por nível de prioridade. Retira do nível mais alto não vazio
+// e, ao contrário da std::priority_queue, permite despejar pedidos dos níveis mais baixos.
+// No escalonamento dinâmico, o primeiro de cada FIFO é o que mais esperou no seu nível, então basta
+// comparar os NUM_PRIORIDADES primeiros: a retirada custa O(1) com qualquer quantidade de pedidos,
+// sem reordenar a fila à medida que os pedidos envelhecem.
+// Com ordenação por tamanho, cada nível agrupa os pedidos por número de páginas (FIFO dentro do grupo,
+// encadeado em um reservatório de nós), em um vetor ordenado por páginas: topo() devolve o menor ou o
+// maior pedido do nível mais alto em O(1), e inserir custa O(log k) mais o deslocamento de grupos
+// quando surge um tamanho novo (k = tamanhos distintos no nível).
+// Com reservar(), nenhum dos dois modos aloca memória por pedido enquanto a ocupação não passa da capacidade.
+class FilaPrioridades
+{
+public:
+    explicit FilaPrioridades(const ConfiguracaoEscalonamento &escalonamento = ConfiguracaoEscalonamento(),
+                             bool ordenar_por_tamanho = false)
+        : configuracao(escalonamento), dinamica(escalonamento.dinamico()), por_tamanho(ordenar_por_tamanho)
+    {
+    }
+
+    // Indica se topo() precisa do instante atual
+    bool escalonamento_dinamico() const
+    {
+        return dinamica;
+    }
+
+    // Reserva espaço para a ocupação máxima: cada FIFO de prioridade ou, com ordenação por tamanho, o
+    // reservatório de nós e os grupos de cada nível (no máximo um grupo por pedido)
+    void reservar(std::size_t capacidade)
+    {
+        if (por_tamanho)
+        {
+            reservatorio.reserve(capacidade);
+            for (auto &grupos_nivel : grupos)
+                grupos_nivel.reserve(capacidade);
+            return;
+        }
+        for (auto &fila : filas)
+            fila.reservar(capacidade);
+    }
+
+    bool vazia() const
+    {
+        return quantidade == 0;
+    }
+
+    std::size_t tamanho() const
+    {
+        return quantidade;
+    }
+
+    void inserir(Pedido pedido)
+    {
+        int nivel = indice_prioridade(pedido.prioridade);
+        if (por_tamanho)
+            inserir_no_grupo(nivel, std::move(pedido));
+        else
+            filas[nivel].inserir(std::move(pedido));
+        ++quantidade;
+    }
+
+    // Próximo pedido a imprimir (a fila não pode estar vazia): o mais antigo da maior prioridade ou, no
+    // escalonamento dinâmico, da maior prioridade efetiva no instante agora. Com ordenação por tamanho,
+    // o menor (ou, com maior_primeiro, o maior) pedido da maior prioridade.
+    Pedido &topo(std::chrono::system_clock::time_point agora = std::chrono::system_clock::time_point(),
+                 bool maior_primeiro = false)
+    {
+        if (por_tamanho)
+        {
+            nivel_topo = nivel_mais_alto();
+            grupo_topo = maior_primeiro ? grupos[nivel_topo].size() - 1 : 0;
+            return reservatorio[grupos[nivel_topo][grupo_topo].primeiro].pedido;
+        }
+        nivel_topo = dinamica ? nivel_escalonado(agora) : nivel_mais_alto();
+        return filas[nivel_topo].frente();
+    }
+
+    // Remove o pedido devolvido pela última chamada a topo()
+    void remover_topo()
+    {
+        if (por_tamanho)
+            remover_do_grupo(nivel_topo, grupo_topo);
+        else
+            filas[nivel_topo].retirar_frente();
+        --quantidade;
+    }
+
+    // Maior prioridade presente na fila (0 quando vazia)
+    int prioridade_mais_alta() const
+    {
+        return vazia() ? 0 : nivel_mais_alto() + PRIORIDADE_MINIMA;
+    }
+
+    // Menor prioridade presente na fila (0 quando vazia)
+    int prioridade_mais_baixa() const
+    {
+        for (int i = 0; i < NUM_PRIORIDADES; ++i)
+        {
+            if (!nivel_vazio(i))
+                return i + PRIORIDADE_MINIMA;
+        }
+        return 0;
+    }
+
+    // Retira um pedido de prioridade menor que a informada: o mais antigo do nível mais baixo, ou
+    // (mais_antigo) o de solicitação mais antiga entre os níveis abaixo. Com ordenação por tamanho,
+    // o maior pedido do nível mais baixo ou (mais_antigo) o mais antigo entre os primeiros dos grupos
+    // dos níveis abaixo, já que cada grupo é um FIFO. Retorna false sem vítima.
+    bool despejar(int prioridade, bool mais_antigo, Pedido &vitima)
+    {
+        if (por_tamanho)
+        {
+            int nivel = prioridade_mais_baixa() - PRIORIDADE_MINIMA;
+            if (nivel < 0 || nivel >= indice_prioridade(prioridade))
+                return false;
+            std::size_t grupo = grupos[nivel].size() - 1;
+            if (mais_antigo)
+            {
+                for (int i = nivel; i < indice_prioridade(prioridade); ++i)
+                {
+                    for (std::size_t g = 0; g < grupos[i].size(); ++g)
+                    {
+                        if (reservatorio[grupos[i][g].primeiro].pedido.hora_solicitacao <
+                            reservatorio[grupos[nivel][grupo].primeiro].pedido.hora_solicitacao)
+                        {
+                            nivel = i;
+                            grupo = g;
+                        }
+                    }
+                }
+            }
+            vitima = std::move(reservatorio[grupos[nivel][grupo].primeiro].pedido);
+            remover_do_grupo(nivel, grupo);
+            --quantidade;
+            return true;
+        }
+
+        int escolhido = -1;
+        for (int i = 0; i < indice_prioridade(prioridade); ++i)
+        {
+            if (filas[i].vazia())
+                continue;
+            if (escolhido < 0 || (mais_antigo && filas[i].frente().hora_solicitacao < filas[escolhido].frente().hora_solicitacao))
+                escolhido = i;
+            if (!mais_antigo)
+                break;
+        }
+        if (escolhido < 0)
+            return false;
+        vitima = std::move(filas[escolhido].frente());
+        filas[escolhido].retirar_frente();
+        --quantidade;
+        return true;
+    }
+
+private:
+    // Pedido agrupado por tamanho, encadeado ao seguinte do mesmo grupo (ou da lista de nós livres)
+    struct NoGrupo
+    {
+        Pedido pedido;   // Pedido guardado
+        int proximo;     // Índice do próximo nó (-1 no último)
+    };
+
+    // Pedidos de um nível com o mesmo número de páginas, do mais antigo ao mais novo
+    struct Grupo
+    {
+        int paginas;     // Número de páginas dos pedidos do grupo
+        int primeiro;    // Nó do pedido mais antigo
+        int ultimo;      // Nó do pedido mais novo
+    };
+
+    std::array<FilaCircular<Pedido>, NUM_PRIORIDADES> filas; // Um FIFO por prioridade
+    std::size_t quantidade = 0;                            // Pedidos em todos os níveis
+    ConfiguracaoEscalonamento configuracao;                // Envelhecimento e limites de espera
+    bool dinamica;                                         // A ordem depende do tempo de espera
+    bool por_tamanho;                                      // Ordena cada nível pelo número de páginas
+    std::array<std::vector<Grupo>, NUM_PRIORIDADES> grupos; // Por nível: grupos ordenados por páginas
+    std::vector<NoGrupo> reservatorio;                     // Nós dos pedidos agrupados
+    int nos_livres = -1;                                   // Primeiro nó livre do reservatório (-1 = nenhum)
+    int nivel_topo = 0;                                    // Nível escolhido pela última chamada a topo()
+    std::size_t grupo_topo = 0;                            // Grupo escolhido pela última chamada a topo()
+
+    bool nivel_vazio(int nivel) const
+    {
+        return por_tamanho ? grupos[nivel].empty() : filas[nivel].vazia();
+    }
+
+    int nivel_mais_alto() const
+    {
+        int i = NUM_PRIORIDADES - 1;
+        while (i > 0 && nivel_vazio(i))
+            --i;
+        return i;
+    }
+
+    // Acrescenta o pedido ao fim do grupo do seu tamanho, criando o grupo na posição ordenada
+    void inserir_no_grupo(int nivel, Pedido pedido)
+    {
+        int no = nos_livres;
+        if (no >= 0)
+        {
+            nos_livres = reservatorio[no].proximo;
+        }
+        else
+        {
+            no = static_cast<int>(reservatorio.size());
+            reservatorio.emplace_back();
+        }
+        reservatorio[no].pedido = std::move(pedido);
+        reservatorio[no].proximo = -1;
+
+        int paginas = reservatorio[no].pedido.num_paginas;
+        std::vector<Grupo> &grupos_nivel = grupos[nivel];
+        auto grupo = std::lower_bound(grupos_nivel.begin(), grupos_nivel.end(), paginas,
+                                      [](const Grupo &g, int p)
+                                      { return g.paginas < p; });
+        if (grupo == grupos_nivel.end() || grupo->paginas != paginas)
+        {
+            grupos_nivel.insert(grupo, Grupo{paginas, no, no});
+            return;
+        }
+        reservatorio[grupo->ultimo].proximo = no;
+        grupo->ultimo = no;
+    }
+
+    // Tira o primeiro pedido de um grupo, devolvendo o nó à lista de livres; o grupo que esvazia sai do nível
+    void remover_do_grupo(int nivel, std::size_t indice)
+    {
+        Grupo &grupo = grupos[nivel][indice];
+        int no = grupo.primeiro;
+        grupo.primeiro = reservatorio[no].proximo;
+        reservatorio[no].proximo = nos_livres;
+        nos_livres = no;
+        if (grupo.primeiro < 0)
+            grupos[nivel].erase(grupos[nivel].begin() + static_cast<std::ptrdiff_t>(indice));
+    }
+
+    // Entre os primeiros de cada nível: o de prazo mais próximo entre os que passaram de 3/4 do limite
+    // de espera; senão, o de maior prioridade efetiva (nível + espera / envelhecimento), com empate
+    // resolvido pelo nível mais alto
+    int nivel_escalonado(std::chrono::system_clock::time_point agora) const
+    {
+        int urgente = -1;
+        std::chrono::system_clock::time_point prazo_urgente;
+        int escolhido = -1;
+        std::int64_t maior_efetiva = 0;
+        for (int i = NUM_PRIORIDADES - 1; i >= 0; --i)
+        {
+            if (filas[i].vazia())
+                continue;
+            std::chrono::system_clock::time_point solicitacao = filas[i].frente().hora_solicitacao;
+            std::int64_t espera_ms = std::chrono::duration_cast<std::chrono::milliseconds>(agora - solicitacao).count();
+
+            int limite_ms = configuracao.espera_maxima_ms[i];
+            if (limite_ms > 0 && 4 * espera_ms >= 3LL * limite_ms)
+            {
+                auto prazo = solicitacao + std::chrono::milliseconds(limite_ms);
+                if (urgente < 0 || prazo < prazo_urgente)
+                {
+                    urgente = i;
+                    prazo_urgente = prazo;
+                }
+            }
+
+            std::int64_t efetiva = i;
+            if (configuracao.envelhecimento_ms > 0 && espera_ms > 0)
+                efetiva += espera_ms / configuracao.envelhecimento_ms;
+            if (escolhido < 0 || efetiva > maior_efetiva)
+            {
+                escolhido = i;
+                maior_efetiva = efetiva;
+            }
+        }
+        return urgente >= 0 ? urgente : escolhido;
+    }
+};
+
+// Como os pedidos são distribuídos entre impressoras de velocidades diferentes
+enum class PoliticaDespacho : std::uint8_t
+{
+    Compartilhada = 1, // Uma fila para todas, na ordem de chegada dentro da prioridade (comportamento original)
+    MenorPrimeiro = 2, // Uma fila para todas, menor pedido primeiro dentro da prioridade
+    PorTamanho = 3,    // Uma fila para todas; as impressoras mais rápidas pegam o maior pedido, as demais o menor
+    FilasLocais = 4    // Uma fila por impressora, escolhida pelo menor término estimado, com roubo entre filas
+};
+
+// Nome da política de despacho, como aceito na linha de comando
+const char *nome_despacho(PoliticaDespacho politica)
+{
+    switch (politica)
+    {
+    case PoliticaDespacho::Compartilhada:
+        return "compartilhada";
+    case PoliticaDespacho::MenorPrimeiro:
+        return "menor-primeiro";
+    case PoliticaDespacho::PorTamanho:
+        return "por-tamanho";
+    case PoliticaDespacho::FilasLocais:
+        return "filas-locais";
+    }
+    return "";
+}
+
+// Parâmetros do despacho de pedidos às impressoras
+struct ConfiguracaoDespacho
+{
+    PoliticaDespacho politica = PoliticaDespacho::Compartilhada; // Política de despacho
+    std::vector<int> tempos_por_pagina_ms;                       // Tempo por página de cada impressora (1..N)
+    int paginas_por_parte = 0;                                   // Documentos maiores saem em partes deste tamanho (0 = inteiros)
+    int prioridade_preempcao = 0;                                // Pedidos desta prioridade ou maior interrompem impressões
+                                                                 // menos prioritárias (0 = sem preempção)
+    int prazo_drenagem_ms = -1;                                  // Prazo para esvaziar o buffer no encerramento (-1 = sem prazo)
+    bool cancelamento = false;                                   // Acompanha as chaves na fila para Spool::cancelar_pedido
+};
+
+// Identifica um pedido pelo processo e pelo identificador no processo
+std::uint64_t chave_pedido(int id_processo, int id_pedido)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(id_processo)) << 32) |
+           static_cast<std::uint32_t>(id_pedido);
+}
+
+// Chaves dos pedidos na fila (chave_pedido), em uma tabela de endereçamento aberto com sondagem linear:
+// conta, por chave, os pedidos na fila e as marcas de cancelamento ainda não aplicadas. Com reservar(),
+// não aloca memória por pedido enquanto a ocupação não passa da capacidade (a tabela só cresce além dela).
+class ChavesNaFila
+{
+public:
+    // Reserva entradas para capacidade chaves distintas, com ocupação de no máximo metade da tabela
+    void reservar(std::size_t capacidade)
+    {
+        std::size_t tamanho = 16;
+        while (tamanho < 2 * capacidade)
+            tamanho *= 2;
+        if (tamanho > entradas.size())
+            redimensionar(tamanho);
+    }
+
+    // Conta um pedido com a chave na fila
+    void inserir(std::uint64_t chave)
+    {
+        if (2 * (ocupadas + 1) > entradas.size())
+            redimensionar(std::max<std::size_t>(16, 2 * entradas.size()));
+        Entrada &entrada = entradas[posicao(chave)];
+        if (entrada.na_fila == 0)
+        {
+            entrada.chave = chave;
+            ++ocupadas;
+        }
+        ++entrada.na_fila;
+    }
+
+    // Desconta um pedido com a chave que saiu da fila; as marcas ficam limitadas aos pedidos restantes
+    void remover(std::uint64_t chave)
+    {
+        std::size_t indice = posicao(chave);
+        Entrada &entrada = entradas[indice];
+        if (entrada.na_fila == 0)
+            return;
+        --entrada.na_fila;
+        if (entrada.marcados > entrada.na_fila)
+        {
+            total_marcados -= entrada.marcados - entrada.na_fila;
+            entrada.marcados = entrada.na_fila;
+        }
+        if (entrada.na_fila == 0)
+            liberar(indice);
+    }
+
+    // Marca para cancelamento um pedido com a chave ainda não marcado. Retorna false se não há nenhum.
+    bool marcar(std::uint64_t chave)
+    {
+        if (entradas.empty())
+            return false;
+        Entrada &entrada = entradas[posicao(chave)];
+        if (entrada.marcados >= entrada.na_fila)
+            return false;
+        ++entrada.marcados;
+        ++total_marcados;
+        return true;
+    }
+
+    // Consome uma marca da chave, se houver (o pedido sai da fila como cancelado)
+    bool consumir_marca(std::uint64_t chave)
+    {
+        if (total_marcados == 0)
+            return false;
+        Entrada &entrada = entradas[posicao(chave)];
+        if (entrada.marcados == 0)
+            return false;
+        --entrada.marcados;
+        --total_marcados;
+        return true;
+    }
+
+    // Indica se há marcas de cancelamento pendentes
+    bool ha_marcas() const
+    {
+        return total_marcados > 0;
+    }
+
+private:
+    // Entrada da tabela; vazia quando na_fila é 0
+    struct Entrada
+    {
+        std::uint64_t chave = 0;    // Chave do pedido
+        std::uint32_t na_fila = 0;  // Pedidos com a chave na fila
+        std::uint32_t marcados = 0; // Marcas de cancelamento pendentes (no máximo na_fila)
+    };
+
+    std::vector<Entrada> entradas;    // Tabela, com tamanho potência de 2
+    std::size_t ocupadas = 0;         // Entradas em uso
+    std::size_t total_marcados = 0;   // Soma das marcas pendentes
+
+    // Posição inicial da chave na tabela (hash multiplicativo)
+    std::size_t inicio(std::uint64_t chave) const
+    {
+        return static_cast<std::size_t>((chave * 0x9E3779B97F4A7C15ULL) >> 32) & (entradas.size() - 1);
+    }
+
+    // Entrada da chave ou a entrada vazia onde ela entraria
+    std::size_t posicao(std::uint64_t chave) const
+    {
+        std::size_t mascara = entradas.size() - 1;
+        std::size_t i = inicio(chave);
+        while (entradas[i].na_fila != 0 && entradas[i].chave != chave)
+            i = (i + 1) & mascara;
+        return i;
+    }
+
+    // Esvazia a entrada, trazendo para trás as chaves seguintes da sequência de sondagem
+    void liberar(std::size_t indice)
+    {
+        std::size_t mascara = entradas.size() - 1;
+        std::size_t j = indice;
+        while (true)
+        {
+            j = (j + 1) & mascara;
+            if (entradas[j].na_fila == 0)
+                break;
+            std::size_t k = inicio(entradas[j].chave);
+            if (((j - k) & mascara) < ((j - indice) & mascara))
+                continue; // A posição inicial está entre a lacuna e j: a chave fica onde está
+            entradas[indice] = entradas[j];
+            indice = j;
+        }
+        entradas[indice] = Entrada();
+        --ocupadas;
+    }
+
+    void redimensionar(std::size_t tamanho)
+    {
+        std::vector<Entrada> antigas(tamanho);
+        antigas.swap(entradas);
+        for (const Entrada &entrada : antigas)
+        {
+            if (entrada.na_fila != 0)
+                entradas[posicao(entrada.chave)] = entrada;
+        }
+    }
+};
+
+// Buffer do backend com mutex visto pelas impressoras: decide qual pedido cada impressora retira.
+// Com a política compartilhada, é só a FilaPrioridades (e a impressora não importa). Com filas locais,
+// cada pedido vai para a impressora com menor término estimado, (páginas na fila + páginas do pedido)
+// * tempo por página; a impressora retira da própria fila e rouba da fila de outra quando a sua está
+// vazia ou quando outra tem um pedido de prioridade maior, de modo que a ordem de prioridade vale entre
+// todas as filas. Com o cancelamento ativo, as chaves dos pedidos na fila são acompanhadas em uma
+// tabela; um pedido cancelado é só marcado e sai da fila quando chega ao topo (exclusão preguiçosa),
+// de modo que o cancelamento não percorre as filas e a retirada continua O(log n).
+class FilaDespacho
+{
+public:
+    FilaDespacho(const ConfiguracaoEscalonamento &escalonamento = ConfiguracaoEscalonamento(),
+                 const ConfiguracaoDespacho &despacho = ConfiguracaoDespacho())
+        : politica(despacho.politica), tempos_por_pagina(despacho.tempos_por_pagina_ms),
+          paginas_por_parte(despacho.paginas_por_parte), cancelamento(despacho.cancelamento)
+    {
+        bool por_tamanho = politica == PoliticaDespacho::MenorPrimeiro || politica == PoliticaDespacho::PorTamanho;
+        std::size_t num_filas = politica == PoliticaDespacho::FilasLocais ? std::max<std::size_t>(1, tempos_por_pagina.size()) : 1;
+        for (std::size_t i = 0; i < num_filas; ++i)
+            filas.emplace_back(escalonamento, por_tamanho);
+        paginas_fila.assign(num_filas, 0);
+
+        // Impressoras mais rápidas que a mediana pegam os maiores pedidos na política por tamanho
+        std::vector<int> ordenados = tempos_por_pagina;
+        std::sort(ordenados.begin(), ordenados.end());
+        for (int tempo : tempos_por_pagina)
+            rapida.push_back(!ordenados.empty() && tempo < ordenados[ordenados.size() / 2]);
+    }
+
+    // Indica se topo() precisa do instante atual
+    bool escalonamento_dinamico() const
+    {
+        return filas.front().escalonamento_dinamico();
+    }
+
+    // Reserva cada fila (e a tabela de chaves, com o cancelamento) para a capacidade do buffer
+    void reservar(std::size_t capacidade)
+    {
+        for (auto &fila : filas)
+            fila.reservar(capacidade);
+        if (cancelamento)
+            chaves.reservar(capacidade);
+    }
+
+    bool vazia() const
+    {
+        return quantidade == 0;
+    }
+
+    std::size_t tamanho() const
+    {
+        return quantidade;
+    }
+
+    void inserir(Pedido pedido)
+    {
+        std::size_t destino = 0;
+        if (filas.size() > 1)
+        {
+            std::int64_t menor_termino = 0;
+            for (std::size_t i = 0; i < filas.size(); ++i)
+            {
+                std::int64_t termino = termino_estimado(i) + pedido.num_paginas * std::max(1, tempos_por_pagina[i]);
+                if (i == 0 || termino < menor_termino)
+                {
+                    destino = i;
+                    menor_termino = termino;
+                }
+            }
+        }
+        paginas_fila[destino] += pedido.num_paginas;
+        if (cancelamento)
+            chaves.inserir(chave_pedido(pedido.id_processo, pedido.id));
+        filas[destino].inserir(std::move(pedido));
+        ++quantidade;
+    }
+
+    // Próximo pedido da impressora id_impressora (0 = qualquer uma); a fila não pode estar vazia
+    Pedido &topo(std::chrono::system_clock::time_point agora, int id_impressora)
+    {
+        std::size_t indice = id_impressora >= 1 ? static_cast<std::size_t>(id_impressora - 1) : 0;
+        fila_topo = 0;
+        if (filas.size() == 1)
+        {
+            bool maior_primeiro = politica == PoliticaDespacho::PorTamanho && indice < rapida.size() && rapida[indice];
+            Pedido &pedido = filas[0].topo(agora, maior_primeiro);
+            paginas_topo = pedido.num_paginas;
+            chave_topo = chave_pedido(pedido.id_processo, pedido.id);
+            return pedido;
+        }
+
+        // Fila própria, a menos que esteja vazia ou que outra tenha prioridade maior; entre as outras,
+        // a de maior prioridade e, no empate, a de maior término estimado
+        std::size_t propria = indice < filas.size() ? indice : 0;
+        fila_topo = propria;
+        int maior_prioridade = filas[propria].prioridade_mais_alta();
+        for (std::size_t i = 0; i < filas.size(); ++i)
+        {
+            int prioridade = filas[i].prioridade_mais_alta();
+            bool empate_com_roubo = prioridade == maior_prioridade && fila_topo != propria &&
+                                    termino_estimado(i) > termino_estimado(fila_topo);
+            if (prioridade > maior_prioridade || empate_com_roubo)
+            {
+                fila_topo = i;
+                maior_prioridade = prioridade;
+            }
+        }
+        Pedido &pedido = filas[fila_topo].topo(agora);
+        paginas_topo = pedido.num_paginas;
+        chave_topo = chave_pedido(pedido.id_processo, pedido.id);
+        return pedido;
+    }
+
+    // Remove o pedido devolvido pela última chamada a topo()
+    void remover_topo()
+    {
+        paginas_fila[fila_topo] -= paginas_topo;
+        filas[fila_topo].remover_topo();
+        --quantidade;
+        if (cancelamento)
+            chaves.remover(chave_topo);
+    }
+
+    // Marca como cancelado um pedido com a chave que está na fila; ele sai da fila quando chegar ao
+    // topo (retirar_cancelado). Retorna false se nenhum pedido não marcado com a chave está na fila
+    // (já foi retirado, foi despejado ou nunca entrou) ou se o cancelamento não está ativo.
+    bool cancelar(std::uint64_t chave)
+    {
+        return cancelamento && chaves.marcar(chave);
+    }
+
+    // Indica se há pedidos marcados como cancelados na fila
+    bool ha_cancelados() const
+    {
+        return chaves.ha_marcas();
+    }
+
+    // Tira o pedido do topo (o próximo da impressora id_impressora) para saida se ele foi cancelado.
+    // Retorna false quando o topo é um pedido válido ou a fila está vazia.
+    bool retirar_cancelado(std::chrono::system_clock::time_point agora, int id_impressora, Pedido &saida)
+    {
+        if (!chaves.ha_marcas() || vazia())
+            return false;
+        Pedido &pedido = topo(agora, id_impressora);
+        if (!chaves.consumir_marca(chave_topo))
+            return false;
+        saida = pedido;
+        remover_topo();
+        return true;
+    }
+
+    // Retira o próximo pedido da impressora para saida. Com a divisão ativa, um documento com mais de
+    // paginas_por_parte páginas sai em partes: cada chamada entrega as próximas paginas_por_parte
+    // páginas e o documento fica no topo com o restante, de modo que as impressoras livres imprimem
+    // as partes em paralelo e na ordem de prioridade. Só a última parte tira o documento da fila.
+    // Retorna true quando o documento saiu da fila.
+    bool retirar(std::chrono::system_clock::time_point agora, int id_impressora, Pedido &saida)
+    {
+        Pedido &pedido = topo(agora, id_impressora);
+        saida = pedido;
+        if (paginas_por_parte > 0 && pedido.num_paginas > paginas_por_parte &&
+            pedido.parte < std::numeric_limits<std::int16_t>::max() - 1)
+        {
+            saida.num_paginas = paginas_por_parte;
+            saida.parte = ++pedido.parte;
+            pedido.num_paginas -= paginas_por_parte;
+            paginas_fila[fila_topo] -= paginas_por_parte;
+            return false;
+        }
+        if (pedido.parte > 0)
+            saida.parte = static_cast<std::int16_t>(pedido.parte + 1); // Última parte, com o restante
+        remover_topo();
+        return true;
+    }
+
+    // Despeja um pedido de prioridade menor que a informada, da fila com o nível mais baixo
+    bool despejar(int prioridade, bool mais_antigo, Pedido &vitima)
+    {
+        std::size_t escolhida = 0;
+        int menor = 0;
+        for (std::size_t i = 0; i < filas.size(); ++i)
+        {
+            int prioridade_fila = filas[i].prioridade_mais_baixa();
+            if (prioridade_fila > 0 && (menor == 0 || prioridade_fila < menor))
+            {
+                escolhida = i;
+                menor = prioridade_fila;
+            }
+        }
+        if (menor == 0 || !filas[escolhida].despejar(prioridade, mais_antigo, vitima))
+            return false;
+        paginas_fila[escolhida] -= vitima.num_paginas;
+        --quantidade;
+        if (cancelamento)
+            chaves.remover(chave_pedido(vitima.id_processo, vitima.id));
+        return true;
+    }
+
+private:
+    PoliticaDespacho politica;              // Política de despacho
+    std::vector<int> tempos_por_pagina;     // Tempo por página de cada impressora
+    int paginas_por_parte;                  // Tamanho das partes dos documentos divididos (0 = sem divisão)
+    std::vector<FilaPrioridades> filas;     // Uma fila compartilhada ou uma por impressora
+    std::vector<std::int64_t> paginas_fila; // Páginas em cada fila, para o término estimado
+    std::vector<bool> rapida;               // Impressoras mais rápidas que a mediana
+    std::size_t quantidade = 0;             // Pedidos em todas as filas
+    std::size_t fila_topo = 0;              // Fila escolhida pela última chamada a topo()
+    int paginas_topo = 0;                   // Páginas do pedido devolvido pela última chamada a topo()
+    std::uint64_t chave_topo = 0;           // Chave do pedido devolvido pela última chamada a topo()
+    bool cancelamento;                      // Acompanha as chaves dos pedidos na fila
+    ChavesNaFila chaves;                    // Pedidos na fila e marcas de cancelamento, por chave
+
+    // Tempo estimado para a impressora esvaziar a própria fila
+    std::int64_t termino_estimado(std::size_t fila) const
+    {
+        return paginas_fila[fila] * std::max(1, tempos_por_pagina[fila]);
+    }
+};
+
+// Documentos divididos em partes que ainda têm partes em impressão. As partes são entregues sob o lock
+// do buffer (FilaDespacho::retirar), na ordem em que saem da fila, e concluídas pelas impressoras em
+// qualquer ordem; o documento termina com a conclusão da última parte pendente depois que a última
+// parte saiu da fila.
+class DocumentosDivididos
+{
+public:
+    DocumentosDivididos() = default;
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    DocumentosDivididos(const DocumentosDivididos &) = delete;
+    DocumentosDivididos &operator=(const DocumentosDivididos &) = delete;
+
+    // Registra a entrega de uma parte; saiu_da_fila indica a última parte do documento
+    void entregar(const Pedido &parte, bool saiu_da_fila)
+    {
+        std::lock_guard<MutexDocumentos> lock(mutex_documentos);
+        Documento &documento = documentos[chave(parte)];
+        ++documento.pendentes;
+        documento.saiu_da_fila = saiu_da_fila;
+    }
+
+    // Registra o cancelamento do restante de um documento que já tinha partes entregues: as partes em
+    // impressão terminam, mas nenhuma conclui o documento
+    void cancelar(const Pedido &restante)
+    {
+        std::lock_guard<MutexDocumentos> lock(mutex_documentos);
+        auto it = documentos.find(chave(restante));
+        if (it == documentos.end())
+            return;
+        if (it->second.pendentes == 0)
+        {
+            documentos.erase(it);
+            return;
+        }
+        it->second.saiu_da_fila = true;
+        it->second.cancelado = true;
+    }
+
+    // Registra uma parte abandonada no prazo de drenagem: ela deixa de estar pendente, e o documento não
+    // é mais concluído
+    void abandonar(const Pedido &parte)
+    {
+        if (parte.parte == 0)
+            return;
+        std::lock_guard<MutexDocumentos> lock(mutex_documentos);
+        auto it = documentos.find(chave(parte));
+        if (it == documentos.end())
+            return;
+        it->second.cancelado = true;
+        if (--it->second.pendentes == 0 && it->second.saiu_da_fila)
+            documentos.erase(it);
+    }
+
+    // Registra a conclusão de um pedido e indica se ele conclui o documento (sempre, se inteiro)
+    bool concluir(const Pedido &pedido)
+    {
+        if (pedido.parte == 0)
+            return true;
+        std::lock_guard<MutexDocumentos> lock(mutex_documentos);
+        auto it = documentos.find(chave(pedido));
+        if (it == documentos.end())
+            return true;
+        if (--it->second.pendentes > 0 || !it->second.saiu_da_fila)
+            return false;
+        bool concluido = !it->second.cancelado;
+        documentos.erase(it);
+        return concluido;
+    }
+
+private:
+    using MutexDocumentos = MutexInstrumentado<RecursoRastro::MutexDocumentos>; // std::mutex sem o rastreamento
+
+    struct Documento
+    {
+        int pendentes = 0;         // Partes entregues e ainda não concluídas
+        bool saiu_da_fila = false; // A última parte já foi entregue (ou o restante foi cancelado)
+        bool cancelado = false;    // O restante do documento foi cancelado na fila
+    };
+
+    // Identifica o documento pelo processo e pelo pedido
+    static std::uint64_t chave(const Pedido &pedido)
+    {
+        return chave_pedido(pedido.id_processo, pedido.id);
+    }
+
+    MutexDocumentos mutex_documentos;                        // Protege o mapa
+    std::unordered_map<std::uint64_t, Documento> documentos; // Documentos com partes pendentes
+};
+
+// Percentis de latência de uma leitura das métricas, em ms
+struct LatenciaMetricas
+{
+    std::uint64_t pedidos = 0;                                 // Pedidos medidos
+    double soma_ms = 0.0;                                      // Soma das latências
+    std::array<double, PERCENTIS_RELATORIO.size()> percentis{}; // Um valor por PERCENTIS_RELATORIO
+    double maximo_ms = 0.0;                                    // Maior latência
+
+    // Resumo de um histograma registrado em µs
+    static LatenciaMetricas de(const Histograma &histograma)
+    {
+        LatenciaMetricas latencia;
+        latencia.pedidos = histograma.contagem();
+        latencia.soma_ms = histograma.media() * static_cast<double>(latencia.pedidos) / 1000.0;
+        for (std::size_t i = 0; i < PERCENTIS_RELATORIO.size(); ++i)
+            latencia.percentis[i] = histograma.percentil(PERCENTIS_RELATORIO[i]) / 1000.0;
+        latencia.maximo_ms = histograma.maximo() / 1000.0;
+        return latencia;
+    }
+};
+
+// Estado de uma impressora em uma leitura das métricas
+struct MetricasImpressora
+{
+    int id_impressora = 0;       // Identificador da impressora
+    bool ocupada = false;        // Imprimindo no momento da leitura
+    std::uint64_t impressos = 0; // Documentos concluídos, como em RegistrosImpressao::documentos()
+    std::int64_t paginas = 0;    // Páginas impressas
+};
+
+// Leitura das métricas do spool em um instante (Spool::snapshot). Os contadores são cumulativos;
+// as taxas saem da diferença entre duas leituras.
+struct MetricasSpool
+{
+    std::chrono::steady_clock::time_point instante;          // Momento da leitura
+    int capacidade = 0;                                      // Capacidade do buffer
+    int ocupacao = 0;                                        // Pedidos no buffer
+    std::array<int, NUM_PRIORIDADES> fila_por_prioridade{};  // Pedidos no buffer por prioridade (1 a 5)
+    std::uint64_t retirados = 0;                             // Pedidos retirados pelas impressoras
+    ResumoAdmissao admissao;                                 // Aceitos (enfileirados), rejeitados, limitados e despejados
+    std::vector<MetricasImpressora> impressoras;             // Estado de cada impressora observada
+    LatenciaMetricas espera;                                 // Espera na fila dos pedidos já iniciados
+    std::array<LatenciaMetricas, NUM_PRIORIDADES> espera_por_prioridade; // Espera por prioridade (1 a 5)
+
+    // Pedidos enfileirados por segundo desde uma leitura anterior
+    double taxa_enfileiramento(const MetricasSpool &anterior) const
+    {
+        return taxa(admissao.aceitos, anterior.admissao.aceitos, anterior);
+    }
+
+    // Pedidos retirados por segundo desde uma leitura anterior
+    double taxa_retirada(const MetricasSpool &anterior) const
+    {
+        return taxa(retirados, anterior.retirados, anterior);
+    }
+
+private:
+    double taxa(std::uint64_t atual, std::uint64_t antes, const MetricasSpool &anterior) const
+    {
+        double segundos = std::chrono::duration<double>(instante - anterior.instante).count();
+        return segundos > 0.0 ? static_cast<double>(atual - antes) / segundos : 0.0;
+    }
+};
+
+// Pedidos que deixaram o spool sem impressão completa e impressões interrompidas
+struct ResumoInterrupcoes
+{
+    std::uint64_t cancelados = 0;             // Pedidos cancelados ainda na fila
+    std::uint64_t descartados_drenagem = 0;   // Pedidos no buffer no fim do prazo de drenagem
+    std::uint64_t preempcoes = 0;             // Impressões interrompidas por um pedido mais prioritário (e retomadas)
+    std::uint64_t impressoes_abandonadas = 0; // Impressões interrompidas no fim do prazo de drenagem
+};
+
+// Aviso compartilhado pelos spools de um cluster. Cada enfileiramento em um spool acorda as impressoras
+// dele que esperam trabalho; se elas não bastam para os pedidos novos, acorda também as dos outros
+// spools, que roubam o excedente. O encerramento acorda todas. Quem espera lê a versão antes de
+// procurar pedidos, então um aviso dado durante a procura não se perde.
+class AvisoCluster
+{
+public:
+    explicit AvisoCluster(int num_spools)
+        : esperando(static_cast<std::size_t>(num_spools)), condicoes(static_cast<std::size_t>(num_spools))
+    {
+    }
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    AvisoCluster(const AvisoCluster &) = delete;
+    AvisoCluster &operator=(const AvisoCluster &) = delete;
+
+    // Versão atual, lida antes de procurar pedidos
+    std::uint64_t versao() const
+    {
+        return versao_atual.load();
+    }
+
+    // Avisa quantidade pedidos novos no spool indice (0 = encerramento, que acorda todas as impressoras);
+    // sem impressoras em espera, não trava o mutex
+    void avisar(int indice, std::size_t quantidade)
+    {
+        versao_atual.fetch_add(1);
+        if (esperando_total.load() == 0)
+            return;
+        std::lock_guard<std::mutex> lock(mutex_aviso);
+        std::size_t locais = static_cast<std::size_t>(esperando[static_cast<std::size_t>(indice)]);
+        if (quantidade > 0 && locais > 0)
+            condicoes[static_cast<std::size_t>(indice)].notify_all();
+        if (quantidade > 0 && quantidade <= locais)
+            return;
+        for (auto &condicao : condicoes)
+            condicao.notify_all();
+    }
+
+    // Espera, como impressora do spool indice, até a versão mudar em relação à lida antes da procura
+    void esperar(int indice, std::uint64_t versao)
+    {
+        std::unique_lock<std::mutex> lock(mutex_aviso);
+        esperando_total.fetch_add(1);
+        ++esperando[static_cast<std::size_t>(indice)];
+        condicoes[static_cast<std::size_t>(indice)].wait(lock, [this, versao]() { return versao_atual.load() != versao; });
+        --esperando[static_cast<std::size_t>(indice)];
+        esperando_total.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::uint64_t> versao_atual{0};      // Avisos dados até agora
+    std::atomic<int> esperando_total{0};             // Impressoras dormindo à espera de um aviso
+    std::vector<int> esperando;                      // Impressoras dormindo por spool (protegido por mutex_aviso)
+    std::mutex mutex_aviso;                          // Mutex da espera
+    std::vector<std::condition_variable> condicoes;  // Uma por spool, para acordar primeiro as impressoras locais
+};
+
+// Classe que gerencia o spool de impressão
+class Spool
+{
+public:
+    // Construtor que define a capacidade máxima do buffer, o backend da fila, o tempo limite de inatividade,
+    // opcionalmente o diário em que enfileiramentos, retiradas e conclusões são anexados, a política de
+    // admissão com o buffer cheio, o escalonamento anti-inanição e o despacho às impressoras (esses dois
+    // só no backend com mutex, exceto a preempção e o prazo de drenagem)
+    Spool(int capacidade_buffer, BackendSpool backend_fila = BackendSpool::Mutex, int tempo_limite_inatividade_s = 30,
+          DiarioSpool *diario_pedidos = nullptr, const ConfiguracaoAdmissao &admissao_pedidos = ConfiguracaoAdmissao(),
+          const ConfiguracaoEscalonamento &escalonamento = ConfiguracaoEscalonamento(),
+          const ConfiguracaoDespacho &despacho = ConfiguracaoDespacho())
+        : buffer(escalonamento, despacho), capacidade(capacidade_buffer), encerrar(false), backend(backend_fila), diario(diario_pedidos),
+          admissao(admissao_pedidos), tempo_limite_inatividade(tempo_limite_inatividade_s)
+    {
+        // Os pedidos pendentes no diário voltam ao buffer antes dos novos, mesmo além da capacidade
+        std::vector<Pedido> recuperados;
+        if (diario != nullptr)
+            recuperados = diario->retirar_recuperados();
+
+        if (backend == BackendSpool::LockFree)
+        {
+            // Cada balde comporta a ocupação máxima, pois a ocupação global é limitada à parte
+            std::size_t tamanho_balde = std::max(static_cast<std::size_t>(capacidade), recuperados.size());
+            for (auto &fila : filas_prioridade)
+                fila = std::make_unique<FilaCircularMPMC<Pedido>>(tamanho_balde);
+            for (const Pedido &pedido : recuperados)
+                filas_prioridade[indice_prioridade(pedido.prioridade)]->tentar_inserir(pedido);
+        }
+        else
+        {
+            // Os FIFOs são alocados de uma vez, como os baldes do backend lock-free
+            buffer.reservar(static_cast<std::size_t>(capacidade));
+            for (Pedido &pedido : recuperados)
+                buffer.inserir(std::move(pedido));
+        }
+        ocupacao.store(static_cast<int>(recuperados.size()), std::memory_order_relaxed);
+        for (const Pedido &pedido : recuperados)
+            contar_enfileirado(pedido);
+        prioridade_preempcao = despacho.prioridade_preempcao;
+        prazo_drenagem = std::chrono::milliseconds(despacho.prazo_drenagem_ms);
+    }
+
+    // Função para adicionar um pedido ao buffer
+    bool add_pedido(const Pedido &pedido)
+    {
+        return adicionar_lote(&pedido, 1) == 1;
+    }
+
+    // Função para adicionar um lote de pedidos com uma única seção crítica e uma notificação por lote.
+    // Retorna a quantidade de pedidos aceitos; os demais foram descartados por falta de espaço.
+    std::size_t add_pedidos(const std::vector<Pedido> &pedidos)
+    {
+        return adicionar_lote(pedidos.data(), pedidos.size());
+    }
+
+    // Função para obter um pedido do buffer para a impressora id_impressora (0 = qualquer uma)
+    bool get_pedido(Pedido &pedido, int id_impressora = 0)
+    {
+        SPOOL_RASTRO_TRECHO(RecursoRastro::Retirar, id_impressora);
+        if (drenagem_esgotada())
+        {
+            descartar_na_drenagem();
+            return false;
+        }
+        if (backend == BackendSpool::LockFree)
+            return get_pedido_lock_free(pedido);
+
+        std::unique_lock<MutexBuffer> lock(mutex_buffer);
+        // Espera até que haja um pedido na fila ou que o sistema esteja encerrando
+        esperar_pedido_travado(lock, id_impressora);
+
+        if (buffer.vazia())
+        {
+            // Se a fila está vazia e o sistema está encerrando
+            return false; // Indica que não há mais pedidos para processar
+        }
+
+        // Obtém o pedido de maior prioridade (ou a próxima parte dele) e o remove da fila
+        retirar_um_travado(pedido, id_impressora, lock);
+        return true;
+    }
+
+    // Função para obter um lote de até max_n pedidos compatíveis (mesma prioridade do primeiro),
+    // em ordem de prioridade e com uma única seção crítica. Retorna 0 quando o spool está encerrando.
+    std::size_t get_pedidos(std::vector<Pedido> &saida, std::size_t max_n, int id_impressora = 0)
+    {
+        SPOOL_RASTRO_TRECHO(RecursoRastro::Retirar, id_impressora);
+        saida.clear();
+        if (max_n == 0)
+            return 0;
+        if (drenagem_esgotada())
+        {
+            descartar_na_drenagem();
+            return 0;
+        }
+        if (backend == BackendSpool::LockFree)
+            return get_pedidos_lock_free(saida, max_n);
+
+        std::unique_lock<MutexBuffer> lock(mutex_buffer);
+        // Espera até que haja um pedido na fila ou que o sistema esteja encerrando
+        esperar_pedido_travado(lock, id_impressora);
+
+        if (buffer.vazia())
+            return 0; // Fila vazia e o sistema está encerrando
+
+        return retirar_lote_travado(saida, max_n, lock, id_impressora);
+    }
+
+    // Versão sem espera de add_pedidos, usada pelo executor: aceita o que couber no buffer agora.
+    // Retorna a quantidade de pedidos aceitos (0 quando o spool está encerrando).
+    // O despejo se aplica como em add_pedidos; o limite de taxa (aplicar_limite_taxa) e a espera até o
+    // prazo ficam com o chamador.
+    std::size_t tentar_add_pedidos(const Pedido *pedidos, std::size_t quantidade)
+    {
+        SPOOL_RASTRO_TRECHO(RecursoRastro::Enfileirar, quantidade);
+        registrar_atividade(); // Atualiza o tempo da última solicitação, sem locks
+        std::size_t aceitos = 0;
+        if (backend == BackendSpool::LockFree)
+        {
+            while (aceitos < quantidade && !encerrar.load() && (reservar_vaga() || despejar_lock_free(pedidos[aceitos])))
+            {
+                inserir_reservado(pedidos[aceitos]);
+                ++aceitos;
+            }
+            avisar_consumidores(aceitos);
+            contadores.aceitos.fetch_add(aceitos, std::memory_order_relaxed);
+            return aceitos;
+        }
+
+        std::unique_lock<MutexBuffer> lock(mutex_buffer);
+        while (aceitos < quantidade && !encerrar.load() &&
+               (static_cast<int>(buffer.tamanho()) < capacidade || despejar_travado(pedidos[aceitos])))
+        {
+            inserir_travado(pedidos[aceitos]); // Adiciona o pedido à fila de prioridade
+            imprimir_recebimento(pedidos[aceitos]);
+            ++aceitos;
+        }
+        ocupacao.store(static_cast<int>(buffer.tamanho()), std::memory_order_relaxed);
+        notificar_vagas(cond_var_buffer, aceitos);
+        lock.unlock();
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        retomar_estacionadas(consumidores_estacionados_fila, consumidores_estacionados, aceitos);
+        avisar_cluster(aceitos);
+        contadores.aceitos.fetch_add(aceitos, std::memory_order_relaxed);
+        return aceitos;
+    }
+
+    // Versão sem espera de get_pedidos, usada pelo executor. Retorna 0 quando o buffer está vazio.
+    std::size_t tentar_get_pedidos(std::vector<Pedido> &saida, std::size_t max_n, int id_impressora = 0)
+    {
+        SPOOL_RASTRO_TRECHO(RecursoRastro::Retirar, id_impressora);
+        saida.clear();
+        if (max_n == 0)
+            return 0;
+        if (drenagem_esgotada())
+        {
+            descartar_na_drenagem();
+            return 0;
+        }
+        if (backend == BackendSpool::LockFree)
+            return retirar_lote_lock_free(saida, max_n);
+
+        std::unique_lock<MutexBuffer> lock(mutex_buffer);
+        descartar_cancelados_travado(id_impressora);
+        if (buffer.vazia())
+            return 0;
+        retirar_lote_travado(saida, max_n, lock, id_impressora);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        retomar_estacionadas(produtores_estacionados_fila, produtores_estacionados, saida.size());
+        if (saida.back().parte > 0) // O restante de um documento dividido pode ter ficado na fila
+            retomar_estacionadas(consumidores_estacionados_fila, consumidores_estacionados, 1);
+        return saida.size();
+    }
+
+    // Registra o descarte de pedidos que não couberam no prazo (sem mensagem durante o encerramento)
+    void registrar_descartes(const Pedido *pedidos, std::size_t quantidade)
+    {
+        if (encerrar.load())
+            return;
+        for (std::size_t i = 0; i < quantidade; ++i)
+            imprimir_descarte(pedidos[i]);
+    }
+
+    // Limite de taxa por processo (balde de fichas): retorna quantos pedidos do início do lote têm ficha.
+    // Os demais são recusados (e contados) aqui; o chamador os trata como descartados.
+    std::size_t aplicar_limite_taxa(const Pedido *pedidos, std::size_t quantidade)
+    {
+        if (admissao.taxa_por_processo <= 0.0 || quantidade == 0)
+            return quantidade;
+        std::int64_t agora_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now().time_since_epoch())
+                                    .count();
+        std::size_t permitidos = 0;
+        {
+            std::lock_guard<MutexFichas> lock(mutex_fichas);
+            while (permitidos < quantidade)
+            {
+                auto balde = fichas_processo.try_emplace(pedidos[permitidos].id_processo,
+                                                         BaldeFichas{static_cast<double>(admissao.rajada_por_processo), agora_us})
+                                 .first;
+                if (!balde->second.consumir(agora_us, admissao.taxa_por_processo, admissao.rajada_por_processo))
+                    break;
+                ++permitidos;
+            }
+        }
+        if (permitidos < quantidade)
+        {
+            contadores.limitados.fetch_add(quantidade - permitidos, std::memory_order_relaxed);
+            for (std::size_t i = permitidos; i < quantidade; ++i)
+                logger.registrar(NivelLog::Resumo, TipoEvento::PedidoLimitado, pedidos[i].id_processo, pedidos[i].id);
+        }
+        return permitidos;
+    }
+
+    // Espera máxima por vaga de um produtor (0 quando a política descarta na hora)
+    std::chrono::milliseconds prazo_admissao() const
+    {
+        if (admissao.politica == PoliticaAdmissao::Rejeitar)
+            return std::chrono::milliseconds(0);
+        return std::chrono::milliseconds(admissao.prazo_ms);
+    }
+
+    // Contadores de pedidos aceitos, rejeitados, limitados e despejados
+    const ContadoresAdmissao &contadores_admissao() const
+    {
+        return contadores;
+    }
+
+    // Pedidos no buffer agora (leitura relaxada, usada para escolher de quem roubar)
+    int ocupacao_atual() const
+    {
+        return ocupacao.load(std::memory_order_relaxed);
+    }
+
+    // Impressoras cujo estado, páginas e esperas entram em snapshot() (definido antes de iniciá-las)
+    void observar_impressoras(const RegistrosImpressao &registros)
+    {
+        registros_impressoras = &registros;
+    }
+
+    // Aviso do cluster que o spool (de índice indice) integra, dado a cada enfileiramento e no
+    // encerramento (definido antes de iniciar processos e impressoras)
+    void integrar_cluster(AvisoCluster &aviso, int indice)
+    {
+        aviso_cluster = &aviso;
+        indice_cluster = indice;
+    }
+
+    // Leitura das métricas sem locks: só lê contadores atômicos, que os caminhos de inserção e
+    // retirada atualizam com incrementos relaxados. Os valores de uma leitura não formam um
+    // instante exato (cada contador é lido em um momento), mas cada um é consistente por si.
+    MetricasSpool snapshot() const
+    {
+        MetricasSpool metricas;
+        metricas.instante = std::chrono::steady_clock::now();
+        metricas.capacidade = capacidade;
+        metricas.ocupacao = ocupacao.load(std::memory_order_relaxed);
+        for (int i = 0; i < NUM_PRIORIDADES; ++i)
+            metricas.fila_por_prioridade[i] = std::max(0, fila_por_prioridade[i].load(std::memory_order_relaxed));
+        metricas.retirados = retirados.load(std::memory_order_relaxed);
+        metricas.admissao = contadores.ler();
+        if (registros_impressoras == nullptr)
+            return metricas;
+
+        for (int id = 1; id <= registros_impressoras->num_impressoras(); ++id)
+        {
+            const ColunasImpressora &colunas = registros_impressoras->colunas(id);
+            metricas.impressoras.push_back(MetricasImpressora{id, colunas.ocupada(), colunas.documentos_concluidos(), colunas.total_paginas()});
+        }
+        Histograma total;
+        for (int p = PRIORIDADE_MINIMA; p <= PRIORIDADE_MAXIMA; ++p)
+        {
+            Histograma espera;
+            registros_impressoras->acumular_latencias(MetricaLatencia::Espera, p, 0, espera);
+            metricas.espera_por_prioridade[p - PRIORIDADE_MINIMA] = LatenciaMetricas::de(espera);
+            total.mesclar(espera);
+        }
+        metricas.espera = LatenciaMetricas::de(total);
+        return metricas;
+    }
+
+    // Registra no diário a conclusão da impressão de um pedido retirado do spool. Retorna true quando
+    // o pedido conclui o documento: sempre para um documento inteiro e, para um documento dividido,
+    // só na conclusão da última parte pendente.
+    bool concluir_pedido(const Pedido &pedido)
+    {
+        if (diario != nullptr)
+            diario->registrar_concluido(pedido);
+        return divididos.concluir(pedido);
+    }
+
+    // Cancela um pedido que ainda está na fila (backend mutex, com ConfiguracaoDespacho::cancelamento).
+    // O pedido é só marcado, e sai da fila sem ser impresso quando chega ao topo. Retorna false quando o
+    // pedido não está na fila (já foi entregue a uma impressora, foi despejado ou já estava marcado), o
+    // cancelamento não foi ativado ou o backend é lock-free.
+    bool cancelar_pedido(int id_processo, int id_pedido)
+    {
+        if (backend == BackendSpool::LockFree)
+            return false;
+        std::lock_guard<MutexBuffer> lock(mutex_buffer);
+        return buffer.cancelar(chave_pedido(id_processo, id_pedido));
+    }
+
+    // Indica se as impressoras devem imprimir página a página, para atender à preempção ou ao prazo de drenagem
+    bool impressao_interrompivel() const
+    {
+        return prioridade_preempcao > 0 || prazo_drenagem.count() >= 0;
+    }
+
+    // Indica se há no buffer um pedido que interrompe a impressão de um pedido da prioridade informada:
+    // de prioridade maior que ela e pelo menos a do limiar de preempção, sem nenhuma impressora ociosa
+    // para atendê-lo. Só lê contadores atômicos, para ser consultada a cada página.
+    bool preempcao_pendente(int prioridade) const
+    {
+        if (prioridade_preempcao == 0 || consumidores_esperando.load(std::memory_order_relaxed) > 0)
+            return false;
+        for (int p = std::max(prioridade + 1, prioridade_preempcao); p <= PRIORIDADE_MAXIMA; ++p)
+        {
+            if (fila_por_prioridade[indice_prioridade(p)].load(std::memory_order_relaxed) > 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Retira o pedido que interrompe a impressão de um pedido da prioridade informada (o próximo da
+    // impressora, se tiver prioridade suficiente). Retorna false quando outra impressora o levou antes.
+    bool retirar_preemptivo(int prioridade, Pedido &pedido, int id_impressora = 0)
+    {
+        int limiar = std::max(prioridade + 1, prioridade_preempcao);
+        if (limiar > PRIORIDADE_MAXIMA)
+            return false;
+        if (backend == BackendSpool::LockFree)
+        {
+            for (int i = NUM_PRIORIDADES - 1; i >= indice_prioridade(limiar); --i)
+            {
+                if (filas_prioridade[i]->tentar_retirar(pedido))
+                {
+                    liberar_vagas(1, false);
+                    registrar_retiradas(&pedido, 1);
+                    preempcoes.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::unique_lock<MutexBuffer> lock(mutex_buffer);
+        descartar_cancelados_travado(id_impressora);
+        if (buffer.vazia() || buffer.topo(instante_escalonamento(), id_impressora).prioridade < limiar)
+            return false;
+        retirar_um_travado(pedido, id_impressora, lock);
+        preempcoes.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Indica que o prazo de drenagem do encerramento passou: as impressoras deixam de retirar pedidos
+    // e abandonam a impressão em curso na próxima página
+    bool drenagem_esgotada() const
+    {
+        if (prazo_drenagem.count() < 0 || !encerrar.load())
+            return false;
+        return std::chrono::steady_clock::now().time_since_epoch().count() >= fim_drenagem.load(std::memory_order_relaxed);
+    }
+
+    // Conta uma impressão abandonada no fim do prazo de drenagem. O pedido não é concluído no diário,
+    // que o devolve ao spool na próxima abertura; se é parte de um documento dividido, o documento
+    // também não é concluído.
+    void registrar_abandono(const Pedido &pedido)
+    {
+        impressoes_abandonadas.fetch_add(1, std::memory_order_relaxed);
+        divididos.abandonar(pedido);
+    }
+
+    // Pedidos cancelados e descartados na drenagem, preempções e impressões abandonadas
+    ResumoInterrupcoes interrupcoes() const
+    {
+        ResumoInterrupcoes resumo;
+        resumo.cancelados = pedidos_cancelados.load(std::memory_order_relaxed);
+        resumo.descartados_drenagem = descartados_drenagem.load(std::memory_order_relaxed);
+        resumo.preempcoes = preempcoes.load(std::memory_order_relaxed);
+        resumo.impressoes_abandonadas = impressoes_abandonadas.load(std::memory_order_relaxed);
+        return resumo;
+    }
+
+    // Indica que o spool está encerrando
+    bool encerrando() const
+    {
+        return encerrar.load();
+    }
+
+    // Estaciona uma tarefa à espera de pedidos. O chamador deve tentar retirar de novo depois de
+    // estacionar, pois um pedido publicado antes do registro não gera notificação.
+    void estacionar_consumidor(TarefaRetomavel *tarefa)
+    {
+        estacionar(consumidores_estacionados_fila, consumidores_estacionados, tarefa);
+    }
+
+    // Estaciona uma tarefa à espera de vagas (mesma regra de estacionar_consumidor)
+    void estacionar_produtor(TarefaRetomavel *tarefa)
+    {
+        estacionar(produtores_estacionados_fila, produtores_estacionados, tarefa);
+    }
+
+    // Retira uma tarefa da espera por pedidos. repassar indica que a tarefa sai da espera sem tentar
+    // retirar de novo, e uma notificação que já a tinha escolhido deve ir para a próxima da fila.
+    void cancelar_espera_pedido(TarefaRetomavel *tarefa, bool repassar)
+    {
+        cancelar_espera(consumidores_estacionados_fila, consumidores_estacionados, tarefa, repassar);
+    }
+
+    // Retira uma tarefa da espera por vagas (mesma regra de cancelar_espera_pedido)
+    void cancelar_espera_vaga(TarefaRetomavel *tarefa, bool repassar)
+    {
+        cancelar_espera(produtores_estacionados_fila, produtores_estacionados, tarefa, repassar);
+    }
+
+    // Função que espera até que o sistema esteja inativo (ou sem trabalho) e então sinaliza o encerramento
+    void wait_until_finished()
+    {
+        // Inicializa o tempo da última solicitação como o tempo atual
+        registrar_atividade();
+        monitor_ativo.store(true);
+
+        // Inicia a thread de monitoramento de inatividade
+        std::thread monitor_thread(&Spool::monitorar_inatividade, this);
+
+        // Espera até que o sistema esteja encerrando
+        monitor_thread.join();
+    }
+
+    // Acorda o monitor para reavaliar o encerramento (fim dos processos ou fila esvaziada)
+    void notificar_monitor()
+    {
+        if (!monitor_ativo.load(std::memory_order_relaxed))
+            return;
+        std::lock_guard<std::mutex> lock(mutex_monitor);
+        cond_var_monitor.notify_one();
+    }
+
+    // Função para sinalizar o encerramento do spool (fallback)
+    void encerrar_spool()
+    {
+        // O prazo de drenagem começa no primeiro sinal de encerramento
+        if (prazo_drenagem.count() >= 0)
+        {
+            std::chrono::steady_clock::rep sem_prazo = 0;
+            fim_drenagem.compare_exchange_strong(sem_prazo, (std::chrono::steady_clock::now() + prazo_drenagem).time_since_epoch().count());
+        }
+        encerrar.store(true);
+        if (backend == BackendSpool::LockFree)
+        {
+            // Acorda produtores e consumidores que dormem no caminho lento
+            std::lock_guard<std::mutex> lock(mutex_espera);
+            cond_var_pedido.notify_all();
+            cond_var_vaga.notify_all();
+        }
+        else
+        {
+            cond_var_buffer.notify_all();
+        }
+
+        // Acorda também as tarefas do executor estacionadas
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::size_t todas = std::numeric_limits<std::size_t>::max();
+        retomar_estacionadas(consumidores_estacionados_fila, consumidores_estacionados, todas);
+        retomar_estacionadas(produtores_estacionados_fila, produtores_estacionados, todas);
+        if (aviso_cluster != nullptr)
+            aviso_cluster->avisar(indice_cluster, 0);
+    }
+
+private:
+    // Mutexes instrumentados pelo rastreamento (std::mutex sem ele)
+    using MutexBuffer = MutexInstrumentado<RecursoRastro::MutexBuffer>;
+    using MutexFichas = MutexInstrumentado<RecursoRastro::MutexFichas>;
+
+    FilaDespacho buffer;                     // Fila de prioridade para os pedidos (um FIFO por nível)
+    DocumentosDivididos divididos;           // Documentos divididos com partes em impressão
+    MutexBuffer mutex_buffer;                // Mutex para proteger o acesso ao buffer
+    CondicaoInstrumentada cond_var_buffer;   // Variável de condição para sincronização
+    int capacidade;                          // Capacidade máxima do buffer
+    std::atomic<bool> encerrar;              // Flag para indicar o encerramento do sistema
+    BackendSpool backend;                    // Backend escolhido para a fila
+    DiarioSpool *diario;                     // Diário dos pedidos (nulo quando desligado)
+    ConfiguracaoAdmissao admissao;           // Política com o buffer cheio e limite de taxa
+    ContadoresAdmissao contadores;           // Pedidos aceitos, rejeitados, limitados e despejados
+    MutexFichas mutex_fichas;                // Protege os baldes de fichas
+    std::unordered_map<int, BaldeFichas> fichas_processo; // Balde de fichas de cada processo
+
+    // Métricas ao vivo, em linha de cache própria para não disputar com o mutex do buffer
+    alignas(64) std::array<std::atomic<int>, NUM_PRIORIDADES> fila_por_prioridade{}; // Pedidos no buffer por prioridade
+    std::atomic<std::uint64_t> retirados{0};                              // Pedidos retirados pelas impressoras
+    const RegistrosImpressao *registros_impressoras = nullptr;            // Impressoras observadas (opcional)
+    AvisoCluster *aviso_cluster = nullptr;                                // Aviso do cluster (nulo fora de um)
+    int indice_cluster = 0;                                               // Índice do spool no cluster
+
+    // Cancelamento, preempção e prazo de drenagem
+    int prioridade_preempcao = 0;                                   // Limiar da preempção (0 = desligada)
+    std::chrono::milliseconds prazo_drenagem{-1};                   // Prazo de drenagem (negativo = sem prazo)
+    std::atomic<std::chrono::steady_clock::rep> fim_drenagem{0};    // Fim do prazo, fixado no encerramento
+    std::atomic<std::uint64_t> pedidos_cancelados{0};               // Pedidos cancelados tirados da fila
+    std::atomic<std::uint64_t> descartados_drenagem{0};             // Pedidos descartados no fim do prazo
+    std::atomic<std::uint64_t> preempcoes{0};                       // Pedidos retirados por preempção
+    std::atomic<std::uint64_t> impressoes_abandonadas{0};           // Impressões abandonadas no fim do prazo
+
+    // Detecção de inatividade orientada a eventos
+    std::chrono::seconds tempo_limite_inatividade;                     // Tempo limite sem novos pedidos
+    std::atomic<std::chrono::steady_clock::rep> ultima_atividade{0};   // Instante do último pedido (steady_clock)
+    std::atomic<bool> monitor_ativo{false};                            // Indica que há um monitor aguardando eventos
+    std::mutex mutex_monitor;                                          // Mutex da espera temporizada do monitor
+    std::condition_variable cond_var_monitor;                          // Acorda o monitor antes do prazo
+
+    // Estado do backend lock-free: um balde por prioridade e a ocupação global
+    std::array<std::unique_ptr<FilaCircularMPMC<Pedido>>, NUM_PRIORIDADES> filas_prioridade;
+    alignas(64) std::atomic<int> ocupacao{0};               // Pedidos no buffer (vagas reservadas no lock-free)
+    alignas(64) std::atomic<int> consumidores_esperando{0}; // Impressoras dormindo por falta de pedidos (os dois backends)
+    std::atomic<int> produtores_esperando{0};               // Processos dormindo por falta de vagas
+    std::mutex mutex_espera;                                // Mutex usado apenas no caminho lento
+    std::condition_variable cond_var_pedido;                // Sinaliza que há pedido disponível
+    std::condition_variable cond_var_vaga;                  // Sinaliza que há vaga disponível
+
+    // Tarefas do executor estacionadas, em ordem de chegada
+    std::mutex mutex_estacionadas;                                // Protege as duas filas de tarefas
+    std::deque<TarefaRetomavel *> consumidores_estacionados_fila; // Impressoras à espera de pedidos
+    std::deque<TarefaRetomavel *> produtores_estacionados_fila;   // Processos à espera de vagas
+    std::atomic<int> consumidores_estacionados{0};                // Tamanho da fila de impressoras
+    std::atomic<int> produtores_estacionados{0};                  // Tamanho da fila de processos
+
+    // Retira os pedidos do topo enquanto mantiverem a prioridade do primeiro. Recebe mutex_buffer
+    // travado, com o buffer não vazio, e o libera antes de notificar o monitor. Uma parte de documento
+    // dividido fecha o lote, para que as outras partes fiquem com as outras impressoras.
+    std::size_t retirar_lote_travado(std::vector<Pedido> &saida, std::size_t max_n, std::unique_lock<MutexBuffer> &lock,
+                                     int id_impressora)
+    {
+        std::chrono::system_clock::time_point agora = instante_escalonamento();
+        int prioridade_lote = buffer.topo(agora, id_impressora).prioridade;
+        std::size_t removidos = 0;
+        while (saida.size() < max_n)
+        {
+            descartar_cancelados_travado(id_impressora);
+            if (buffer.vazia() || buffer.topo(agora, id_impressora).prioridade != prioridade_lote)
+                break;
+            saida.emplace_back();
+            bool saiu = buffer.retirar(agora, id_impressora, saida.back());
+            removidos += saiu ? 1 : 0;
+            if (saida.back().parte > 0)
+            {
+                divididos.entregar(saida.back(), saiu);
+                break;
+            }
+        }
+        ocupacao.store(static_cast<int>(buffer.tamanho()), std::memory_order_relaxed);
+        bool esvaziou = buffer.vazia();
+        if (removidos < saida.size())
+            cond_var_buffer.notify_all(); // O restante do documento continua na fila para as outras impressoras
+        else
+            notificar_vagas(cond_var_buffer, saida.size()); // Uma notificação para o lote inteiro
+        lock.unlock();
+        registrar_retiradas(saida.data(), removidos); // Uma parte que deixa o restante na fila vem por último
+
+        if (esvaziou && processos_ativos.load() == 0)
+            notificar_monitor();
+        return saida.size();
+    }
+
+    // Retira o próximo pedido da impressora (ou a próxima parte dele). Recebe mutex_buffer travado, com o
+    // buffer não vazio e sem cancelados no topo, e o libera antes de notificar o monitor.
+    void retirar_um_travado(Pedido &pedido, int id_impressora, std::unique_lock<MutexBuffer> &lock)
+    {
+        bool saiu = buffer.retirar(instante_escalonamento(), id_impressora, pedido);
+        if (pedido.parte > 0)
+            divididos.entregar(pedido, saiu);
+        ocupacao.store(static_cast<int>(buffer.tamanho()), std::memory_order_relaxed);
+        bool esvaziou = buffer.vazia();
+        if (saiu)
+            cond_var_buffer.notify_one(); // Notifica que um pedido foi removido
+        else
+            cond_var_buffer.notify_all(); // O restante do documento continua na fila para as outras impressoras
+        lock.unlock();
+        registrar_retiradas(&pedido, saiu ? 1 : 0);
+
+        // O último pedido retirado após o fim dos processos libera o encerramento
+        if (esvaziou && processos_ativos.load() == 0)
+            notificar_monitor();
+    }
+
+    // Espera (mutex_buffer travado) até que haja um pedido válido para a impressora, que o sistema esteja
+    // encerrando ou que o prazo passe. Os cancelados no topo saem da fila a cada verificação, e a
+    // impressora conta como ociosa enquanto dorme, o que suspende a preempção nas outras.
+    void esperar_pedido_travado(std::unique_lock<MutexBuffer> &lock, int id_impressora)
+    {
+        auto pronto = [this, id_impressora]()
+        {
+            descartar_cancelados_travado(id_impressora);
+            return !buffer.vazia() || encerrar.load();
+        };
+        if (pronto())
+            return;
+        consumidores_esperando.fetch_add(1, std::memory_order_relaxed);
+        esperar_condicao(RecursoRastro::CondVarBuffer, cond_var_buffer, lock, pronto);
+        consumidores_esperando.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Tira do topo do buffer (mutex_buffer travado) os pedidos cancelados, até o próximo pedido válido da
+    // impressora. No diário, um pedido cancelado conta como concluído e não é recuperado.
+    void descartar_cancelados_travado(int id_impressora)
+    {
+        if (!buffer.ha_cancelados())
+            return;
+        std::chrono::system_clock::time_point agora = instante_escalonamento();
+        Pedido cancelado;
+        std::size_t removidos = 0;
+        while (buffer.retirar_cancelado(agora, id_impressora, cancelado))
+        {
+            ++removidos;
+            if (cancelado.parte > 0)
+                divididos.cancelar(cancelado); // Restante de um documento com partes já entregues
+            fila_por_prioridade[indice_prioridade(cancelado.prioridade)].fetch_sub(1, std::memory_order_relaxed);
+            if (diario != nullptr)
+                diario->registrar_concluido(cancelado);
+            logger.registrar(NivelLog::Resumo, TipoEvento::PedidoCancelado, cancelado.id_processo, cancelado.id);
+        }
+        if (removidos == 0)
+            return;
+        pedidos_cancelados.fetch_add(removidos, std::memory_order_relaxed);
+        ocupacao.store(static_cast<int>(buffer.tamanho()), std::memory_order_relaxed);
+        cond_var_buffer.notify_all(); // Vagas para os produtores que esperam
+        if (buffer.vazia() && processos_ativos.load() == 0)
+            notificar_monitor();
+    }
+
+    // Descarta os pedidos que ficaram no buffer no fim do prazo de drenagem. Eles não são concluídos no
+    // diário, que os devolve ao spool na próxima abertura.
+    void descartar_na_drenagem()
+    {
+        std::size_t descartados = 0;
+        Pedido pedido;
+        if (backend == BackendSpool::LockFree)
+        {
+            for (int i = 0; i < NUM_PRIORIDADES; ++i)
+            {
+                while (filas_prioridade[i]->tentar_retirar(pedido))
+                {
+                    fila_por_prioridade[i].fetch_sub(1, std::memory_order_relaxed);
+                    ++descartados;
+                }
+            }
+            if (descartados > 0)
+                liberar_vagas(static_cast<int>(descartados), false);
+        }
+        else
+        {
+            std::lock_guard<MutexBuffer> lock(mutex_buffer);
+            std::chrono::system_clock::time_point agora = instante_escalonamento();
+            while (!buffer.vazia())
+            {
+                // Os cancelados ainda marcados saem como cancelados, não como descartados
+                descartar_cancelados_travado(0);
+                if (buffer.vazia())
+                    break;
+                pedido = buffer.topo(agora, 0);
+                fila_por_prioridade[indice_prioridade(pedido.prioridade)].fetch_sub(1, std::memory_order_relaxed);
+                if (pedido.parte > 0)
+                    divididos.cancelar(pedido); // Restante de um documento com partes já entregues
+                buffer.remover_topo();
+                ++descartados;
+            }
+            ocupacao.store(0, std::memory_order_relaxed);
+        }
+        if (descartados == 0)
+            return;
+        descartados_drenagem.fetch_add(descartados, std::memory_order_relaxed);
+        logger.registrar(NivelLog::Resumo, TipoEvento::DrenagemEsgotada, static_cast<std::int32_t>(descartados));
+    }
+
+    // Registra uma tarefa na fila de espera; a barreira pareia com a dos notificadores
+    void estacionar(std::deque<TarefaRetomavel *> &fila, std::atomic<int> &estacionadas, TarefaRetomavel *tarefa)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_estacionadas);
+            fila.push_back(tarefa);
+            estacionadas.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    // Retira a tarefa da fila. Se uma notificação já a tinha escolhido e a tarefa não vai tentar de novo
+    // (repassar), a notificação vai para a próxima da fila, para que nenhuma fique esperando por um
+    // evento já sinalizado. Uma tarefa acordada que tenta de novo não repassa: ou ela aproveita o
+    // evento, ou outra tarefa já o consumiu (repassar nesse caso faria as tarefas se acordarem em ciclo).
+    void cancelar_espera(std::deque<TarefaRetomavel *> &fila, std::atomic<int> &estacionadas, TarefaRetomavel *tarefa,
+                         bool repassar)
+    {
+        std::lock_guard<std::mutex> lock(mutex_estacionadas);
+        auto posicao = std::find(fila.begin(), fila.end(), tarefa);
+        if (posicao != fila.end())
+        {
+            fila.erase(posicao);
+            estacionadas.fetch_sub(1, std::memory_order_relaxed);
+        }
+        else if (repassar && !fila.empty())
+        {
+            fila.front()->acordar();
+            fila.pop_front();
+            estacionadas.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Acorda até quantidade tarefas estacionadas, em ordem de chegada. O chamador já publicou a mudança
+    // de estado e emitiu uma barreira seq_cst, de modo que o contador lido aqui está atualizado.
+    void retomar_estacionadas(std::deque<TarefaRetomavel *> &fila, std::atomic<int> &estacionadas, std::size_t quantidade)
+    {
+        if (quantidade == 0 || estacionadas.load(std::memory_order_relaxed) == 0)
+            return;
+        std::lock_guard<std::mutex> lock(mutex_estacionadas);
+        for (; quantidade > 0 && !fila.empty(); --quantidade)
+        {
+            fila.front()->acordar();
+            fila.pop_front();
+            estacionadas.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Avisa o cluster, quando o spool integra um, de pedidos novos
+    void avisar_cluster(std::size_t quantidade)
+    {
+        if (aviso_cluster != nullptr && quantidade > 0)
+            aviso_cluster->avisar(indice_cluster, quantidade);
+    }
+
+    // Insere um pedido no buffer (mutex_buffer travado), anexando antes o enfileiramento ao diário
+    void inserir_travado(const Pedido &pedido)
+    {
+        contar_enfileirado(pedido);
+        if (diario == nullptr)
+        {
+            buffer.inserir(pedido);
+            return;
+        }
+        Pedido registrado = pedido;
+        registrado.sequencia = diario->registrar_enfileirado(pedido);
+        buffer.inserir(std::move(registrado));
+    }
+
+    // Instante usado pelo escalonamento dinâmico (o relógio só é lido quando a ordem depende da espera)
+    std::chrono::system_clock::time_point instante_escalonamento() const
+    {
+        return buffer.escalonamento_dinamico() ? std::chrono::system_clock::now()
+                                               : std::chrono::system_clock::time_point();
+    }
+
+    // Com as políticas de despejo, tira do buffer (mutex_buffer travado) um pedido menos prioritário
+    // que o novo. Retorna true se abriu uma vaga.
+    bool despejar_travado(const Pedido &novo)
+    {
+        if (admissao.politica != PoliticaAdmissao::DespejarMenorPrioridade &&
+            admissao.politica != PoliticaAdmissao::DespejarMaisAntigo)
+            return false;
+        Pedido vitima;
+        if (!buffer.despejar(novo.prioridade, admissao.politica == PoliticaAdmissao::DespejarMaisAntigo, vitima))
+            return false;
+        registrar_despejo(vitima, novo);
+        return true;
+    }
+
+    // Versão lock-free de despejar_travado: a vaga do pedido despejado passa direto para o novo.
+    // Sem como inspecionar os baldes, as duas políticas despejam o mais antigo do balde mais baixo.
+    bool despejar_lock_free(const Pedido &novo)
+    {
+        if (admissao.politica != PoliticaAdmissao::DespejarMenorPrioridade &&
+            admissao.politica != PoliticaAdmissao::DespejarMaisAntigo)
+            return false;
+        Pedido vitima;
+        for (int i = 0; i < indice_prioridade(novo.prioridade); ++i)
+        {
+            if (filas_prioridade[i]->tentar_retirar(vitima))
+            {
+                registrar_despejo(vitima, novo);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Conta e registra o despejo; no diário, o pedido despejado conta como concluído e não é recuperado
+    void registrar_despejo(const Pedido &vitima, const Pedido &novo)
+    {
+        contadores.despejados.fetch_add(1, std::memory_order_relaxed);
+        fila_por_prioridade[indice_prioridade(vitima.prioridade)].fetch_sub(1, std::memory_order_relaxed);
+        if (diario != nullptr)
+            diario->registrar_concluido(vitima);
+        logger.registrar(NivelLog::Resumo, TipoEvento::PedidoDespejado, vitima.id_processo, vitima.id, novo.prioridade);
+    }
+
+    // Conta um pedido que entrou no buffer, para as métricas
+    void contar_enfileirado(const Pedido &pedido)
+    {
+        fila_por_prioridade[indice_prioridade(pedido.prioridade)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Conta nas métricas e anexa ao diário a retirada de pedidos pelas impressoras. Um lote tem sempre
+    // a prioridade do primeiro pedido, então basta um decremento.
+    void registrar_retiradas(const Pedido *pedidos, std::size_t quantidade)
+    {
+        if (quantidade == 0)
+            return;
+        fila_por_prioridade[indice_prioridade(pedidos[0].prioridade)].fetch_sub(static_cast<int>(quantidade),
+                                                                               std::memory_order_relaxed);
+        retirados.fetch_add(quantidade, std::memory_order_relaxed);
+        if (diario == nullptr)
+            return;
+        for (std::size_t i = 0; i < quantidade; ++i)
+            diario->registrar_retirado(pedidos[i]);
+    }
+
+    // Registra o instante da última solicitação com uma escrita atômica
+    void registrar_atividade()
+    {
+        ultima_atividade.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    // Acorda uma espera para um único item ou todas para um lote
+    template <typename Condicao>
+    static void notificar_vagas(Condicao &cond_var, std::size_t quantidade)
+    {
+        if (quantidade == 1)
+            cond_var.notify_one();
+        else if (quantidade > 1)
+            cond_var.notify_all();
+    }
+
+    // Insere um lote no buffer conforme a política de admissão: com o buffer cheio, despeja um pedido
+    // menos prioritário, espera até o prazo (no total) por espaço ou descarta na hora.
+    // Retorna a quantidade de pedidos aceitos; os demais são descartados.
+    std::size_t adicionar_lote(const Pedido *pedidos, std::size_t quantidade)
+    {
+        SPOOL_RASTRO_TRECHO(RecursoRastro::Enfileirar, quantidade);
+        registrar_atividade(); // Atualiza o tempo da última solicitação, sem locks
+        std::size_t permitidos = aplicar_limite_taxa(pedidos, quantidade);
+        if (backend == BackendSpool::LockFree)
+            return adicionar_lote_lock_free(pedidos, permitidos);
+
+        std::unique_lock<MutexBuffer> lock(mutex_buffer);
+        auto prazo = std::chrono::steady_clock::now() + prazo_admissao();
+        std::size_t aceitos = 0;
+        bool encerrando = false;
+        while (aceitos < permitidos)
+        {
+            if (encerrar.load())
+            {
+                encerrando = true;
+                break;
+            }
+
+            // Adiciona o que couber, abrindo vagas por despejo quando a política permite
+            std::size_t inicio = aceitos;
+            while (aceitos < permitidos &&
+                   (static_cast<int>(buffer.tamanho()) < capacidade || despejar_travado(pedidos[aceitos])))
+            {
+                inserir_travado(pedidos[aceitos]); // Adiciona o pedido à fila de prioridade
+                imprimir_recebimento(pedidos[aceitos]);
+                ++aceitos;
+            }
+            ocupacao.store(static_cast<int>(buffer.tamanho()), std::memory_order_relaxed);
+            notificar_vagas(cond_var_buffer, aceitos - inicio); // Notifica que novos pedidos foram adicionados
+            if (aceitos == permitidos)
+                break;
+
+            // Buffer cheio: espera por espaço até o prazo (nenhuma espera com a política Rejeitar)
+            if (!esperar_condicao_ate(RecursoRastro::CondVarBuffer, cond_var_buffer, lock, prazo, [this]()
+                                      { return static_cast<int>(buffer.tamanho()) < capacidade || encerrar.load(); }))
+                break; // Timeout: não houve espaço disponível
+        }
+        lock.unlock();
+        avisar_cluster(aceitos);
+
+        contadores.aceitos.fetch_add(aceitos, std::memory_order_relaxed);
+        if (!encerrando)
+        {
+            for (std::size_t i = aceitos; i < permitidos; ++i)
+                imprimir_descarte(pedidos[i]);
+        }
+        return aceitos;
+    }
+
+    // Registro assíncrono da mensagem de recebimento do pedido
+    static void imprimir_recebimento([[maybe_unused]] const Pedido &pedido)
+    {
+        SPOOL_LOG_PEDIDO(TipoEvento::PedidoRecebido, pedido.id_processo, pedido.id, pedido.num_paginas, pedido.prioridade);
+    }
+
+    // Contagem e registro assíncrono da mensagem de descarte por buffer cheio
+    void imprimir_descarte(const Pedido &pedido)
+    {
+        contadores.rejeitados.fetch_add(1, std::memory_order_relaxed);
+        logger.registrar(NivelLog::Resumo, TipoEvento::PedidoDescartado, pedido.id_processo, pedido.id);
+    }
+
+    // Tenta reservar uma vaga na capacidade global sem bloquear
+    bool reservar_vaga()
+    {
+        int atual = ocupacao.load(std::memory_order_relaxed);
+        while (atual < capacidade)
+        {
+            if (ocupacao.compare_exchange_weak(atual, atual + 1, std::memory_order_acquire))
+                return true;
+        }
+        return false;
+    }
+
+    // Devolve vagas à capacidade global e acorda produtores que esperam por espaço.
+    // espera_travado indica que o chamador já detém mutex_espera (predicado da espera).
+    void liberar_vagas(int quantidade, bool espera_travado)
+    {
+        int restantes = ocupacao.fetch_sub(quantidade, std::memory_order_release) - quantidade;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        retomar_estacionadas(produtores_estacionados_fila, produtores_estacionados, static_cast<std::size_t>(quantidade));
+        if (produtores_esperando.load(std::memory_order_relaxed) > 0)
+        {
+            if (espera_travado)
+            {
+                notificar_vagas(cond_var_vaga, quantidade); // Notifica que vagas foram liberadas
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(mutex_espera);
+                notificar_vagas(cond_var_vaga, quantidade);
+            }
+        }
+        // O último pedido retirado após o fim dos processos libera o encerramento
+        if (restantes == 0 && processos_ativos.load() == 0)
+            notificar_monitor();
+    }
+
+    // Acorda impressoras que dormem no caminho lento após a publicação de novos pedidos
+    void avisar_consumidores(std::size_t quantidade)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        retomar_estacionadas(consumidores_estacionados_fila, consumidores_estacionados, quantidade);
+        avisar_cluster(quantidade);
+        if (consumidores_esperando.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex_espera);
+            notificar_vagas(cond_var_pedido, quantidade);
+        }
+    }
+
+    // Insere um pedido no balde da sua prioridade depois de reservar a vaga. A vaga reservada garante
+    // espaço no balde; o laço cobre a liberação ainda em curso da célula.
+    void inserir_reservado(const Pedido &pedido)
+    {
+        contar_enfileirado(pedido);
+        FilaCircularMPMC<Pedido> &fila = *filas_prioridade[indice_prioridade(pedido.prioridade)];
+        if (diario == nullptr)
+        {
+            while (!fila.tentar_inserir(pedido))
+                std::this_thread::yield();
+        }
+        else
+        {
+            Pedido registrado = pedido;
+            registrado.sequencia = diario->registrar_enfileirado(pedido);
+            while (!fila.tentar_inserir(registrado))
+                std::this_thread::yield();
+        }
+        imprimir_recebimento(pedido);
+    }
+
+    // Tenta retirar o pedido mais prioritário, varrendo os baldes da prioridade 5 para a 1
+    bool retirar_lock_free(Pedido &pedido, bool espera_travado = false)
+    {
+        for (int i = NUM_PRIORIDADES - 1; i >= 0; --i)
+        {
+            if (filas_prioridade[i]->tentar_retirar(pedido))
+            {
+                liberar_vagas(1, espera_travado);
+                registrar_retiradas(&pedido, 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Tenta retirar até max_n pedidos do balde não vazio de maior prioridade
+    std::size_t retirar_lote_lock_free(std::vector<Pedido> &saida, std::size_t max_n, bool espera_travado = false)
+    {
+        Pedido pedido;
+        for (int i = NUM_PRIORIDADES - 1; i >= 0 && saida.empty(); --i)
+        {
+            while (saida.size() < max_n && filas_prioridade[i]->tentar_retirar(pedido))
+                saida.push_back(std::move(pedido));
+        }
+        if (!saida.empty())
+        {
+            liberar_vagas(static_cast<int>(saida.size()), espera_travado);
+            registrar_retiradas(saida.data(), saida.size());
+        }
+        return saida.size();
+    }
+
+    // Versão lock-free de adicionar_lote: só dorme quando o buffer está cheio
+    std::size_t adicionar_lote_lock_free(const Pedido *pedidos, std::size_t quantidade)
+    {
+        auto prazo = std::chrono::steady_clock::now() + prazo_admissao();
+        std::size_t aceitos = 0;
+        std::size_t publicados = 0;
+        bool encerrando = false;
+        for (; aceitos < quantidade; ++aceitos)
+        {
+            // O encerramento é verificado antes da reserva: uma vaga aberta por despejo já tirou outro
+            // pedido do buffer, então o novo pedido precisa ser publicado
+            if (encerrar.load())
+            {
+                encerrando = true;
+                break;
+            }
+            bool reservado = reservar_vaga() || despejar_lock_free(pedidos[aceitos]);
+            if (!reservado && admissao.politica != PoliticaAdmissao::Rejeitar)
+            {
+                // Publica o que já entrou antes de dormir, para que as impressoras liberem espaço
+                avisar_consumidores(aceitos - publicados);
+                publicados = aceitos;
+
+                // Caminho lento: espera até o prazo de admissão por uma vaga
+                std::unique_lock<std::mutex> lock(mutex_espera);
+                produtores_esperando.fetch_add(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                cond_var_vaga.wait_until(lock, prazo, [this, &reservado]()
+                                         { return encerrar.load() || (reservado = reservar_vaga()); });
+                produtores_esperando.fetch_sub(1);
+            }
+            if (!reservado)
+            {
+                encerrando = encerrar.load(); // Sem encerramento, o prazo passou sem espaço disponível
+                break;
+            }
+
+            inserir_reservado(pedidos[aceitos]);
+        }
+        avisar_consumidores(aceitos - publicados); // Uma notificação para o restante do lote
+        contadores.aceitos.fetch_add(aceitos, std::memory_order_relaxed);
+
+        if (!encerrando)
+        {
+            for (std::size_t i = aceitos; i < quantidade; ++i)
+                imprimir_descarte(pedidos[i]);
+        }
+        return aceitos;
+    }
+
+    // Versão lock-free de get_pedido: só dorme quando todos os baldes estão vazios
+    bool get_pedido_lock_free(Pedido &pedido)
+    {
+        if (retirar_lock_free(pedido))
+            return true;
+
+        // Caminho lento: espera até que haja um pedido ou que o sistema esteja encerrando
+        bool obtido = false;
+        std::unique_lock<std::mutex> lock(mutex_espera);
+        consumidores_esperando.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cond_var_pedido.wait(lock, [this, &pedido, &obtido]()
+                             { return (obtido = retirar_lock_free(pedido, true)) || encerrar.load(); });
+        consumidores_esperando.fetch_sub(1);
+        return obtido; // false: fila vazia e o sistema está encerrando
+    }
+
+    // Versão lock-free de get_pedidos
+    std::size_t get_pedidos_lock_free(std::vector<Pedido> &saida, std::size_t max_n)
+    {
+        if (retirar_lote_lock_free(saida, max_n) > 0)
+            return saida.size();
+
+        std::unique_lock<std::mutex> lock(mutex_espera);
+        consumidores_esperando.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cond_var_pedido.wait(lock, [this, &saida, max_n]()
+                             { return retirar_lote_lock_free(saida, max_n, true) > 0 || encerrar.load(); });
+        consumidores_esperando.fetch_sub(1);
+        return saida.size(); // 0: fila vazia e o sistema está encerrando
+    }
+
+    // Função de monitoramento de inatividade: dorme até o prazo de inatividade ou até ser notificada
+    void monitorar_inatividade()
+    {
+        logger.registrar(NivelLog::Resumo, TipoEvento::MonitorIniciado, static_cast<std::int32_t>(tempo_limite_inatividade.count()));
+
+        std::unique_lock<std::mutex> lock(mutex_monitor);
+        while (!encerrar.load())
+        {
+            // Encerramento antecipado: nenhum processo ativo e nenhum pedido na fila
+            if (processos_ativos.load() == 0 && ocupacao.load() == 0)
+            {
+                logger.registrar(NivelLog::Resumo, TipoEvento::EncerramentoSemTrabalho);
+                break;
+            }
+
+            // O prazo é recalculado a cada despertar a partir do último pedido registrado
+            std::chrono::steady_clock::time_point prazo(
+                std::chrono::steady_clock::duration(ultima_atividade.load(std::memory_order_relaxed)));
+            prazo += tempo_limite_inatividade;
+            if (std::chrono::steady_clock::now() >= prazo)
+            {
+                logger.registrar(NivelLog::Resumo, TipoEvento::EncerramentoInatividade,
+                                 static_cast<std::int32_t>(tempo_limite_inatividade.count()));
+                break;
+            }
+            cond_var_monitor.wait_until(lock, prazo);
+        }
+        monitor_ativo.store(false);
+        lock.unlock();
+        encerrar_spool(); // Sinaliza para as impressoras encerrarem e notifica todas
+    }
+};
+
+// Anel de hash consistente que distribui processos entre spools. Cada spool ocupa NOS_VIRTUAIS pontos
+// do anel e um processo vai para o primeiro ponto depois do hash do seu identificador: acrescentar um
+// spool só move os processos que caem nos novos pontos (cerca de 1/N deles), e os pontos virtuais
+// equilibram a carga entre os spools.
+class AnelConsistente
+{
+public:
+    static constexpr int NOS_VIRTUAIS = 64; // Pontos de cada spool no anel
+
+    // Construtor que posiciona os pontos dos spools 0..num_spools-1
+    explicit AnelConsistente(int num_spools) : quantidade_spools(num_spools)
+    {
+        pontos.reserve(static_cast<std::size_t>(num_spools) * NOS_VIRTUAIS);
+        for (int spool = 0; spool < num_spools; ++spool)
+        {
+            for (int no = 0; no < NOS_VIRTUAIS; ++no)
+                pontos.emplace_back(misturar((static_cast<std::uint64_t>(spool) + 1) << 32 | static_cast<std::uint32_t>(no)), spool);
+        }
+        std::sort(pontos.begin(), pontos.end());
+    }
+
+    // Spool (0 a num_spools-1) responsável pelo processo
+    int spool_do_processo(int id_processo) const
+    {
+        std::uint64_t chave = misturar(static_cast<std::uint32_t>(id_processo));
+        auto ponto = std::upper_bound(pontos.begin(), pontos.end(), chave,
+                                      [](std::uint64_t valor, const std::pair<std::uint64_t, int> &ponto)
+                                      { return valor < ponto.first; });
+        return ponto == pontos.end() ? pontos.front().second : ponto->second; // O anel dá a volta
+    }
+
+    // Quantidade de spools no anel
+    int num_spools() const
+    {
+        return quantidade_spools;
+    }
+
+private:
+    // Finalização do splitmix64: espalha chaves próximas por todo o anel
+    static std::uint64_t misturar(std::uint64_t valor)
+    {
+        valor += 0x9E3779B97F4A7C15ull;
+        valor = (valor ^ (valor >> 30)) * 0xBF58476D1CE4E5B9ull;
+        valor = (valor ^ (valor >> 27)) * 0x94D049BB133111EBull;
+        return valor ^ (valor >> 31);
+    }
+
+    int quantidade_spools;                           // Quantidade de spools
+    std::vector<std::pair<std::uint64_t, int>> pontos; // (posição no anel, spool), em ordem de posição
+};
+
+// Vários spools independentes no mesmo processo (por andar ou por nó NUMA), cada um com a sua fila, o
+// seu monitor e as suas impressoras. Os processos enviam ao spool escolhido pelo anel de hash
+// consistente, então os envios de spools diferentes não disputam o mesmo lock. Uma impressora sem
+// pedidos no próprio spool rouba do vizinho mais carregado metade da fila dele (até um lote). Sem
+// pedidos em nenhum spool, a impressora dorme no AvisoCluster, que acorda primeiro as impressoras do
+// spool que recebeu pedidos, de modo que o roubo só acontece quando elas não dão conta.
+class ClusterSpool
+{
+public:
+    // Construtor que cria num_spools spools com os mesmos parâmetros (a capacidade vale para cada um)
+    ClusterSpool(int num_spools, int capacidade_buffer, BackendSpool backend, int tempo_limite_inatividade_s,
+                 const ConfiguracaoAdmissao &admissao, const ConfiguracaoEscalonamento &escalonamento,
+                 const ConfiguracaoDespacho &despacho)
+        : anel(num_spools), aviso(num_spools)
+    {
+        for (int i = 0; i < num_spools; ++i)
+        {
+            spools.push_back(std::make_unique<Spool>(capacidade_buffer, backend, tempo_limite_inatividade_s, nullptr,
+                                                     admissao, escalonamento, despacho));
+            spools.back()->integrar_cluster(aviso, i);
+        }
+    }
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    ClusterSpool(const ClusterSpool &) = delete;
+    ClusterSpool &operator=(const ClusterSpool &) = delete;
+
+    // Encerra os spools e aguarda os monitores ainda ativos
+    ~ClusterSpool()
+    {
+        if (!monitores.empty())
+        {
+            encerrar_spools();
+            wait_until_finished();
+        }
+    }
+
+    // Spool de índice 0 a num_spools-1
+    Spool &spool(int indice)
+    {
+        return *spools[indice];
+    }
+
+    // Spool que recebe os pedidos do processo
+    Spool &spool_do_processo(int id_processo)
+    {
+        return *spools[anel.spool_do_processo(id_processo)];
+    }
+
+    // Quantidade de spools
+    int num_spools() const
+    {
+        return static_cast<int>(spools.size());
+    }
+
+    // Pedidos retirados de um spool vizinho
+    std::uint64_t roubados() const
+    {
+        return pedidos_roubados.load(std::memory_order_relaxed);
+    }
+
+    // Obtém até max_n pedidos para uma impressora do spool indice: do próprio spool enquanto houver, senão
+    // do vizinho mais carregado. origem recebe o spool de onde os pedidos saíram. Retorna 0 só quando
+    // todos os spools estão encerrando e vazios.
+    std::size_t get_pedidos(int indice, std::vector<Pedido> &saida, std::size_t max_n, int id_impressora, Spool *&origem)
+    {
+        Spool &local = *spools[indice];
+        while (true)
+        {
+            std::uint64_t versao = aviso.versao();
+            if (local.tentar_get_pedidos(saida, max_n, id_impressora) > 0)
+            {
+                origem = &local;
+                return saida.size();
+            }
+            if (roubar(indice, saida, max_n, origem) > 0)
+                return saida.size();
+            if (todos_encerrados())
+                return 0;
+
+            // Com todos os spools encerrando, nenhum aviso vem mais: os pedidos restantes estão saindo
+            // com outras impressoras ou sendo descartados na drenagem
+            if (todos_encerrando())
+                std::this_thread::yield();
+            else
+                aviso.esperar(indice, versao);
+        }
+    }
+
+    // Inicia o monitor de inatividade de cada spool; cada spool encerra pelo seu próprio monitor
+    void iniciar_monitores()
+    {
+        for (auto &spool : spools)
+            monitores.emplace_back(&Spool::wait_until_finished, spool.get());
+    }
+
+    // Acorda os monitores de todos os spools (o último processo só acorda o monitor do próprio spool)
+    void notificar_monitores()
+    {
+        for (auto &spool : spools)
+            spool->notificar_monitor();
+    }
+
+    // Espera o encerramento de todos os spools
+    void wait_until_finished()
+    {
+        for (auto &monitor : monitores)
+            monitor.join();
+        monitores.clear();
+    }
+
+    // Sinaliza o encerramento de todos os spools
+    void encerrar_spools()
+    {
+        for (auto &spool : spools)
+            spool->encerrar_spool();
+    }
+
+    // Contadores de admissão somados entre os spools
+    ResumoAdmissao contadores_admissao() const
+    {
+        ResumoAdmissao soma;
+        for (const auto &spool : spools)
+        {
+            ResumoAdmissao parcial = spool->contadores_admissao().ler();
+            soma.aceitos += parcial.aceitos;
+            soma.rejeitados += parcial.rejeitados;
+            soma.limitados += parcial.limitados;
+            soma.despejados += parcial.despejados;
+        }
+        return soma;
+    }
+
+    // Cancelamentos, descartes na drenagem, preempções e abandonos somados entre os spools
+    ResumoInterrupcoes interrupcoes() const
+    {
+        ResumoInterrupcoes soma;
+        for (const auto &spool : spools)
+        {
+            ResumoInterrupcoes parcial = spool->interrupcoes();
+            soma.cancelados += parcial.cancelados;
+            soma.descartados_drenagem += parcial.descartados_drenagem;
+            soma.preempcoes += parcial.preempcoes;
+            soma.impressoes_abandonadas += parcial.impressoes_abandonadas;
+        }
+        return soma;
+    }
+
+private:
+    // Retira pedidos do vizinho com a maior fila, começando pelo seguinte ao spool indice para que
+    // impressoras de spools diferentes não escolham sempre a mesma vítima
+    std::size_t roubar(int indice, std::vector<Pedido> &saida, std::size_t max_n, Spool *&origem)
+    {
+        int vitima = -1;
+        int maior = 0;
+        for (int passo = 1; passo < num_spools(); ++passo)
+        {
+            int vizinho = (indice + passo) % num_spools();
+            int ocupacao = spools[vizinho]->ocupacao_atual();
+            if (ocupacao > maior)
+            {
+                maior = ocupacao;
+                vitima = vizinho;
+            }
+        }
+        if (vitima < 0)
+            return 0;
+
+        std::size_t metade = static_cast<std::size_t>(maior + 1) / 2;
+        std::size_t retirados = spools[vitima]->tentar_get_pedidos(saida, std::min(max_n, metade));
+        if (retirados > 0)
+        {
+            origem = spools[vitima].get();
+            pedidos_roubados.fetch_add(retirados, std::memory_order_relaxed);
+        }
+        return retirados;
+    }
+
+    // Um spool encerrado pode ainda ter pedidos (encerramento por inatividade), e um spool sem
+    // impressoras só é esvaziado por roubo
+    bool todos_encerrados() const
+    {
+        for (const auto &spool : spools)
+        {
+            if (!spool->encerrando() || spool->ocupacao_atual() > 0)
+                return false;
+        }
+        return true;
+    }
+
+    // Todos os spools receberam o sinal de encerramento, mesmo que ainda tenham pedidos
+    bool todos_encerrando() const
+    {
+        for (const auto &spool : spools)
+        {
+            if (!spool->encerrando())
+                return false;
+        }
+        return true;
+    }
+
+    AnelConsistente anel;                           // Distribuição dos processos entre os spools
+    AvisoCluster aviso;                             // Acorda as impressoras ociosas de todos os spools
+    std::vector<std::unique_ptr<Spool>> spools;     // Spools independentes (um mutex e um monitor cada)
+    std::vector<std::thread> monitores;             // Threads que aguardam os monitores dos spools
+    std::atomic<std::uint64_t> pedidos_roubados{0}; // Pedidos retirados de um vizinho
+};
+
+// Classe que representa uma Impressora
+class Impressora
+{
+public:
+    // Construtor que inicializa a impressora com seu ID, referência ao spool, colunas de registros próprias,
+    // tempo por página e quantidade máxima de pedidos retirados de uma vez. Em um cluster, spool é o
+    // spool da impressora (de índice indice_spool) e os spools vizinhos são usados quando ele está vazio.
+    Impressora(int id, Spool &spool, ColunasImpressora &colunas, int tempo_por_pagina_ms, int tamanho_lote = 1,
+               ClusterSpool *cluster = nullptr, int indice_spool = 0)
+        : id_impressora(id), spool_ref(spool), colunas_ref(colunas),
+          tempo_por_pagina_ms(tempo_por_pagina_ms), tamanho_lote(tamanho_lote),
+          cluster(cluster), indice_spool(indice_spool) {}
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    Impressora(const Impressora &) = delete;
+    Impressora &operator=(const Impressora &) = delete;
+
+    // Função que inicia a thread da impressora
+    void start()
+    {
+        thread_impressora = std::thread(&Impressora::run, this);
+    }
+
+    // Função que espera a thread da impressora terminar
+    void join()
+    {
+        if (thread_impressora.joinable())
+            thread_impressora.join();
+    }
+
+private:
+    int id_impressora;                                        // Identificador da impressora
+    Spool &spool_ref;                                         // Referência ao spool de impressão
+    ColunasImpressora &colunas_ref;                           // Registros desta impressora (sem lock)
+    int tempo_por_pagina_ms;                                  // Tempo de impressão por página
+    int tamanho_lote;                                         // Pedidos retirados do spool por vez
+    ClusterSpool *cluster;                                    // Cluster da impressora (nulo com um único spool)
+    int indice_spool;                                         // Índice do spool da impressora no cluster
+    std::thread thread_impressora;                            // Thread da impressora
+
+    // Função que simula o funcionamento da impressora
+    void run()
+    {
+        std::vector<Pedido> lote;
+        lote.reserve(tamanho_lote);
+        while (true)
+        {
+            // Retira um pedido, ou um lote de pedidos compatíveis, do spool (em um cluster, talvez de um vizinho)
+            bool existe_pedido;
+            Spool *origem = &spool_ref;
+            if (cluster != nullptr)
+            {
+                existe_pedido = cluster->get_pedidos(indice_spool, lote, tamanho_lote, id_impressora, origem) > 0;
+            }
+            else if (tamanho_lote > 1)
+            {
+                existe_pedido = spool_ref.get_pedidos(lote, tamanho_lote, id_impressora) > 0;
+            }
+            else
+            {
+                lote.resize(1);
+                existe_pedido = spool_ref.get_pedido(lote.front(), id_impressora);
+            }
+            if (!existe_pedido)
+            {
+                // Nenhum pedido para processar e o spool está encerrando
+                logger.registrar(NivelLog::Resumo, TipoEvento::ImpressoraEncerrando, id_impressora);
+                break;
+            }
+
+            for (const Pedido &pedido : lote)
+                processar_pedido(pedido, *origem);
+        }
+    }
+
+    // Função que simula a impressão de um pedido retirado de origem e registra o resultado
+    void processar_pedido(const Pedido &pedido, Spool &origem)
+    {
+        // Mensagem de início do processamento
+        SPOOL_LOG_PEDIDO(TipoEvento::ImpressaoIniciada, id_impressora, pedido.id_processo, pedido.id,
+                         pedido.num_paginas, pedido.prioridade);
+
+        colunas_ref.marcar_ocupada(true);
+        if (origem.impressao_interrompivel())
+        {
+            imprimir_por_pagina(pedido, origem);
+            colunas_ref.marcar_ocupada(false);
+            return;
+        }
+        auto inicio = std::chrono::system_clock::now(); // Horário de início da impressão
+        // Simula o tempo de impressão
+        std::this_thread::sleep_for(std::chrono::milliseconds(tempo_por_pagina_ms * pedido.num_paginas));
+        auto fim = std::chrono::system_clock::now(); // Horário de fim da impressão
+
+        // Calcula o tempo total de impressão
+        std::chrono::microseconds duracao = std::chrono::duration_cast<std::chrono::microseconds>(fim - inicio);
+
+        // Registro da impressão nas colunas da própria impressora, sem lock global
+        bool conclui_documento = origem.concluir_pedido(pedido);
+        colunas_ref.acrescentar(pedido, inicio, duracao, conclui_documento);
+        colunas_ref.marcar_ocupada(false);
+
+        // Mensagem de conclusão do processamento
+        SPOOL_LOG_PEDIDO(TipoEvento::ImpressaoConcluida, id_impressora, pedido.id_processo, pedido.id);
+    }
+
+    // Imprime o pedido página a página. Entre as páginas, um pedido do spool que pode interromper este
+    // (Spool::preempcao_pendente) é retirado e impresso antes do restante, que é retomado depois em um
+    // novo trecho; cada trecho vira um registro e só o último conclui o pedido. Cada interrupção aninhada
+    // tem prioridade maior que a anterior, então a recursão tem no máximo NUM_PRIORIDADES - 1 níveis.
+    // No fim do prazo de drenagem, o restante da impressão é abandonado.
+    void imprimir_por_pagina(const Pedido &pedido, Spool &origem)
+    {
+        Pedido trecho = pedido;
+        int restantes = pedido.num_paginas;
+        bool retomada = false;
+        while (!retomada || !origem.drenagem_esgotada())
+        {
+            auto inicio = std::chrono::system_clock::now(); // Horário de início do trecho
+            int impressas = 0;
+            Pedido urgente;
+            bool preemptada = false;
+            while (impressas < restantes)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(tempo_por_pagina_ms));
+                ++impressas;
+                if (impressas == restantes || origem.drenagem_esgotada())
+                    break;
+                if (origem.preempcao_pendente(pedido.prioridade) &&
+                    origem.retirar_preemptivo(pedido.prioridade, urgente, id_impressora))
+                {
+                    preemptada = true;
+                    break;
+                }
+            }
+            std::chrono::microseconds duracao =
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - inicio);
+            trecho.num_paginas = impressas;
+            if (impressas == restantes)
+            {
+                bool conclui_documento = origem.concluir_pedido(pedido);
+                colunas_ref.acrescentar(trecho, inicio, duracao, conclui_documento, retomada);
+                SPOOL_LOG_PEDIDO(TipoEvento::ImpressaoConcluida, id_impressora, pedido.id_processo, pedido.id);
+                return;
+            }
+            colunas_ref.acrescentar(trecho, inicio, duracao, false, retomada);
+            restantes -= impressas;
+            retomada = true;
+            if (preemptada)
+            {
+                // Interrompida por um pedido mais prioritário, que é impresso antes do restante
+                SPOOL_LOG_PEDIDO(TipoEvento::ImpressaoInterrompida, id_impressora, pedido.id_processo, pedido.id,
+                                 restantes, urgente.prioridade);
+                processar_pedido(urgente, origem);
+                colunas_ref.marcar_ocupada(true);
+            }
+        }
+
+        // Prazo de drenagem esgotado: o restante não é impresso
+        origem.registrar_abandono(pedido);
+        logger.registrar(NivelLog::Resumo, TipoEvento::ImpressaoInterrompida, id_impressora, pedido.id_processo,
+                         pedido.id, restantes, 0);
+    }
+};
+
+// Processo de chegada dos pedidos de cada Processo; intervalo_ms é sempre o intervalo médio
+enum class ProcessoChegada : std::uint8_t
+{
+    Fixo,    // Intervalo constante
+    Poisson, // Intervalos exponenciais
+    Rajadas, // Liga/desliga: Poisson nos períodos ligados, silêncio nos desligados (durações exponenciais)
+    Diurno   // Poisson com a taxa variando em senoide ao longo do período
+};
+
+// Nome do processo de chegada, como aceito na linha de comando
+const char *nome_chegada(ProcessoChegada chegada)
+{
+    switch (chegada)
+    {
+    case ProcessoChegada::Fixo:
+        return "fixo";
+    case ProcessoChegada::Poisson:
+        return "poisson";
+    case ProcessoChegada::Rajadas:
+        return "rajadas";
+    case ProcessoChegada::Diurno:
+        return "diurno";
+    }
+    return "";
+}
+
+// Distribuição do número de páginas entre paginas_min e paginas_max
+enum class DistribuicaoPaginas : std::uint8_t
+{
+    Uniforme, // Todos os tamanhos com a mesma probabilidade
+    Pareto    // Pareto limitada: muitos documentos pequenos e uma cauda longa de grandes
+};
+
+// Pedido de um trace gravado
+struct PedidoTrace
+{
+    std::int64_t instante_us; // Solicitação, em µs desde o início do trace
+    std::int32_t num_paginas; // Número de páginas
+    std::int32_t prioridade;  // Prioridade (1 a 5)
+};
+
+// Carga gravada, lida de um arquivo com uma linha por pedido, "instante_ms,processo,paginas,prioridade"
+// (instante em ms, com fração opcional, em qualquer origem; o mais antigo vira o instante 0). Linhas
+// vazias e iniciadas por '#' são ignoradas, assim como um cabeçalho na primeira linha. Os pedidos são
+// agrupados por processo em ordem de instante; o arquivo é mapeado em memória nos sistemas POSIX.
+class TraceCarga
+{
+public:
+    static constexpr int MAXIMO_PROCESSOS = 100000; // Maior identificador de processo aceito
+
+    // Lê o trace do arquivo; um erro de formato informa a linha
+    static std::shared_ptr<const TraceCarga> ler(const std::string &caminho)
+    {
+        auto trace = std::make_shared<TraceCarga>();
+#ifdef _WIN32
+        std::ifstream arquivo(caminho, std::ios::binary);
+        if (!arquivo)
+            throw std::invalid_argument("trace: não foi possível abrir '" + caminho + "'");
+        std::string conteudo((std::istreambuf_iterator<char>(arquivo)), std::istreambuf_iterator<char>());
+        trace->interpretar(conteudo.data(), conteudo.data() + conteudo.size(), caminho);
+#else
+        int arquivo = ::open(caminho.c_str(), O_RDONLY);
+        if (arquivo < 0)
+            throw std::invalid_argument("trace: não foi possível abrir '" + caminho + "'");
+        struct stat estado;
+        if (::fstat(arquivo, &estado) != 0 || estado.st_size == 0)
+        {
+            ::close(arquivo);
+            throw std::invalid_argument("trace: arquivo vazio ou ilegível '" + caminho + "'");
+        }
+        std::size_t bytes = static_cast<std::size_t>(estado.st_size);
+        void *mapa = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, arquivo, 0);
+        ::close(arquivo);
+        if (mapa == MAP_FAILED)
+            throw std::invalid_argument("trace: não foi possível mapear '" + caminho + "'");
+        ::madvise(mapa, bytes, MADV_SEQUENTIAL);
+        try
+        {
+            const char *inicio = static_cast<const char *>(mapa);
+            trace->interpretar(inicio, inicio + bytes, caminho);
+        }
+        catch (...)
+        {
+            ::munmap(mapa, bytes);
+            throw;
+        }
+        ::munmap(mapa, bytes);
+#endif
+        return trace;
+    }
+
+    // Maior identificador de processo do trace
+    int num_processos() const
+    {
+        return static_cast<int>(por_processo.size());
+    }
+
+    // Pedidos do processo em ordem de instante (vazio para um processo ausente do trace)
+    const std::vector<PedidoTrace> &pedidos(int id_processo) const
+    {
+        static const std::vector<PedidoTrace> nenhum;
+        if (id_processo < 1 || id_processo > num_processos())
+            return nenhum;
+        return por_processo[id_processo - 1];
+    }
+
+    // Quantidade total de pedidos
+    std::size_t total() const
+    {
+        return quantidade;
+    }
+
+private:
+    std::vector<std::vector<PedidoTrace>> por_processo; // Pedidos de cada processo (índice = identificador - 1)
+    std::size_t quantidade = 0;                         // Pedidos em todos os processos
+
+    // Interpreta as linhas do arquivo, sem cópias nem alocações por linha
+    void interpretar(const char *atual, const char *fim, const std::string &caminho)
+    {
+        std::int64_t menor_instante = std::numeric_limits<std::int64_t>::max();
+        int numero_linha = 0;
+        while (atual < fim)
+        {
+            const char *fim_linha = static_cast<const char *>(std::memchr(atual, '\n', static_cast<std::size_t>(fim - atual)));
+            if (fim_linha == nullptr)
+                fim_linha = fim;
+            const char *proxima = fim_linha < fim ? fim_linha + 1 : fim;
+            ++numero_linha;
+            while (fim_linha > atual && (fim_linha[-1] == '\r' || fim_linha[-1] == ' ' || fim_linha[-1] == '\t'))
+                --fim_linha;
+            while (atual < fim_linha && (*atual == ' ' || *atual == '\t'))
+                ++atual;
+            bool cabecalho = numero_linha == 1 && atual < fim_linha && (*atual < '0' || *atual > '9');
+            if (atual == fim_linha || *atual == '#' || cabecalho)
+            {
+                atual = proxima;
+                continue;
+            }
+
+            PedidoTrace pedido;
+            std::int64_t processo = 0;
+            std::int64_t paginas = 0;
+            std::int64_t prioridade = 0;
+            const char *cursor = atual;
+            bool valido = ler_instante(cursor, fim_linha, pedido.instante_us) && ler_separador(cursor, fim_linha) &&
+                          ler_inteiro(cursor, fim_linha, processo) && ler_separador(cursor, fim_linha) &&
+                          ler_inteiro(cursor, fim_linha, paginas) && ler_separador(cursor, fim_linha) &&
+                          ler_inteiro(cursor, fim_linha, prioridade) && cursor == fim_linha;
+            if (!valido)
+                throw std::invalid_argument(caminho + ":" + std::to_string(numero_linha) +
+                                            ": esperado 'instante_ms,processo,paginas,prioridade'");
+            if (processo < 1 || processo > MAXIMO_PROCESSOS || paginas < 1 ||
+                paginas > std::numeric_limits<std::int32_t>::max() || prioridade < PRIORIDADE_MINIMA ||
+                prioridade > PRIORIDADE_MAXIMA)
+                throw std::invalid_argument(caminho + ":" + std::to_string(numero_linha) +
+                                            ": processo, páginas ou prioridade fora dos limites");
+            pedido.num_paginas = static_cast<std::int32_t>(paginas);
+            pedido.prioridade = static_cast<std::int32_t>(prioridade);
+            if (processo > num_processos())
+                por_processo.resize(static_cast<std::size_t>(processo));
+            por_processo[processo - 1].push_back(pedido);
+            menor_instante = std::min(menor_instante, pedido.instante_us);
+            ++quantidade;
+            atual = proxima;
+        }
+        if (quantidade == 0)
+            throw std::invalid_argument("trace: nenhum pedido em '" + caminho + "'");
+
+        for (auto &pedidos : por_processo)
+        {
+            for (PedidoTrace &pedido : pedidos)
+                pedido.instante_us -= menor_instante;
+            std::stable_sort(pedidos.begin(), pedidos.end(), [](const PedidoTrace &a, const PedidoTrace &b)
+                             { return a.instante_us < b.instante_us; });
+        }
+    }
+
+    static bool ler_inteiro(const char *&cursor, const char *fim, std::int64_t &valor)
+    {
+        auto [lido, erro] = std::from_chars(cursor, fim, valor);
+        if (erro != std::errc() || lido == cursor)
+            return false;
+        cursor = lido;
+        return true;
+    }
+
+    // Instante em ms com até três casas decimais (as demais são ignoradas), convertido em µs
+    static bool ler_instante(const char *&cursor, const char *fim, std::int64_t &instante_us)
+    {
+        std::int64_t ms = 0;
+        if (!ler_inteiro(cursor, fim, ms) || ms < 0 || ms > std::numeric_limits<std::int64_t>::max() / 1000)
+            return false;
+        std::int64_t fracao_us = 0;
+        if (cursor < fim && *cursor == '.')
+        {
+            ++cursor;
+            for (std::int64_t peso = 100; cursor < fim && *cursor >= '0' && *cursor <= '9'; ++cursor, peso /= 10)
+                fracao_us += (*cursor - '0') * peso;
+        }
+        instante_us = ms * 1000 + fracao_us;
+        return true;
+    }
+
+    // Vírgula, com espaços opcionais em volta
+    static bool ler_separador(const char *&cursor, const char *fim)
+    {
+        while (cursor < fim && (*cursor == ' ' || *cursor == '\t'))
+            ++cursor;
+        if (cursor == fim || *cursor != ',')
+            return false;
+        ++cursor;
+        while (cursor < fim && (*cursor == ' ' || *cursor == '\t'))
+            ++cursor;
+        return true;
+    }
+};
+
+// Parâmetros da carga gerada por cada Processo
+struct ParametrosCarga
+{
+    int pedidos_por_processo = 5;                        // Pedidos gerados por processo
+    int paginas_min = 1;                                 // Menor número de páginas por documento
+    int paginas_max = 10;                                // Maior número de páginas por documento
+    DistribuicaoPaginas distribuicao_paginas = DistribuicaoPaginas::Uniforme; // Distribuição das páginas
+    double alfa_pareto = 1.2;                            // Forma da Pareto (menor = cauda mais longa)
+    std::vector<double> pesos_prioridade{1, 1, 1, 1, 1}; // Peso relativo de cada prioridade (1 a 5)
+    int intervalo_ms = 100;                              // Intervalo médio entre pedidos de um processo
+    ProcessoChegada chegada = ProcessoChegada::Fixo;     // Processo de chegada dos pedidos
+    int rajada_ligada_ms = 1000;                         // Duração média dos períodos com envios (rajadas)
+    int rajada_desligada_ms = 4000;                      // Duração média dos períodos em silêncio (rajadas)
+    int periodo_diurno_s = 86400;                        // Período do ciclo diurno
+    double amplitude_diurna = 0.8;                       // Variação relativa da taxa no ciclo diurno (0 a 1)
+    double fracao_cancelada = 0.0;                       // Fração dos pedidos aceitos que o processo cancela logo depois
+    std::uint32_t semente = 0;                           // Semente dos geradores (0 = aleatória)
+    std::shared_ptr<const TraceCarga> trace;             // Carga gravada a reproduzir (nulo = carga sintética)
+};
+
+// Parâmetros de uma execução, vindos do modo interativo, da linha de comando ou de um arquivo
+struct Configuracao
+{
+    int num_processos = 1;                       // Quantidade de processos
+    int num_impressoras = 1;                     // Quantidade de impressoras
+    int capacidade_buffer = 10;                  // Capacidade máxima do buffer
+    int tempo_por_pagina_ms = 10;                // Tempo de impressão por página
+    BackendSpool backend = BackendSpool::Mutex;  // Backend da fila do spool
+    int tempo_limite_inatividade_s = 30;         // Tempo limite de inatividade antes do relatório
+    int tamanho_lote = 1;                        // Lote de envio (processos) e de retirada (impressoras)
+    int paginas_por_parte = 0;                   // Documentos maiores são impressos em partes deste tamanho (0 = inteiros)
+    int prioridade_preempcao = 0;                // Prioridade mínima que interrompe impressões menos prioritárias (0 = sem preempção)
+    int prazo_drenagem_ms = -1;                  // Prazo para esvaziar o buffer no encerramento (-1 = sem prazo)
+    NivelLog nivel_log = NivelLog::Detalhado;    // Nível de log durante a execução
+    bool headless = false;                       // Execução sem perguntas, com resumo em JSON
+    bool simulado = false;                       // Motor de eventos discretos em vez de threads reais
+    bool executor = false;                       // Processos e impressoras como tarefas em um pool de threads
+    int threads_executor = 0;                    // Threads do pool (0 = núcleos disponíveis)
+    int porta_metricas = 0;                      // Porta do endpoint de métricas em 127.0.0.1 (0 = desligado)
+    int num_spools = 1;                          // Spools independentes, com roubo entre eles (motor threads)
+    std::string arquivo_relatorio;               // Relatório completo em arquivo (modo headless)
+    std::string arquivo_trace;                   // Trace de pedidos a reproduzir (vazio = carga sintética)
+    FormatoRelatorio formato_relatorio = FormatoRelatorio::Texto; // Formato do relatório em arquivo
+    int threads_relatorio = 1;                   // Threads que formatam o relatório (0 = núcleos disponíveis)
+    std::string diretorio_diario;                // Diário persistente do spool (vazio = desligado)
+    int diario_sincronizacao_ms = 10;            // Intervalo do commit em grupo (0 = sem msync)
+    int diario_registros_sincronizacao = 65536;  // Registros que antecipam o commit em grupo
+    std::string arquivo_rastro;                  // Trace do caminho quente (vazio = desligado; exige -DSPOOL_RASTREAMENTO)
+    ConfiguracaoAdmissao admissao;               // Política com o buffer cheio e limite de taxa por processo
+    ConfiguracaoEscalonamento escalonamento;     // Envelhecimento e espera máxima por prioridade (backend mutex)
+    PoliticaDespacho despacho = PoliticaDespacho::Compartilhada; // Distribuição dos pedidos (backend mutex)
+    std::vector<int> tempos_por_pagina_impressoras; // Tempo por página de cada impressora, repetido em ciclo
+                                                    // (vazio = tempo_por_pagina_ms para todas)
+    ParametrosCarga carga;                       // Carga gerada pelos processos
+};
+
+// Tempo por página da impressora id_impressora (identificadores começam em 1)
+int tempo_por_pagina_impressora(const Configuracao &config, int id_impressora)
+{
+    if (config.tempos_por_pagina_impressoras.empty())
+        return config.tempo_por_pagina_ms;
+    return config.tempos_por_pagina_impressoras[(id_impressora - 1) % config.tempos_por_pagina_impressoras.size()];
+}
+
+// Política de despacho e velocidade de cada impressora, como o spool e o simulador esperam
+ConfiguracaoDespacho configuracao_despacho(const Configuracao &config)
+{
+    ConfiguracaoDespacho despacho;
+    despacho.politica = config.despacho;
+    despacho.paginas_por_parte = config.paginas_por_parte;
+    despacho.prioridade_preempcao = config.prioridade_preempcao;
+    despacho.prazo_drenagem_ms = config.prazo_drenagem_ms;
+    despacho.cancelamento = config.carga.fracao_cancelada > 0.0;
+    for (int i = 1; i <= config.num_impressoras; ++i)
+        despacho.tempos_por_pagina_ms.push_back(tempo_por_pagina_impressora(config, i));
+    return despacho;
+}
+
+// Converte o valor de uma opção em inteiro dentro dos limites
+int converter_inteiro(const std::string &chave, const std::string &valor, int minimo,
+                      int maximo = std::numeric_limits<int>::max())
+{
+    std::size_t lidos = 0;
+    long long numero = 0;
+    try
+    {
+        numero = std::stoll(valor, &lidos);
+    }
+    catch (const std::exception &)
+    {
+        throw std::invalid_argument("valor inválido para " + chave + ": '" + valor + "'");
+    }
+    if (lidos != valor.size())
+        throw std::invalid_argument("valor inválido para " + chave + ": '" + valor + "'");
+    if (numero < minimo || numero > maximo)
+    {
+        std::string limite = maximo == std::numeric_limits<int>::max()
+                                 ? "no mínimo " + std::to_string(minimo)
+                                 : "entre " + std::to_string(minimo) + " e " + std::to_string(maximo);
+        throw std::invalid_argument("o valor de " + chave + " deve ser " + limite);
+    }
+    return static_cast<int>(numero);
+}
+
+// Converte o valor de uma opção em número real não negativo
+double converter_real(const std::string &chave, const std::string &valor)
+{
+    std::size_t lidos = 0;
+    double numero = 0.0;
+    try
+    {
+        numero = std::stod(valor, &lidos);
+    }
+    catch (const std::exception &)
+    {
+        throw std::invalid_argument("valor inválido para " + chave + ": '" + valor + "'");
+    }
+    if (lidos != valor.size() || !(numero >= 0.0))
+        throw std::invalid_argument("valor inválido para " + chave + ": '" + valor + "'");
+    return numero;
+}
+
+// Divide um texto pelo separador
+std::vector<std::string> dividir(const std::string &texto, char separador)
+{
+    std::vector<std::string> partes;
+    std::string parte;
+    std::istringstream fluxo(texto);
+    while (std::getline(fluxo, parte, separador))
+        partes.push_back(parte);
+    return partes;
+}
+
+// Aplica uma opção "chave=valor" (da linha de comando ou do arquivo de configuração)
+void aplicar_opcao(Configuracao &config, const std::string &chave, const std::string &valor)
+{
+    if (chave == "processos")
+        config.num_processos = converter_inteiro(chave, valor, 1);
+    else if (chave == "impressoras")
+        config.num_impressoras = converter_inteiro(chave, valor, 1);
+    else if (chave == "capacidade")
+        config.capacidade_buffer = converter_inteiro(chave, valor, 1);
+    else if (chave == "ms-por-pagina")
+        config.tempo_por_pagina_ms = converter_inteiro(chave, valor, 0);
+    else if (chave == "inatividade")
+        config.tempo_limite_inatividade_s = converter_inteiro(chave, valor, 1);
+    else if (chave == "lote")
+        config.tamanho_lote = converter_inteiro(chave, valor, 1);
+    else if (chave == "dividir-paginas")
+        config.paginas_por_parte = converter_inteiro(chave, valor, 0);
+    else if (chave == "preempcao")
+        config.prioridade_preempcao = converter_inteiro(chave, valor, 0, PRIORIDADE_MAXIMA);
+    else if (chave == "prazo-drenagem-ms")
+        config.prazo_drenagem_ms = converter_inteiro(chave, valor, 0);
+    else if (chave == "cancelar")
+    {
+        config.carga.fracao_cancelada = converter_real(chave, valor);
+        if (config.carga.fracao_cancelada > 1.0)
+            throw std::invalid_argument("a fração cancelada deve estar entre 0 e 1");
+    }
+    else if (chave == "pedidos-por-processo")
+        config.carga.pedidos_por_processo = converter_inteiro(chave, valor, 0);
+    else if (chave == "intervalo-ms")
+        config.carga.intervalo_ms = converter_inteiro(chave, valor, 0);
+    else if (chave == "semente")
+        config.carga.semente = static_cast<std::uint32_t>(converter_inteiro(chave, valor, 0));
+    else if (chave == "backend")
+    {
+        if (valor == "mutex")
+            config.backend = BackendSpool::Mutex;
+        else if (valor == "lockfree")
+            config.backend = BackendSpool::LockFree;
+        else
+            throw std::invalid_argument("backend deve ser 'mutex' ou 'lockfree'");
+    }
+    else if (chave == "motor")
+    {
+        config.simulado = valor == "simulado";
+        config.executor = valor == "executor";
+        if (valor != "threads" && !config.simulado && !config.executor)
+            throw std::invalid_argument("motor deve ser 'threads', 'executor' ou 'simulado'");
+    }
+    else if (chave == "threads-executor")
+        config.threads_executor = converter_inteiro(chave, valor, 0);
+    else if (chave == "spools")
+        config.num_spools = converter_inteiro(chave, valor, 1, 256);
+    else if (chave == "metricas-porta")
+        config.porta_metricas = converter_inteiro(chave, valor, 0, 65535);
+    else if (chave == "relatorio")
+        config.arquivo_relatorio = valor;
+    else if (chave == "rastro")
+        config.arquivo_rastro = valor;
+    else if (chave == "formato-relatorio")
+    {
+        if (valor == "texto")
+            config.formato_relatorio = FormatoRelatorio::Texto;
+        else if (valor == "csv")
+            config.formato_relatorio = FormatoRelatorio::Csv;
+        else if (valor == "jsonl")
+            config.formato_relatorio = FormatoRelatorio::JsonLinhas;
+        else if (valor == "binario")
+            config.formato_relatorio = FormatoRelatorio::Binario;
+        else
+            throw std::invalid_argument("formato-relatorio deve ser 'texto', 'csv', 'jsonl' ou 'binario'");
+    }
+    else if (chave == "threads-relatorio")
+        config.threads_relatorio = converter_inteiro(chave, valor, 0);
+    else if (chave == "diario")
+        config.diretorio_diario = valor;
+    else if (chave == "diario-sincronizacao-ms")
+        config.diario_sincronizacao_ms = converter_inteiro(chave, valor, 0);
+    else if (chave == "diario-lote-sincronizacao")
+        config.diario_registros_sincronizacao = converter_inteiro(chave, valor, 1);
+    else if (chave == "admissao")
+    {
+        if (valor == "bloquear")
+            config.admissao.politica = PoliticaAdmissao::Bloquear;
+        else if (valor == "rejeitar")
+            config.admissao.politica = PoliticaAdmissao::Rejeitar;
+        else if (valor == "despejar-menor-prioridade")
+            config.admissao.politica = PoliticaAdmissao::DespejarMenorPrioridade;
+        else if (valor == "despejar-mais-antigo")
+            config.admissao.politica = PoliticaAdmissao::DespejarMaisAntigo;
+        else
+            throw std::invalid_argument("admissao deve ser 'bloquear', 'rejeitar', 'despejar-menor-prioridade' ou "
+                                        "'despejar-mais-antigo'");
+    }
+    else if (chave == "prazo-admissao-ms")
+        config.admissao.prazo_ms = converter_inteiro(chave, valor, 0);
+    else if (chave == "taxa-por-processo")
+        config.admissao.taxa_por_processo = converter_real(chave, valor);
+    else if (chave == "rajada-por-processo")
+        config.admissao.rajada_por_processo = converter_inteiro(chave, valor, 1);
+    else if (chave == "ms-por-pagina-impressoras")
+    {
+        // Um tempo por impressora, separados por vírgula, repetidos em ciclo se houver mais impressoras
+        config.tempos_por_pagina_impressoras.clear();
+        for (const std::string &tempo : dividir(valor, ','))
+            config.tempos_por_pagina_impressoras.push_back(converter_inteiro(chave, tempo, 0));
+        if (config.tempos_por_pagina_impressoras.empty())
+            throw std::invalid_argument("ms-por-pagina-impressoras precisa de ao menos um valor");
+    }
+    else if (chave == "despacho")
+    {
+        if (valor == "compartilhada")
+            config.despacho = PoliticaDespacho::Compartilhada;
+        else if (valor == "menor-primeiro")
+            config.despacho = PoliticaDespacho::MenorPrimeiro;
+        else if (valor == "por-tamanho")
+            config.despacho = PoliticaDespacho::PorTamanho;
+        else if (valor == "filas-locais")
+            config.despacho = PoliticaDespacho::FilasLocais;
+        else
+            throw std::invalid_argument("despacho deve ser 'compartilhada', 'menor-primeiro', 'por-tamanho' ou "
+                                        "'filas-locais'");
+    }
+    else if (chave == "envelhecimento-ms")
+        config.escalonamento.envelhecimento_ms = converter_inteiro(chave, valor, 0);
+    else if (chave == "espera-maxima-ms")
+    {
+        // Um limite por prioridade, da 1 à 5, separados por vírgula (0 = sem limite)
+        std::vector<std::string> limites = dividir(valor, ',');
+        if (limites.size() != NUM_PRIORIDADES)
+            throw std::invalid_argument("espera-maxima-ms deve ter " + std::to_string(NUM_PRIORIDADES) + " valores");
+        for (int i = 0; i < NUM_PRIORIDADES; ++i)
+            config.escalonamento.espera_maxima_ms[i] = converter_inteiro(chave, limites[i], 0);
+    }
+    else if (chave == "log")
+    {
+        if (valor == "silencioso")
+            config.nivel_log = NivelLog::Silencioso;
+        else if (valor == "resumo")
+            config.nivel_log = NivelLog::Resumo;
+        else if (valor == "detalhado")
+            config.nivel_log = NivelLog::Detalhado;
+        else
+            throw std::invalid_argument("log deve ser 'silencioso', 'resumo' ou 'detalhado'");
+    }
+    else if (chave == "paginas")
+    {
+        // Formato MIN:MAX (distribuição uniforme)
+        std::vector<std::string> limites = dividir(valor, ':');
+        if (limites.size() != 2)
+            throw std::invalid_argument("paginas deve ter o formato MIN:MAX");
+        config.carga.paginas_min = converter_inteiro(chave, limites[0], 1);
+        config.carga.paginas_max = converter_inteiro(chave, limites[1], config.carga.paginas_min);
+    }
+    else if (chave == "dist-paginas")
+    {
+        // uniforme ou pareto[:ALFA]
+        std::vector<std::string> partes = dividir(valor, ':');
+        if (partes[0] == "uniforme" && partes.size() == 1)
+            config.carga.distribuicao_paginas = DistribuicaoPaginas::Uniforme;
+        else if (partes[0] == "pareto" && partes.size() <= 2)
+        {
+            config.carga.distribuicao_paginas = DistribuicaoPaginas::Pareto;
+            if (partes.size() == 2)
+                config.carga.alfa_pareto = converter_real(chave, partes[1]);
+            if (config.carga.alfa_pareto <= 0.0)
+                throw std::invalid_argument("o alfa da Pareto deve ser positivo");
+        }
+        else
+            throw std::invalid_argument("dist-paginas deve ser 'uniforme' ou 'pareto[:ALFA]'");
+    }
+    else if (chave == "chegadas")
+    {
+        if (valor == "fixo")
+            config.carga.chegada = ProcessoChegada::Fixo;
+        else if (valor == "poisson")
+            config.carga.chegada = ProcessoChegada::Poisson;
+        else if (valor == "rajadas")
+            config.carga.chegada = ProcessoChegada::Rajadas;
+        else if (valor == "diurno")
+            config.carga.chegada = ProcessoChegada::Diurno;
+        else
+            throw std::invalid_argument("chegadas deve ser 'fixo', 'poisson', 'rajadas' ou 'diurno'");
+    }
+    else if (chave == "rajadas")
+    {
+        // Formato LIGADA_MS:DESLIGADA_MS (durações médias)
+        std::vector<std::string> duracoes = dividir(valor, ':');
+        if (duracoes.size() != 2)
+            throw std::invalid_argument("rajadas deve ter o formato LIGADA_MS:DESLIGADA_MS");
+        config.carga.rajada_ligada_ms = converter_inteiro(chave, duracoes[0], 1);
+        config.carga.rajada_desligada_ms = converter_inteiro(chave, duracoes[1], 0);
+    }
+    else if (chave == "diurno")
+    {
+        // Formato PERIODO_S:AMPLITUDE
+        std::vector<std::string> partes = dividir(valor, ':');
+        if (partes.size() != 2)
+            throw std::invalid_argument("diurno deve ter o formato PERIODO_S:AMPLITUDE");
+        config.carga.periodo_diurno_s = converter_inteiro(chave, partes[0], 1);
+        config.carga.amplitude_diurna = converter_real(chave, partes[1]);
+        if (config.carga.amplitude_diurna > 1.0)
+            throw std::invalid_argument("a amplitude diurna deve estar entre 0 e 1");
+    }
+    else if (chave == "trace")
+        config.arquivo_trace = valor;
+    else if (chave == "pesos-prioridade")
+    {
+        // Um peso por prioridade, da 1 à 5, separados por vírgula
+        std::vector<std::string> pesos = dividir(valor, ',');
+        if (pesos.size() != NUM_PRIORIDADES)
+            throw std::invalid_argument("pesos-prioridade deve ter " + std::to_string(NUM_PRIORIDADES) + " valores");
+        double soma = 0.0;
+        for (int i = 0; i < NUM_PRIORIDADES; ++i)
+        {
+            config.carga.pesos_prioridade[i] = converter_inteiro(chave, pesos[i], 0);
+            soma += config.carga.pesos_prioridade[i];
+        }
+        if (soma <= 0.0)
+            throw std::invalid_argument("pesos-prioridade precisa de ao menos um peso positivo");
+    }
+    else
+    {
+        throw std::invalid_argument("opção desconhecida: " + chave);
+    }
+}
+
+// Remove espaços no início e no fim de um texto
+std::string aparar(const std::string &texto)
+{
+    std::size_t inicio = texto.find_first_not_of(" \t\r");
+    if (inicio == std::string::npos)
+        return "";
+    std::size_t fim = texto.find_last_not_of(" \t\r");
+    return texto.substr(inicio, fim - inicio + 1);
+}
+
+// Lê um arquivo de configuração com linhas "chave = valor" (linhas iniciadas por # são comentários)
+void ler_arquivo_configuracao(Configuracao &config, const std::string &caminho)
+{
+    std::ifstream arquivo(caminho);
+    if (!arquivo)
+        throw std::invalid_argument("não foi possível abrir o arquivo de configuração '" + caminho + "'");
+
+    std::string linha;
+    int numero_linha = 0;
+    while (std::getline(arquivo, linha))
+    {
+        ++numero_linha;
+        linha = aparar(linha);
+        if (linha.empty() || linha[0] == '#')
+            continue;
+        std::size_t igual = linha.find('=');
+        if (igual == std::string::npos)
+            throw std::invalid_argument(caminho + ":" + std::to_string(numero_linha) + ": esperado 'chave = valor'");
+        aplicar_opcao(config, aparar(linha.substr(0, igual)), aparar(linha.substr(igual + 1)));
+    }
+}
+
+// Lê as opções da linha de comando (--chave=valor ou --chave valor). O arquivo indicado por
+// --config é aplicado primeiro, para que as demais opções possam sobrescrevê-lo.
+void ler_argumentos(int argc, char *argv[], Configuracao &config)
+{
+    config.headless = true;
+    config.nivel_log = NivelLog::Silencioso; // A saída padrão fica reservada ao resumo em JSON
+
+    std::vector<std::pair<std::string, std::string>> opcoes;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argumento = argv[i];
+        if (argumento.rfind("--", 0) != 0)
+            throw std::invalid_argument("argumento inesperado: " + argumento);
+        argumento = argumento.substr(2);
+        if (argumento == "headless")
+            continue;
+
+        std::size_t igual = argumento.find('=');
+        if (igual != std::string::npos)
+            opcoes.emplace_back(argumento.substr(0, igual), argumento.substr(igual + 1));
+        else if (i + 1 < argc)
+            opcoes.emplace_back(argumento, argv[++i]);
+        else
+            throw std::invalid_argument("falta o valor de --" + argumento);
+    }
+
+    for (const auto &[chave, valor] : opcoes)
+    {
+        if (chave == "config")
+            ler_arquivo_configuracao(config, valor);
+    }
+    for (const auto &[chave, valor] : opcoes)
+    {
+        if (chave != "config")
+            aplicar_opcao(config, chave, valor);
+    }
+    if (config.simulado && !config.diretorio_diario.empty())
+        throw std::invalid_argument("o diário não se aplica ao motor simulado");
+    if (config.simulado && config.porta_metricas > 0)
+        throw std::invalid_argument("as métricas ao vivo não se aplicam ao motor simulado");
+    if (!config.arquivo_rastro.empty())
+    {
+#ifndef SPOOL_RASTREAMENTO
+        throw std::invalid_argument("o rastreamento exige compilar com -DSPOOL_RASTREAMENTO");
+#endif
+        if (config.simulado)
+            throw std::invalid_argument("o rastreamento não se aplica ao motor simulado");
+    }
+    if (config.num_spools > 1)
+    {
+        if (config.simulado || config.executor)
+            throw std::invalid_argument("vários spools exigem o motor threads");
+        if (!config.diretorio_diario.empty() || config.porta_metricas > 0)
+            throw std::invalid_argument("o diário e as métricas ao vivo exigem um único spool");
+        if (config.despacho != PoliticaDespacho::Compartilhada && config.despacho != PoliticaDespacho::MenorPrimeiro)
+            throw std::invalid_argument("o despacho '" + std::string(nome_despacho(config.despacho)) +
+                                        "' exige um único spool");
+    }
+    if (config.escalonamento.dinamico() && config.backend == BackendSpool::LockFree && !config.simulado)
+        throw std::invalid_argument("envelhecimento e espera máxima exigem o backend mutex");
+    if (config.despacho != PoliticaDespacho::Compartilhada && config.backend == BackendSpool::LockFree && !config.simulado)
+        throw std::invalid_argument("o despacho '" + std::string(nome_despacho(config.despacho)) +
+                                    "' exige o backend mutex");
+    if (config.despacho != PoliticaDespacho::Compartilhada && config.escalonamento.dinamico())
+        throw std::invalid_argument("envelhecimento e espera máxima exigem o despacho compartilhado");
+    if (!config.arquivo_trace.empty())
+    {
+        // Um processo por identificador do trace; o trace define páginas, prioridades e instantes
+        config.carga.trace = TraceCarga::ler(config.arquivo_trace);
+        config.num_processos = config.carga.trace->num_processos();
+    }
+    if (config.paginas_por_parte > 0)
+    {
+        // O documento dividido fica na fila enquanto entrega as partes: a ordem por tamanho, o despejo e o
+        // diário (uma retirada por pedido) não se aplicam a ele
+        if (config.backend == BackendSpool::LockFree && !config.simulado)
+            throw std::invalid_argument("a divisão de documentos exige o backend mutex");
+        if (config.despacho == PoliticaDespacho::MenorPrimeiro || config.despacho == PoliticaDespacho::PorTamanho)
+            throw std::invalid_argument("a divisão de documentos não se aplica ao despacho '" +
+                                        std::string(nome_despacho(config.despacho)) + "'");
+        if (config.admissao.politica == PoliticaAdmissao::DespejarMenorPrioridade ||
+            config.admissao.politica == PoliticaAdmissao::DespejarMaisAntigo)
+            throw std::invalid_argument("a divisão de documentos não se aplica às políticas de despejo");
+        if (!config.diretorio_diario.empty())
+            throw std::invalid_argument("a divisão de documentos não se aplica ao diário");
+    }
+    // A preempção e o abandono no prazo de drenagem dependem da impressão página a página das threads;
+    // o cancelamento marca o pedido na fila com mutex
+    if (config.prioridade_preempcao > 0 && (config.simulado || config.executor))
+        throw std::invalid_argument("a preempção exige o motor threads");
+    if (config.prazo_drenagem_ms >= 0 && (config.simulado || config.executor))
+        throw std::invalid_argument("o prazo de drenagem exige o motor threads");
+    if (config.carga.fracao_cancelada > 0.0)
+    {
+        if (config.simulado)
+            throw std::invalid_argument("o cancelamento não se aplica ao motor simulado");
+        if (config.backend == BackendSpool::LockFree)
+            throw std::invalid_argument("o cancelamento exige o backend mutex");
+    }
+}
+
+// Exibe as opções do modo headless
+void imprimir_ajuda()
+{
+    std::cout << "Uso:\n"
+                 "  spool_program                    Modo interativo\n"
+                 "  spool_program --benchmark        Benchmarks do spool\n"
+                 "  spool_program --benchmark-json[=ARQUIVO] [--pedidos=N]\n"
+                 "                                   Suite de vazão e latência do spool em JSON\n"
+                 "  spool_program [opções]           Modo headless, com resumo em JSON na saída padrão\n\n"
+                 "Opções (também aceitas como 'chave = valor' no arquivo de --config):\n"
+                 "  --config=ARQUIVO                 Arquivo de configuração\n"
+                 "  --headless                       Usa apenas os valores padrão\n"
+                 "  --processos=N                    Quantidade de processos (padrão 1)\n"
+                 "  --impressoras=N                  Quantidade de impressoras (padrão 1)\n"
+                 "  --capacidade=N                   Capacidade máxima do buffer (padrão 10)\n"
+                 "  --ms-por-pagina=N                Tempo de impressão por página (padrão 10)\n"
+                 "  --backend=mutex|lockfree         Backend da fila (padrão mutex)\n"
+                 "  --ms-por-pagina-impressoras=T1,T2,...  Tempo por página de cada impressora, repetido em ciclo\n"
+                 "                                   (padrão: --ms-por-pagina para todas)\n"
+                 "  --despacho=POLITICA              compartilhada, menor-primeiro (menor pedido primeiro na\n"
+                 "                                   prioridade), por-tamanho (maiores pedidos nas impressoras\n"
+                 "                                   rápidas) ou filas-locais (fila por impressora com roubo);\n"
+                 "                                   padrão compartilhada, backend mutex\n"
+                 "  --inatividade=S                  Tempo limite de inatividade em segundos (padrão 30)\n"
+                 "  --lote=N                         Lote de envio e de retirada (padrão 1)\n"
+                 "  --dividir-paginas=N              Imprime documentos com mais de N páginas em partes de N\n"
+                 "                                   páginas, em paralelo nas impressoras livres, 0 = inteiros\n"
+                 "                                   (padrão 0; backend mutex)\n"
+                 "  --preempcao=P                    Pedidos de prioridade P ou maior interrompem, na próxima\n"
+                 "                                   página, impressões de prioridade menor, que são retomadas\n"
+                 "                                   depois; 0 = sem preempção (padrão 0; motor threads)\n"
+                 "  --prazo-drenagem-ms=N            No encerramento, as impressoras esvaziam o buffer por até\n"
+                 "                                   N ms; depois os pedidos restantes são descartados e as\n"
+                 "                                   impressões em curso param na próxima página (padrão: sem\n"
+                 "                                   prazo; motor threads)\n"
+                 "  --cancelar=F                     Fração dos pedidos aceitos que cada processo cancela logo\n"
+                 "                                   após o envio, 0 a 1 (padrão 0; backend mutex)\n"
+                 "  --admissao=POLITICA              Com o buffer cheio: bloquear (espera até o prazo), rejeitar,\n"
+                 "                                   despejar-menor-prioridade ou despejar-mais-antigo (padrão bloquear)\n"
+                 "  --prazo-admissao-ms=N            Espera máxima por vaga (padrão 1000)\n"
+                 "  --taxa-por-processo=R            Pedidos/s admitidos por processo, 0 = sem limite (padrão 0)\n"
+                 "  --rajada-por-processo=N          Rajada do limite de taxa por processo (padrão 1)\n"
+                 "  --envelhecimento-ms=N            Espera que vale um nível de prioridade, 0 = prioridade estática\n"
+                 "                                   (padrão 0; backend mutex)\n"
+                 "  --espera-maxima-ms=L1,...,L5     Espera máxima por prioridade, 0 = sem limite (padrão 0,0,0,0,0)\n"
+                 "  --log=silencioso|resumo|detalhado  Mensagens na saída de erro (padrão silencioso)\n"
+                 "  --pedidos-por-processo=N         Pedidos gerados por processo (padrão 5)\n"
+                 "  --paginas=MIN:MAX                Páginas por documento, uniforme (padrão 1:10)\n"
+                 "  --pesos-prioridade=P1,...,P5     Peso de cada prioridade (padrão 1,1,1,1,1)\n"
+                 "  --intervalo-ms=N                 Intervalo médio entre pedidos de um processo (padrão 100)\n"
+                 "  --chegadas=PROCESSO              fixo (intervalo constante), poisson, rajadas (liga/desliga)\n"
+                 "                                   ou diurno (taxa em senoide); padrão fixo\n"
+                 "  --rajadas=LIGADA_MS:DESLIGADA_MS Durações médias dos períodos com e sem envios (padrão 1000:4000)\n"
+                 "  --diurno=PERIODO_S:AMPLITUDE     Período e variação relativa da taxa (padrão 86400:0.8)\n"
+                 "  --dist-paginas=uniforme|pareto[:ALFA]  Distribuição das páginas entre MIN e MAX (padrão\n"
+                 "                                   uniforme; alfa padrão 1.2)\n"
+                 "  --trace=ARQUIVO                  Reproduz pedidos gravados, uma linha por pedido:\n"
+                 "                                   instante_ms,processo,paginas,prioridade (um processo por\n"
+                 "                                   identificador; substitui a carga sintética)\n"
+                 "  --semente=N                      Semente dos geradores, 0 = aleatória (padrão 0)\n"
+                 "  --motor=threads|executor|simulado  Uma thread por entidade, pool de threads com temporizadores\n"
+                 "                                   ou simulação por eventos discretos (padrão threads)\n"
+                 "  --threads-executor=N             Threads do pool no motor executor, 0 = núcleos (padrão 0)\n"
+                 "  --spools=N                       Spools independentes no motor threads, com os processos\n"
+                 "                                   distribuídos por hash consistente e as impressoras em\n"
+                 "                                   rodízio; impressoras ociosas roubam do vizinho mais\n"
+                 "                                   carregado (padrão 1; capacidade por spool)\n"
+                 "  --metricas-porta=N               Serve as métricas do spool em http://127.0.0.1:N/metrics,\n"
+                 "                                   no formato do Prometheus (padrão 0 = desligado)\n"
+                 "  --relatorio=ARQUIVO              Grava o relatório completo no arquivo\n"
+                 "  --formato-relatorio=FORMATO      texto (resumo e um bloco por documento), csv, jsonl ou\n"
+                 "                                   binario (só os documentos); padrão texto\n"
+                 "  --threads-relatorio=N            Threads que formatam o relatório, 0 = núcleos (padrão 1)\n"
+                 "  --diario=DIRETORIO               Diário persistente do spool; pedidos pendentes de uma\n"
+                 "                                   execução interrompida são recuperados na abertura\n"
+                 "  --diario-sincronizacao-ms=N      Intervalo do commit em grupo no disco, 0 = sem msync (padrão 10)\n"
+                 "  --diario-lote-sincronizacao=N    Registros que antecipam o commit em grupo (padrão 65536)\n"
+                 "  --rastro=ARQUIVO                 Grava o trace de locks, despertares e envios/retiradas no\n"
+                 "                                   formato do Chrome/Perfetto (build com -DSPOOL_RASTREAMENTO)\n";
+}
+
+// Função auxiliar para ler e validar entradas inteiras
+int ler_entrada(const std::string &prompt, int minimo, int maximo = std::numeric_limits<int>::max())
+{
+    int valor;
+    while (true)
+    {
+        {
+            std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+            std::cout << prompt;
+        }
+        std::cin >> valor;
+
+        // Verifica se a leitura foi bem-sucedida
+        if (std::cin.fail())
+        {
+            std::cin.clear();                                                   // Limpa o estado de erro
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Descarte a entrada inválida
+            {
+                std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+                std::cout << "Entrada inválida! Por favor, insira um número inteiro válido.\n\n";
+            }
+            continue;
+        }
+
+        // Descarte qualquer caractere extra no buffer de entrada
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+        // Verifica se o valor atende aos critérios mínimo e máximo
+        if (valor >= minimo && valor <= maximo)
+        {
+            break;
+        }
+        else if (maximo == std::numeric_limits<int>::max())
+        {
+            {
+                std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+                std::cout << "Valor inválido! O valor deve ser no mínimo " << minimo << ".\n\n";
+            }
+        }
+        else
+        {
+            {
+                std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+                std::cout << "Valor inválido! O valor deve estar entre " << minimo << " e " << maximo << ".\n\n";
+            }
+        }
+    }
+    return valor;
+}
+
+// Função para coletar os dados de entrada do usuário
+void coletar_dados(Configuracao &config)
+{
+    {
+        std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+        std::cout << "Bem-vindo ao Simulador de Pool de Impressão!\n\n";
+    }
+
+    // Coleta a quantidade de processos (mínimo 1)
+    config.num_processos = ler_entrada("Quantidade de processos (mínimo 1): ", 1);
+
+    // Coleta a quantidade de impressoras (mínimo 1)
+    config.num_impressoras = ler_entrada("Quantidade de impressoras (mínimo 1): ", 1);
+
+    // Coleta a capacidade máxima do buffer (mínimo 1)
+    config.capacidade_buffer = ler_entrada("Capacidade máxima do buffer (mínimo 1): ", 1);
+
+    // Coleta o tempo de impressão por página (mínimo 10 ms)
+    config.tempo_por_pagina_ms = ler_entrada("Tempo de impressão por página (ms, mínimo 10): ", 10);
+
+    // Coleta o backend da fila do spool (1 = mutex, 2 = lock-free por prioridade)
+    config.backend = static_cast<BackendSpool>(ler_entrada("Backend do spool (1 = mutex, 2 = lock-free por prioridade): ", 1, 2));
+
+    // Coleta a política de admissão com o buffer cheio
+    config.admissao.politica = static_cast<PoliticaAdmissao>(ler_entrada(
+        "Com o buffer cheio (1 = esperar até 1 s, 2 = rejeitar, 3 = despejar menor prioridade, 4 = despejar mais antigo): ",
+        1, 4));
+
+    // Coleta o tempo limite de inatividade antes do relatório (mínimo 1 s)
+    config.tempo_limite_inatividade_s = ler_entrada("Tempo limite de inatividade (s, mínimo 1): ", 1);
+
+    // Coleta o tamanho do lote usado por processos e impressoras (1 = pedido a pedido)
+    config.tamanho_lote = ler_entrada("Tamanho do lote de envio/retirada (mínimo 1, 1 = sem lote): ", 1);
+
+    // Coleta o nível de log durante a execução
+    config.nivel_log = static_cast<NivelLog>(ler_entrada("Nível de log (0 = silencioso, 1 = resumo, 2 = detalhado): ", 0, 2));
+
+    {
+        std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+        std::cout << "\n";
+    }
+}
+
+// Classe que representa um processo que gera pedidos de impressão
+// Gera a sequência de pedidos de um processo. Compartilhado pelo modo com threads, pelo executor e
+// pelo simulador, de modo que a mesma semente (ou o mesmo trace) produz a mesma carga nos três
+// motores. Cada pedido vem com o intervalo até o próximo, que o processo espera depois de enviar a
+// rajada; o relógio do gerador soma os intervalos, sem contar o tempo bloqueado no envio.
+class GeradorPedidos
+{
+public:
+    GeradorPedidos(int id_processo, const ParametrosCarga &carga)
+        : id_processo(id_processo), max_pedidos(carga.pedidos_por_processo),
+          gen(carga.semente != 0 ? carga.semente + static_cast<std::uint32_t>(id_processo) : std::random_device{}()),
+          paginas_dist(carga.paginas_min, carga.paginas_max),
+          prioridade_dist(carga.pesos_prioridade.begin(), carga.pesos_prioridade.end()),
+          distribuicao_paginas(carga.distribuicao_paginas), chegada(carga.chegada),
+          intervalo_us(carga.intervalo_ms * 1000.0), cancelamento(carga.fracao_cancelada)
+    {
+        // Os cancelamentos têm gerador próprio, para não alterar a sequência de pedidos da mesma semente
+        if (carga.fracao_cancelada > 0.0)
+            gen_cancelamento.seed(carga.semente != 0 ? carga.semente + 7919u * static_cast<std::uint32_t>(id_processo)
+                                                     : std::random_device{}());
+        if (carga.trace)
+        {
+            trace = &carga.trace->pedidos(id_processo);
+            max_pedidos = static_cast<int>(trace->size());
+            return;
+        }
+
+        // Pareto limitada por inversão: x = L / (1 - u (1 - (L/H)^α))^(1/α)
+        alfa_pareto = carga.alfa_pareto;
+        fator_pareto = 1.0 - std::pow(static_cast<double>(carga.paginas_min) / carga.paginas_max, alfa_pareto);
+        paginas_min = carga.paginas_min;
+        paginas_max = carga.paginas_max;
+
+        // Nas rajadas, a taxa nos períodos ligados compensa o silêncio, mantendo o intervalo médio
+        double ciclo_ms = static_cast<double>(carga.rajada_ligada_ms) + carga.rajada_desligada_ms;
+        fracao_ligada = ciclo_ms > 0 ? carga.rajada_ligada_ms / ciclo_ms : 1.0;
+        ligada_media_us = carga.rajada_ligada_ms * 1000.0;
+        desligada_media_us = carga.rajada_desligada_ms * 1000.0;
+        if (chegada == ProcessoChegada::Rajadas)
+            fim_ligada_us = ligada_media_us * exponencial(gen); // O processo começa em um período ligado
+
+        periodo_diurno_us = carga.periodo_diurno_s * 1e6;
+        amplitude_diurna = carga.amplitude_diurna;
+    }
+
+    // Indica se o processo já gerou todos os seus pedidos
+    bool terminou() const
+    {
+        return gerados >= max_pedidos;
+    }
+
+    // Quantidade de pedidos gerados até agora
+    int quantidade() const
+    {
+        return gerados;
+    }
+
+    // Sorteia se o processo cancela um pedido aceito pelo spool (com a fração cancelada da carga)
+    bool sortear_cancelamento()
+    {
+        return cancelamento.p() > 0.0 && cancelamento(gen_cancelamento);
+    }
+
+    // Espera antes do primeiro pedido, em µs (o instante do primeiro pedido do processo no trace)
+    std::int64_t atraso_inicial_us() const
+    {
+        return trace != nullptr && !trace->empty() ? trace->front().instante_us : 0;
+    }
+
+    // Preenche o próximo pedido do processo, solicitado no horário informado, e retorna o intervalo
+    // até o pedido seguinte, em µs
+    std::int64_t proximo(Pedido &pedido, std::chrono::system_clock::time_point hora_solicitacao)
+    {
+        pedido.id = gerados++;
+        pedido.id_processo = id_processo;
+        pedido.hora_solicitacao = hora_solicitacao;
+        if (trace != nullptr)
+        {
+            const PedidoTrace &gravado = (*trace)[pedido.id];
+            pedido.num_paginas = gravado.num_paginas;
+            pedido.prioridade = static_cast<std::int16_t>(gravado.prioridade);
+            return terminou() ? 0 : (*trace)[gerados].instante_us - gravado.instante_us;
+        }
+
+        pedido.num_paginas = gerar_paginas();                               // Gera um número aleatório de páginas
+        pedido.prioridade = static_cast<std::int16_t>(PRIORIDADE_MINIMA + prioridade_dist(gen)); // Gera uma prioridade aleatória
+        double anterior = relogio_us;
+        relogio_us = proxima_chegada();
+        return std::llround(relogio_us) - std::llround(anterior);
+    }
+
+private:
+    int id_processo;                                 // Processo dono dos pedidos
+    int max_pedidos;                                 // Número máximo de pedidos do processo
+    int gerados = 0;                                 // Pedidos gerados até agora
+    std::mt19937 gen;                                // Gerador de números aleatórios (semente fixa torna a carga repetível)
+    std::uniform_int_distribution<> paginas_dist;    // Distribuição para número de páginas
+    std::discrete_distribution<> prioridade_dist;    // Distribuição para prioridade
+    std::exponential_distribution<> exponencial{1.0}; // Intervalos e durações exponenciais de média 1
+    std::uniform_real_distribution<> uniforme{0.0, 1.0}; // Sorteios da Pareto e do ciclo diurno
+    DistribuicaoPaginas distribuicao_paginas;        // Distribuição das páginas
+    int paginas_min = 1;                             // Limites da Pareto
+    int paginas_max = 1;
+    double alfa_pareto = 1.0;                        // Forma da Pareto
+    double fator_pareto = 0.0;                       // 1 - (L/H)^α
+    ProcessoChegada chegada;                         // Processo de chegada
+    double intervalo_us;                             // Intervalo médio entre pedidos
+    double relogio_us = 0.0;                         // Instante do pedido atual no relógio do gerador
+    double fracao_ligada = 1.0;                      // Fração do tempo com envios (rajadas)
+    double ligada_media_us = 0.0;                    // Duração média de um período ligado
+    double desligada_media_us = 0.0;                 // Duração média de um período desligado
+    double fim_ligada_us = 0.0;                      // Fim do período ligado atual
+    double periodo_diurno_us = 0.0;                  // Período do ciclo diurno
+    double amplitude_diurna = 0.0;                   // Variação relativa da taxa no ciclo diurno
+    const std::vector<PedidoTrace> *trace = nullptr; // Pedidos gravados do processo (nulo = carga sintética)
+    std::bernoulli_distribution cancelamento;        // Cancelamento de um pedido aceito
+    std::minstd_rand gen_cancelamento;               // Gerador dos cancelamentos
+
+    int gerar_paginas()
+    {
+        if (distribuicao_paginas == DistribuicaoPaginas::Uniforme)
+            return paginas_dist(gen);
+        double paginas = paginas_min / std::pow(1.0 - uniforme(gen) * fator_pareto, 1.0 / alfa_pareto);
+        return std::clamp(static_cast<int>(paginas), paginas_min, paginas_max);
+    }
+
+    // Instante do próximo pedido no relógio do gerador
+    double proxima_chegada()
+    {
+        switch (chegada)
+        {
+        case ProcessoChegada::Fixo:
+            return relogio_us + intervalo_us;
+        case ProcessoChegada::Poisson:
+            return relogio_us + intervalo_us * exponencial(gen);
+        case ProcessoChegada::Rajadas:
+        {
+            // Sem memória: uma chegada que cairia depois do fim do período ligado é sorteada de novo
+            // a partir do início do próximo
+            double instante = relogio_us;
+            while (true)
+            {
+                double candidato = instante + intervalo_us * fracao_ligada * exponencial(gen);
+                if (candidato <= fim_ligada_us || desligada_media_us <= 0.0)
+                    return candidato;
+                instante = fim_ligada_us + desligada_media_us * exponencial(gen);
+                fim_ligada_us = instante + ligada_media_us * exponencial(gen);
+            }
+        }
+        case ProcessoChegada::Diurno:
+        {
+            // Afinamento: candidatos na taxa máxima, aceitos com a razão entre a taxa no instante e ela
+            constexpr double DOIS_PI = 6.283185307179586;
+            double instante = relogio_us;
+            while (true)
+            {
+                instante += intervalo_us / (1.0 + amplitude_diurna) * exponencial(gen);
+                double taxa = 1.0 + amplitude_diurna * std::sin(DOIS_PI * instante / periodo_diurno_us);
+                if (uniforme(gen) * (1.0 + amplitude_diurna) <= taxa)
+                    return instante;
+            }
+        }
+        }
+        return relogio_us + intervalo_us;
+    }
+};
+
+class Processo
+{
+public:
+    // Construtor que inicializa o processo com seu ID, referência ao spool, parâmetros da carga gerada
+    // e quantidade de documentos enviados de uma vez
+    Processo(int pid, Spool &spool, const ParametrosCarga &carga, int tamanho_lote = 1)
+        : id(pid), spool_ref(spool), carga(carga),
+          pedidos_enviados(0), pedidos_descartados(0), tamanho_lote(tamanho_lote) {}
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    Processo(const Processo &) = delete;
+    Processo &operator=(const Processo &) = delete;
+
+    // Função para iniciar a thread do processo
+    void start()
+    {
+        thread_process = std::thread(&Processo::run, this);
+    }
+
+    // Função para esperar a thread do processo terminar
+    void join()
+    {
+        if (thread_process.joinable())
+            thread_process.join();
+    }
+
+    // Quantidade de pedidos gerados (válido após join)
+    int gerados() const
+    {
+        return pedidos_enviados;
+    }
+
+    // Quantidade de pedidos descartados pelo spool (válido após join)
+    int descartados() const
+    {
+        return pedidos_descartados;
+    }
+
+private:
+    int id;                     // Identificador do processo
+    Spool &spool_ref;           // Referência ao spool de impressão
+    ParametrosCarga carga;      // Distribuições, chegadas ou trace da carga gerada
+    int pedidos_enviados;       // Contador de pedidos enviados
+    int pedidos_descartados;    // Contador de pedidos descartados
+    int tamanho_lote;           // Documentos gerados e enviados em cada rajada
+    std::thread thread_process; // Thread do processo
+
+    // Função que executa o processo, gerando pedidos de impressão
+    void run()
+    {
+        try
+        {
+            GeradorPedidos gerador(id, carga);
+            if (gerador.atraso_inicial_us() > 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(gerador.atraso_inicial_us()));
+
+            std::vector<Pedido> lote;
+            lote.reserve(tamanho_lote);
+            while (!gerador.terminou())
+            {
+                // Gera uma rajada de até tamanho_lote documentos
+                lote.clear();
+                std::int64_t pausa_us = 0;
+                while (static_cast<int>(lote.size()) < tamanho_lote && !gerador.terminou())
+                {
+                    Pedido pedido;
+                    pausa_us += gerador.proximo(pedido, std::chrono::system_clock::now()); // Registra o horário da solicitação
+                    ++pedidos_enviados;
+
+                    // Registro assíncrono da mensagem de geração do pedido
+                    SPOOL_LOG_PEDIDO(TipoEvento::PedidoGerado, id, pedido.id, pedido.num_paginas, pedido.prioridade);
+                    lote.push_back(std::move(pedido));
+                }
+
+                // Adiciona o pedido (ou o lote inteiro, em uma única seção crítica) ao spool
+                std::size_t aceitos;
+                if (lote.size() == 1)
+                    aceitos = spool_ref.add_pedido(lote.front()) ? 1 : 0;
+                else
+                    aceitos = spool_ref.add_pedidos(lote);
+
+                // Alguns pedidos aceitos são cancelados logo depois (os que ainda estiverem na fila)
+                for (std::size_t i = 0; i < aceitos; ++i)
+                {
+                    if (gerador.sortear_cancelamento())
+                        spool_ref.cancelar_pedido(id, lote[i].id);
+                }
+
+                // O spool aceita o lote em ordem; os pedidos restantes foram descartados
+                pedidos_descartados += static_cast<int>(lote.size() - aceitos);
+                for (std::size_t i = aceitos; i < lote.size(); ++i)
+                {
+                    // Opcional: registrar que o pedido foi descartado
+                    logger.registrar(NivelLog::Resumo, TipoEvento::DescarteNotificado, id, lote[i].id);
+                }
+                // Espera antes de gerar a próxima rajada os intervalos dos documentos gerados
+                if (pausa_us > 0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(pausa_us));
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+            std::cerr << "Erro no processo " << id << ": " << e.what() << "\n";
+        }
+        catch (...)
+        {
+            std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+            std::cerr << "Erro desconhecido no processo " << id << ".\n";
+        }
+        // Decrementa o contador de processos ativos ao finalizar; o último acorda o monitor
+        if (--processos_ativos == 0)
+            spool_ref.notificar_monitor();
+        logger.registrar(NivelLog::Resumo, TipoEvento::ProcessoFinalizado, id);
+    }
+};
+
+// Motor de simulação por eventos discretos. Executa o mesmo modelo do modo com threads (spool com
+// prioridades e capacidade limitada, política de admissão, impressoras com lote e processos
+// com a mesma carga) em um relógio simulado, em uma única thread e sem esperas reais. Os registros
+// vão para as mesmas colunas por impressora, então o relatório é o mesmo.
+class SimuladorSpool
+{
+public:
+    // Construtor que prepara processos e impressoras a partir da configuração
+    SimuladorSpool(const Configuracao &config, RegistrosImpressao &registros)
+        : capacidade(config.capacidade_buffer), tamanho_lote(config.tamanho_lote),
+          limite_inatividade_us(config.tempo_limite_inatividade_s * 1000000LL), admissao(config.admissao),
+          registros_ref(registros), hora_base(std::chrono::system_clock::now()),
+          buffer(config.escalonamento, configuracao_despacho(config))
+    {
+        processos.reserve(config.num_processos);
+        for (int i = 1; i <= config.num_processos; ++i)
+            processos.emplace_back(i, config.carga, config.admissao.rajada_por_processo);
+        impressoras.resize(config.num_impressoras);
+        for (int i = 1; i <= config.num_impressoras; ++i)
+            impressoras[i - 1].tempo_por_pagina_us = tempo_por_pagina_impressora(config, i) * 1000LL;
+        for (int i = config.num_impressoras; i >= 1; --i)
+            impressoras_livres.push_back(i); // A impressora 1 é a primeira a receber trabalho
+    }
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    SimuladorSpool(const SimuladorSpool &) = delete;
+    SimuladorSpool &operator=(const SimuladorSpool &) = delete;
+
+    // Executa a simulação até que não haja mais eventos
+    void executar()
+    {
+        for (int i = 0; i < static_cast<int>(processos.size()); ++i)
+            agendar(processos[i].gerador.atraso_inicial_us(), TipoEventoSimulado::ProcessoEnvia, i);
+
+        while (!eventos.empty())
+        {
+            EventoSimulado evento = eventos.top();
+            eventos.pop();
+            // Prazo de uma espera que já terminou: ignorado sem avançar o relógio
+            if (evento.tipo == TipoEventoSimulado::PrazoEnvio && processos[evento.entidade].geracao != evento.geracao)
+                continue;
+            agora = evento.instante_us;
+            ++eventos_tratados;
+
+            switch (evento.tipo)
+            {
+            case TipoEventoSimulado::ProcessoEnvia:
+                enviar_rajada(evento.entidade);
+                break;
+            case TipoEventoSimulado::PrazoEnvio:
+                expirar_espera(evento.entidade);
+                break;
+            case TipoEventoSimulado::ImpressaoConcluida:
+                concluir_impressao(evento.entidade);
+                break;
+            }
+            distribuir();
+        }
+    }
+
+    // Quantidade de pedidos gerados pelos processos
+    int gerados() const
+    {
+        int soma = 0;
+        for (const auto &processo : processos)
+            soma += processo.gerador.quantidade();
+        return soma;
+    }
+
+    // Quantidade de pedidos descartados pelo spool
+    int descartados() const
+    {
+        return pedidos_descartados;
+    }
+
+    // Pedidos aceitos, rejeitados, limitados e despejados
+    const ResumoAdmissao &admissao_pedidos() const
+    {
+        return contadores;
+    }
+
+    // Instante simulado do último evento
+    std::chrono::microseconds tempo_simulado() const
+    {
+        return std::chrono::microseconds(agora);
+    }
+
+    // Quantidade de eventos tratados
+    std::uint64_t eventos_processados() const
+    {
+        return eventos_tratados;
+    }
+
+private:
+    enum class TipoEventoSimulado : std::uint8_t
+    {
+        ProcessoEnvia,     // O processo gera e envia a próxima rajada
+        PrazoEnvio,        // Fim da espera por vaga
+        ImpressaoConcluida // A impressora terminou o pedido atual
+    };
+
+    struct EventoSimulado
+    {
+        std::int64_t instante_us;  // Instante simulado, em microssegundos desde o início
+        std::uint64_t sequencia;   // Desempate: eventos do mesmo instante saem na ordem de agendamento
+        TipoEventoSimulado tipo;   // Tipo do evento
+        int entidade;              // Índice do processo ou da impressora
+        std::uint32_t geracao;     // Geração da espera do processo (descarta prazos obsoletos)
+
+        bool operator>(const EventoSimulado &outro) const
+        {
+            if (instante_us != outro.instante_us)
+                return instante_us > outro.instante_us;
+            return sequencia > outro.sequencia;
+        }
+    };
+
+    struct ProcessoSimulado
+    {
+        ProcessoSimulado(int id, const ParametrosCarga &carga, int rajada)
+            : gerador(id, carga), fichas{static_cast<double>(rajada), 0} {}
+
+        GeradorPedidos gerador;         // Mesma carga do modo com threads
+        BaldeFichas fichas;             // Limite de taxa do processo, no relógio simulado
+        std::vector<Pedido> lote;       // Rajada em envio
+        std::int64_t pausa_us = 0;      // Intervalos dos pedidos da rajada, esperados antes da próxima
+        std::size_t enviados = 0;       // Pedidos da rajada já aceitos pelo spool
+        std::uint32_t geracao = 0;      // Incrementada a cada rajada concluída
+    };
+
+    struct ImpressoraSimulada
+    {
+        std::vector<Pedido> lote;    // Pedidos retirados do spool, impressos em ordem
+        std::size_t atual = 0;       // Pedido em impressão
+        std::int64_t inicio_us = 0;  // Início da impressão atual
+        std::int64_t tempo_por_pagina_us = 0; // Tempo de impressão por página desta impressora
+    };
+
+    int capacidade;                       // Capacidade máxima do buffer
+    int tamanho_lote;                     // Lote de envio e de retirada
+    std::int64_t limite_inatividade_us;   // Tempo limite de inatividade do spool
+    ConfiguracaoAdmissao admissao;        // Política com o buffer cheio e limite de taxa
+    RegistrosImpressao &registros_ref;    // Colunas de registros, uma por impressora
+    std::chrono::system_clock::time_point hora_base; // Horário real correspondente ao instante simulado 0
+
+    std::priority_queue<EventoSimulado, std::vector<EventoSimulado>, std::greater<EventoSimulado>> eventos;
+    FilaDespacho buffer;                      // Fila de prioridade do spool (um FIFO por nível)
+    DocumentosDivididos divididos;            // Documentos divididos com partes em impressão
+    std::vector<ProcessoSimulado> processos;
+    std::vector<ImpressoraSimulada> impressoras;
+    std::vector<int> impressoras_livres;      // Impressoras esperando pedidos (identificadores, começam em 1)
+    std::deque<int> produtores_esperando;     // Processos esperando vaga, em ordem de chegada
+
+    std::int64_t agora = 0;                   // Relógio simulado, em microssegundos
+    std::int64_t ultima_atividade = 0;        // Instante do último envio ao spool
+    bool encerrado = false;                   // O spool encerrou por inatividade
+    std::uint64_t proxima_sequencia = 0;      // Sequência dos eventos
+    std::uint64_t eventos_tratados = 0;       // Eventos tratados
+    int pedidos_descartados = 0;              // Pedidos descartados
+    ResumoAdmissao contadores;                // Pedidos aceitos, rejeitados, limitados e despejados
+
+    // Converte um instante simulado em horário do system_clock
+    std::chrono::system_clock::time_point hora(std::int64_t instante_us) const
+    {
+        return hora_base + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                               std::chrono::microseconds(instante_us));
+    }
+
+    void agendar(std::int64_t instante_us, TipoEventoSimulado tipo, int entidade, std::uint32_t geracao = 0)
+    {
+        eventos.push(EventoSimulado{instante_us, proxima_sequencia++, tipo, entidade, geracao});
+    }
+
+    // Gera a próxima rajada do processo e tenta colocá-la no buffer
+    void enviar_rajada(int indice)
+    {
+        ProcessoSimulado &processo = processos[indice];
+        if (processo.gerador.terminou())
+            return;
+
+        // Sem envios dentro do prazo de inatividade, o spool teria encerrado e passaria a recusar pedidos
+        if (!encerrado && agora - ultima_atividade > limite_inatividade_us)
+            encerrado = true;
+        ultima_atividade = agora;
+
+        processo.lote.clear();
+        processo.enviados = 0;
+        processo.pausa_us = 0;
+        while (static_cast<int>(processo.lote.size()) < tamanho_lote && !processo.gerador.terminou())
+        {
+            processo.lote.emplace_back();
+            processo.pausa_us += processo.gerador.proximo(processo.lote.back(), hora(agora));
+        }
+
+        if (encerrado)
+        {
+            pedidos_descartados += static_cast<int>(processo.lote.size());
+            finalizar_rajada(indice);
+            return;
+        }
+
+        // Pedidos além do limite de taxa do processo são descartados antes do envio
+        if (admissao.taxa_por_processo > 0.0)
+        {
+            std::size_t permitidos = 0;
+            while (permitidos < processo.lote.size() &&
+                   processo.fichas.consumir(agora, admissao.taxa_por_processo, admissao.rajada_por_processo))
+                ++permitidos;
+            contadores.limitados += processo.lote.size() - permitidos;
+            pedidos_descartados += static_cast<int>(processo.lote.size() - permitidos);
+            processo.lote.resize(permitidos);
+        }
+
+        inserir(processo);
+        if (processo.enviados < processo.lote.size() && admissao.politica == PoliticaAdmissao::Rejeitar)
+        {
+            // Buffer cheio e sem espera: o restante da rajada é descartado na hora
+            contadores.rejeitados += processo.lote.size() - processo.enviados;
+            pedidos_descartados += static_cast<int>(processo.lote.size() - processo.enviados);
+            finalizar_rajada(indice);
+        }
+        else if (processo.enviados < processo.lote.size())
+        {
+            // Buffer cheio: espera por vaga até o prazo de admissão
+            produtores_esperando.push_back(indice);
+            agendar(agora + admissao.prazo_ms * 1000LL, TipoEventoSimulado::PrazoEnvio, indice, processo.geracao);
+        }
+        else
+        {
+            finalizar_rajada(indice);
+        }
+    }
+
+    // Coloca no buffer o que couber da rajada do processo, despejando pedidos menos prioritários
+    // quando a política permite
+    void inserir(ProcessoSimulado &processo)
+    {
+        std::size_t inicio = processo.enviados;
+        while (processo.enviados < processo.lote.size() &&
+               (static_cast<int>(buffer.tamanho()) < capacidade || despejar(processo.lote[processo.enviados])))
+            buffer.inserir(std::move(processo.lote[processo.enviados++]));
+        contadores.aceitos += processo.enviados - inicio;
+    }
+
+    // Abre uma vaga tirando do buffer um pedido menos prioritário que o novo, como Spool::despejar_travado
+    bool despejar(const Pedido &novo)
+    {
+        if (admissao.politica != PoliticaAdmissao::DespejarMenorPrioridade &&
+            admissao.politica != PoliticaAdmissao::DespejarMaisAntigo)
+            return false;
+        Pedido vitima;
+        if (!buffer.despejar(novo.prioridade, admissao.politica == PoliticaAdmissao::DespejarMaisAntigo, vitima))
+            return false;
+        ++contadores.despejados;
+        return true;
+    }
+
+    // Encerra a rajada e agenda a próxima depois dos intervalos dos documentos gerados
+    void finalizar_rajada(int indice)
+    {
+        ProcessoSimulado &processo = processos[indice];
+        ++processo.geracao;
+        if (!processo.gerador.terminou())
+            agendar(agora + processo.pausa_us, TipoEventoSimulado::ProcessoEnvia, indice);
+    }
+
+    // O prazo de espera por vaga terminou: o restante da rajada é descartado
+    void expirar_espera(int indice)
+    {
+        ProcessoSimulado &processo = processos[indice];
+        produtores_esperando.erase(std::find(produtores_esperando.begin(), produtores_esperando.end(), indice));
+        contadores.rejeitados += processo.lote.size() - processo.enviados;
+        pedidos_descartados += static_cast<int>(processo.lote.size() - processo.enviados);
+        finalizar_rajada(indice);
+    }
+
+    // Registra o pedido concluído e passa ao próximo do lote, ou libera a impressora
+    void concluir_impressao(int id_impressora)
+    {
+        ImpressoraSimulada &impressora = impressoras[id_impressora - 1];
+        const Pedido &pedido = impressora.lote[impressora.atual];
+        registros_ref.colunas(id_impressora).acrescentar(pedido, hora(impressora.inicio_us),
+                                                         std::chrono::microseconds(agora - impressora.inicio_us),
+                                                         divididos.concluir(pedido));
+
+        if (++impressora.atual < impressora.lote.size())
+            iniciar_impressao(id_impressora);
+        else
+            impressoras_livres.push_back(id_impressora);
+    }
+
+    void iniciar_impressao(int id_impressora)
+    {
+        ImpressoraSimulada &impressora = impressoras[id_impressora - 1];
+        impressora.inicio_us = agora;
+        agendar(agora + impressora.tempo_por_pagina_us * impressora.lote[impressora.atual].num_paginas,
+                TipoEventoSimulado::ImpressaoConcluida, id_impressora);
+    }
+
+    // Entrega pedidos às impressoras livres e vagas aos produtores que esperam, até estabilizar
+    void distribuir()
+    {
+        while (!buffer.vazia() && !impressoras_livres.empty())
+        {
+            int id_impressora = impressoras_livres.back();
+            impressoras_livres.pop_back();
+            ImpressoraSimulada &impressora = impressoras[id_impressora - 1];
+
+            // Retira um pedido, ou um lote da mesma prioridade do primeiro, como get_pedidos
+            impressora.lote.clear();
+            impressora.atual = 0;
+            std::chrono::system_clock::time_point instante = hora(agora);
+            int prioridade_lote = buffer.topo(instante, id_impressora).prioridade;
+            while (static_cast<int>(impressora.lote.size()) < tamanho_lote && !buffer.vazia())
+            {
+                if (buffer.topo(instante, id_impressora).prioridade != prioridade_lote)
+                    break;
+                impressora.lote.emplace_back();
+                bool saiu = buffer.retirar(instante, id_impressora, impressora.lote.back());
+                if (impressora.lote.back().parte > 0)
+                {
+                    divididos.entregar(impressora.lote.back(), saiu);
+                    break;
+                }
+            }
+            iniciar_impressao(id_impressora);
+
+            // As vagas liberadas vão para os produtores que esperam, em ordem de chegada
+            while (!produtores_esperando.empty() && static_cast<int>(buffer.tamanho()) < capacidade)
+            {
+                int indice = produtores_esperando.front();
+                ProcessoSimulado &processo = processos[indice];
+                inserir(processo);
+                if (processo.enviados < processo.lote.size())
+                    break;
+                produtores_esperando.pop_front();
+                finalizar_rajada(indice);
+            }
+        }
+    }
+};
+
+// Pool de threads de tamanho fixo com roubo de tarefas. Cada thread tem sua própria fila: tarefas
+// submetidas por uma thread do pool vão para a fila dela (e saem na ordem inversa, ainda quentes no
+// cache), e threads sem trabalho roubam do início das filas das outras antes de dormir.
+class PoolExecucao
+{
+public:
+    // Construtor que inicia num_threads threads de trabalho
+    explicit PoolExecucao(int num_threads)
+    {
+        for (int i = 0; i < num_threads; ++i)
+            filas.push_back(std::make_unique<FilaTrabalho>());
+        for (int i = 0; i < num_threads; ++i)
+            threads.emplace_back(&PoolExecucao::trabalhar, this, i);
+    }
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    PoolExecucao(const PoolExecucao &) = delete;
+    PoolExecucao &operator=(const PoolExecucao &) = delete;
+
+    ~PoolExecucao()
+    {
+        parar();
+    }
+
+    // Coloca uma tarefa na fila da thread atual (ou em uma fila escolhida em rodízio, fora do pool)
+    void submeter(TarefaRetomavel *tarefa)
+    {
+        std::size_t indice = fila_local >= 0 && pool_local == this
+                                 ? static_cast<std::size_t>(fila_local)
+                                 : proxima_fila.fetch_add(1, std::memory_order_relaxed) % filas.size();
+        {
+            std::lock_guard<std::mutex> lock(filas[indice]->mutex);
+            filas[indice]->tarefas.push_back(tarefa);
+        }
+        pendentes.fetch_add(1);
+        if (dormindo.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex_sono);
+            cond_var_sono.notify_one();
+        }
+    }
+
+    // Termina as tarefas pendentes e encerra as threads
+    void parar()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_sono);
+            parando.store(true);
+            cond_var_sono.notify_all();
+        }
+        for (auto &thread : threads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+    }
+
+private:
+    struct alignas(64) FilaTrabalho
+    {
+        std::mutex mutex;                      // Protege a fila (disputa rara: só em roubos)
+        std::deque<TarefaRetomavel *> tarefas; // Tarefas prontas para executar
+    };
+
+    std::vector<std::unique_ptr<FilaTrabalho>> filas; // Uma fila por thread
+    std::vector<std::thread> threads;                 // Threads de trabalho
+    std::atomic<int> pendentes{0};                    // Tarefas em alguma fila
+    std::atomic<int> dormindo{0};                     // Threads dormindo por falta de tarefas
+    std::atomic<bool> parando{false};                 // Pedido de encerramento
+    std::atomic<std::size_t> proxima_fila{0};         // Rodízio para submissões de fora do pool
+    std::mutex mutex_sono;                            // Mutex da espera das threads ociosas
+    std::condition_variable cond_var_sono;            // Acorda threads ociosas
+
+    static inline thread_local int fila_local = -1;                // Fila da thread atual
+    static inline thread_local PoolExecucao *pool_local = nullptr; // Pool da thread atual
+
+    // Retira uma tarefa do fim da própria fila ou rouba do início da fila de outra thread
+    TarefaRetomavel *obter(std::size_t indice)
+    {
+        {
+            FilaTrabalho &propria = *filas[indice];
+            std::lock_guard<std::mutex> lock(propria.mutex);
+            if (!propria.tarefas.empty())
+            {
+                TarefaRetomavel *tarefa = propria.tarefas.back();
+                propria.tarefas.pop_back();
+                return tarefa;
+            }
+        }
+        for (std::size_t k = 1; k < filas.size(); ++k)
+        {
+            FilaTrabalho &outra = *filas[(indice + k) % filas.size()];
+            std::lock_guard<std::mutex> lock(outra.mutex);
+            if (!outra.tarefas.empty())
+            {
+                TarefaRetomavel *tarefa = outra.tarefas.front();
+                outra.tarefas.pop_front();
+                return tarefa;
+            }
+        }
+        return nullptr;
+    }
+
+    // Laço de uma thread de trabalho
+    void trabalhar(int indice)
+    {
+        fila_local = indice;
+        pool_local = this;
+        while (true)
+        {
+            if (TarefaRetomavel *tarefa = obter(static_cast<std::size_t>(indice)))
+            {
+                pendentes.fetch_sub(1);
+                tarefa->executar();
+                continue;
+            }
+
+            // Sem tarefas: dorme até uma submissão (a contagem de ociosas pareia com a de pendentes)
+            std::unique_lock<std::mutex> lock(mutex_sono);
+            dormindo.fetch_add(1);
+            cond_var_sono.wait(lock, [this]()
+                               { return pendentes.load() > 0 || parando.load(); });
+            dormindo.fetch_sub(1);
+            if (parando.load() && pendentes.load() == 0)
+                break;
+        }
+    }
+};
+
+// Tarefa executada pelo pool. acordar() pode ser chamado várias vezes e de qualquer thread: a tarefa
+// nunca roda em duas threads ao mesmo tempo, e despertares recebidos durante uma execução geram mais
+// uma rodada. Cada rodada chama passo(), que avança a máquina de estados até a próxima espera.
+class TarefaExecutor : public TarefaRetomavel
+{
+public:
+    explicit TarefaExecutor(PoolExecucao &pool) : pool_ref(pool) {}
+
+    void acordar() override
+    {
+        if (despertares.fetch_add(1, std::memory_order_acq_rel) == 0)
+            pool_ref.submeter(this);
+    }
+
+    void executar() override
+    {
+        int vistos = despertares.load(std::memory_order_acquire);
+        do
+        {
+            passo();
+            vistos = despertares.fetch_sub(vistos, std::memory_order_acq_rel) - vistos;
+        } while (vistos != 0);
+    }
+
+protected:
+    // Avança a máquina de estados; despertares antecipados devem ser tolerados
+    virtual void passo() = 0;
+
+private:
+    PoolExecucao &pool_ref;          // Pool onde a tarefa roda
+    std::atomic<int> despertares{0}; // Despertares ainda não atendidos (0 = ociosa)
+};
+
+// Roda de temporizadores com resolução de 1 ms, que substitui sleep_for nas tarefas do executor.
+// Uma única thread avança a roda a cada tick e acorda as tarefas vencidas.
+class RodaTemporizadores
+{
+public:
+    static constexpr std::int64_t NUM_POSICOES = 1024; // Posições da roda (1 ms cada)
+
+    RodaTemporizadores() : inicio(std::chrono::steady_clock::now())
+    {
+        thread_roda = std::thread(&RodaTemporizadores::girar, this);
+    }
+
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    RodaTemporizadores(const RodaTemporizadores &) = delete;
+    RodaTemporizadores &operator=(const RodaTemporizadores &) = delete;
+
+    ~RodaTemporizadores()
+    {
+        parar();
+    }
+
+    // Acorda a tarefa no instante indicado (no próximo tick a partir dele)
+    void agendar(std::chrono::steady_clock::time_point instante, TarefaRetomavel *tarefa)
+    {
+        std::int64_t tick = (std::chrono::duration_cast<std::chrono::microseconds>(instante - inicio).count() + 999) / 1000;
+        {
+            std::lock_guard<std::mutex> lock(mutex_roda);
+            if (tick > tick_atual)
+            {
+                posicoes[tick % NUM_POSICOES].push_back(Temporizador{tick, tarefa});
+                return;
+            }
+        }
+        tarefa->acordar(); // Instante já passou
+    }
+
+    // Encerra a thread da roda (temporizadores pendentes são descartados)
+    void parar()
+    {
+        parando.store(true);
+        if (thread_roda.joinable())
+            thread_roda.join();
+    }
+
+private:
+    struct Temporizador
+    {
+        std::int64_t tick;        // Tick de vencimento
+        TarefaRetomavel *tarefa;  // Tarefa a acordar
+    };
+
+    std::chrono::steady_clock::time_point inicio;                      // Instante do tick 0
+    std::array<std::vector<Temporizador>, NUM_POSICOES> posicoes;      // Temporizadores por posição da roda
+    std::int64_t tick_atual = 0;                                       // Último tick processado
+    std::mutex mutex_roda;                                             // Protege a roda
+    std::atomic<bool> parando{false};                                  // Pedido de encerramento
+    std::thread thread_roda;                                           // Thread que avança a roda
+
+    void girar()
+    {
+        std::vector<TarefaRetomavel *> vencidas;
+        while (!parando.load())
+        {
+            std::this_thread::sleep_until(inicio + std::chrono::milliseconds(tick_atual + 1));
+            {
+                std::lock_guard<std::mutex> lock(mutex_roda);
+                ++tick_atual;
+                // Uma posição guarda temporizadores de várias voltas; só os vencidos saem
+                std::vector<Temporizador> &posicao = posicoes[tick_atual % NUM_POSICOES];
+                auto restantes = std::partition(posicao.begin(), posicao.end(), [this](const Temporizador &t)
+                                                { return t.tick > tick_atual; });
+                for (auto it = restantes; it != posicao.end(); ++it)
+                    vencidas.push_back(it->tarefa);
+                posicao.erase(restantes, posicao.end());
+            }
+            for (TarefaRetomavel *tarefa : vencidas)
+                tarefa->acordar();
+            vencidas.clear();
+        }
+    }
+};
+
+// Contador de tarefas concluídas, pelo qual a thread principal espera o fim do executor
+class ContadorConclusao
+{
+public:
+    explicit ContadorConclusao(int total) : restantes(total) {}
+
+    void concluir()
+    {
+        std::lock_guard<std::mutex> lock(mutex_conclusao);
+        if (--restantes == 0)
+            cond_var_conclusao.notify_all();
+    }
+
+    void aguardar()
+    {
+        std::unique_lock<std::mutex> lock(mutex_conclusao);
+        cond_var_conclusao.wait(lock, [this]()
+                                { return restantes == 0; });
+    }
+
+private:
+    int restantes;                              // Tarefas ainda não concluídas
+    std::mutex mutex_conclusao;                 // Protege o contador
+    std::condition_variable cond_var_conclusao; // Sinaliza a última conclusão
+};
+
+// Processo como máquina de estados no executor: mesma carga e mesmas mensagens de Processo, mas a
+// espera por vaga e o intervalo entre rajadas são temporizadores, não threads bloqueadas
+class ProcessoAssincrono : public TarefaExecutor
+{
+public:
+    ProcessoAssincrono(int pid, Spool &spool, const ParametrosCarga &carga, int tamanho_lote,
+                       PoolExecucao &pool, RodaTemporizadores &roda, ContadorConclusao &conclusao)
+        : TarefaExecutor(pool), id(pid), spool_ref(spool), roda_ref(roda), conclusao_ref(conclusao),
+          gerador(pid, carga), tamanho_lote(tamanho_lote)
+    {
+        lote.reserve(tamanho_lote);
+    }
+
+    // Quantidade de pedidos gerados (válido após a conclusão)
+    int gerados() const
+    {
+        return gerador.quantidade();
+    }
+
+    // Quantidade de pedidos descartados pelo spool (válido após a conclusão)
+    int descartados() const
+    {
+        return pedidos_descartados;
+    }
+
+protected:
+    void passo() override
+    {
+        while (true)
+        {
+            switch (estado)
+            {
+            case Estado::Inicio:
+                // Espera o instante do primeiro pedido (só um trace começa depois do instante 0)
+                estado = Estado::Pausa;
+                fim_pausa = std::chrono::steady_clock::now() + std::chrono::microseconds(gerador.atraso_inicial_us());
+                if (gerador.atraso_inicial_us() > 0)
+                {
+                    roda_ref.agendar(fim_pausa, this);
+                    return;
+                }
+                break;
+            case Estado::Gerando:
+                if (gerador.terminou())
+                {
+                    finalizar();
+                    return;
+                }
+                gerar_rajada();
+                break;
+            case Estado::Enviando:
+                if (!enviar())
+                    return; // Estacionado à espera de vaga ou do prazo
+                // Espera antes de gerar a próxima rajada os intervalos dos documentos gerados
+                estado = Estado::Pausa;
+                fim_pausa = std::chrono::steady_clock::now() + std::chrono::microseconds(pausa_us);
+                if (pausa_us > 0)
+                {
+                    roda_ref.agendar(fim_pausa, this);
+                    return;
+                }
+                break;
+            case Estado::Pausa:
+                if (std::chrono::steady_clock::now() < fim_pausa)
+                    return; // Despertar antecipado
+                estado = Estado::Gerando;
+                break;
+            case Estado::Finalizado:
+                return;
+            }
+        }
+    }
+
+private:
+    enum class Estado : std::uint8_t
+    {
+        Inicio,    // Espera o primeiro pedido
+        Gerando,   // Gera a próxima rajada
+        Enviando,  // Coloca a rajada no spool, esperando até o prazo de admissão por vaga
+        Pausa,     // Intervalo entre rajadas
+        Finalizado // Todos os pedidos gerados
+    };
+
+    int id;                                           // Identificador do processo
+    Spool &spool_ref;                                 // Referência ao spool de impressão
+    RodaTemporizadores &roda_ref;                     // Temporizadores do executor
+    ContadorConclusao &conclusao_ref;                 // Sinaliza o fim do processo
+    GeradorPedidos gerador;                           // Mesma carga do modo com threads
+    int tamanho_lote;                                 // Documentos por rajada
+    Estado estado = Estado::Inicio;                   // Estado atual
+    std::vector<Pedido> lote;                         // Rajada em envio
+    std::int64_t pausa_us = 0;                        // Intervalos dos pedidos da rajada, esperados antes da próxima
+    std::size_t enviados = 0;                         // Pedidos da rajada aceitos pelo spool
+    bool estacionado = false;                         // Registrado na espera por vagas do spool
+    std::chrono::steady_clock::time_point prazo;      // Fim da espera por vaga
+    std::chrono::steady_clock::time_point fim_pausa;  // Fim do intervalo entre rajadas
+    int pedidos_descartados = 0;                      // Contador de pedidos descartados
+
+    void gerar_rajada()
+    {
+        lote.clear();
+        enviados = 0;
+        pausa_us = 0;
+        while (static_cast<int>(lote.size()) < tamanho_lote && !gerador.terminou())
+        {
+            lote.emplace_back();
+            Pedido &pedido = lote.back();
+            pausa_us += gerador.proximo(pedido, std::chrono::system_clock::now()); // Registra o horário da solicitação
+            SPOOL_LOG_PEDIDO(TipoEvento::PedidoGerado, id, pedido.id, pedido.num_paginas, pedido.prioridade);
+        }
+        // Pedidos além do limite de taxa do processo são descartados antes do envio
+        std::size_t permitidos = spool_ref.aplicar_limite_taxa(lote.data(), lote.size());
+        pedidos_descartados += static_cast<int>(lote.size() - permitidos);
+        for (std::size_t i = permitidos; i < lote.size(); ++i)
+            logger.registrar(NivelLog::Resumo, TipoEvento::DescarteNotificado, id, lote[i].id);
+        lote.resize(permitidos);
+
+        prazo = std::chrono::steady_clock::now() + spool_ref.prazo_admissao();
+        if (spool_ref.prazo_admissao().count() > 0)
+            roda_ref.agendar(prazo, this);
+        estado = Estado::Enviando;
+    }
+
+    // Tenta colocar o restante da rajada no spool. Retorna false quando precisa esperar por vaga.
+    bool enviar()
+    {
+        if (estacionado)
+        {
+            spool_ref.cancelar_espera_vaga(this, false);
+            estacionado = false;
+        }
+        enviados += spool_ref.tentar_add_pedidos(lote.data() + enviados, lote.size() - enviados);
+        if (enviados < lote.size() && !spool_ref.encerrando() && std::chrono::steady_clock::now() < prazo)
+        {
+            spool_ref.estacionar_produtor(this);
+            estacionado = true;
+            // Tenta de novo depois de estacionar, para não perder uma vaga liberada no intervalo
+            enviados += spool_ref.tentar_add_pedidos(lote.data() + enviados, lote.size() - enviados);
+            if (enviados < lote.size() && !spool_ref.encerrando())
+                return false;
+            spool_ref.cancelar_espera_vaga(this, true);
+            estacionado = false;
+        }
+
+        // Alguns pedidos aceitos são cancelados logo depois (os que ainda estiverem na fila)
+        for (std::size_t i = 0; i < enviados; ++i)
+        {
+            if (gerador.sortear_cancelamento())
+                spool_ref.cancelar_pedido(id, lote[i].id);
+        }
+
+        // Prazo esgotado ou spool encerrando: o restante da rajada foi descartado
+        spool_ref.registrar_descartes(lote.data() + enviados, lote.size() - enviados);
+        pedidos_descartados += static_cast<int>(lote.size() - enviados);
+        for (std::size_t i = enviados; i < lote.size(); ++i)
+            logger.registrar(NivelLog::Resumo, TipoEvento::DescarteNotificado, id, lote[i].id);
+        return true;
+    }
+
+    void finalizar()
+    {
+        estado = Estado::Finalizado;
+        // Decrementa o contador de processos ativos ao finalizar; o último acorda o monitor
+        if (--processos_ativos == 0)
+            spool_ref.notificar_monitor();
+        logger.registrar(NivelLog::Resumo, TipoEvento::ProcessoFinalizado, id);
+        conclusao_ref.concluir();
+    }
+};
+
+// Impressora como máquina de estados no executor: a espera por pedidos estaciona a tarefa no spool,
+// e o tempo de impressão é um temporizador em vez de sleep_for
+class ImpressoraAssincrona : public TarefaExecutor
+{
+public:
+    ImpressoraAssincrona(int id, Spool &spool, ColunasImpressora &colunas, int tempo_por_pagina_ms, int tamanho_lote,
+                         PoolExecucao &pool, RodaTemporizadores &roda, ContadorConclusao &conclusao)
+        : TarefaExecutor(pool), id_impressora(id), spool_ref(spool), colunas_ref(colunas), roda_ref(roda),
+          conclusao_ref(conclusao), tempo_por_pagina_ms(tempo_por_pagina_ms), tamanho_lote(tamanho_lote)
+    {
+        lote.reserve(tamanho_lote);
+    }
+
+protected:
+    void passo() override
+    {
+        while (true)
+        {
+            switch (estado)
+            {
+            case Estado::Buscando:
+                if (!buscar())
+                    return; // Estacionada à espera de pedidos, ou encerrada
+                atual = 0;
+                iniciar_impressao();
+                return;
+            case Estado::Imprimindo:
+                if (std::chrono::steady_clock::now() < fim_impressao)
+                    return; // Despertar antecipado
+                concluir_impressao();
+                if (++atual < lote.size())
+                {
+                    iniciar_impressao();
+                    return;
+                }
+                estado = Estado::Buscando;
+                break;
+            case Estado::Finalizada:
+                return;
+            }
+        }
+    }
+
+private:
+    enum class Estado : std::uint8_t
+    {
+        Buscando,   // Retira um pedido (ou lote) do spool
+        Imprimindo, // Aguarda o fim da impressão do pedido atual
+        Finalizada  // Spool encerrado e vazio
+    };
+
+    int id_impressora;                                    // Identificador da impressora
+    Spool &spool_ref;                                     // Referência ao spool de impressão
+    ColunasImpressora &colunas_ref;                       // Registros desta impressora (sem lock)
+    RodaTemporizadores &roda_ref;                         // Temporizadores do executor
+    ContadorConclusao &conclusao_ref;                     // Sinaliza o fim da impressora
+    int tempo_por_pagina_ms;                              // Tempo de impressão por página
+    std::size_t tamanho_lote;                             // Pedidos retirados do spool por vez
+    Estado estado = Estado::Buscando;                     // Estado atual
+    std::vector<Pedido> lote;                             // Pedidos retirados do spool
+    std::size_t atual = 0;                                // Pedido em impressão
+    bool estacionada = false;                             // Registrada na espera por pedidos do spool
+    std::chrono::system_clock::time_point inicio;         // Horário de início da impressão
+    std::chrono::steady_clock::time_point fim_impressao;  // Fim previsto da impressão atual
+
+    // Retira pedidos do spool. Retorna false quando precisa esperar ou quando a impressora encerrou.
+    bool buscar()
+    {
+        if (estacionada)
+        {
+            spool_ref.cancelar_espera_pedido(this, false);
+            estacionada = false;
+        }
+        // O encerramento é lido antes da retirada: fila vazia depois dele significa fim do trabalho
+        bool encerrando = spool_ref.encerrando();
+        if (spool_ref.tentar_get_pedidos(lote, tamanho_lote, id_impressora) > 0)
+            return true;
+        if (!encerrando)
+        {
+            spool_ref.estacionar_consumidor(this);
+            estacionada = true;
+            // Tenta de novo depois de estacionar, para não perder um pedido publicado no intervalo
+            encerrando = spool_ref.encerrando();
+            if (spool_ref.tentar_get_pedidos(lote, tamanho_lote, id_impressora) == 0 && !encerrando)
+                return false;
+            spool_ref.cancelar_espera_pedido(this, true);
+            estacionada = false;
+            if (!lote.empty())
+                return true;
+        }
+
+        // Nenhum pedido para processar e o spool está encerrando
+        estado = Estado::Finalizada;
+        logger.registrar(NivelLog::Resumo, TipoEvento::ImpressoraEncerrando, id_impressora);
+        conclusao_ref.concluir();
+        return false;
+    }
+
+    void iniciar_impressao()
+    {
+        const Pedido &pedido = lote[atual];
+        // Mensagem de início do processamento
+        SPOOL_LOG_PEDIDO(TipoEvento::ImpressaoIniciada, id_impressora, pedido.id_processo, pedido.id,
+                         pedido.num_paginas, pedido.prioridade);
+        estado = Estado::Imprimindo;
+        colunas_ref.marcar_ocupada(true);
+        inicio = std::chrono::system_clock::now(); // Horário de início da impressão
+        fim_impressao = std::chrono::steady_clock::now() + std::chrono::milliseconds(tempo_por_pagina_ms * pedido.num_paginas);
+        roda_ref.agendar(fim_impressao, this);
+    }
+
+    void concluir_impressao()
+    {
+        const Pedido &pedido = lote[atual];
+        auto duracao = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - inicio);
+
+        // Registro da impressão nas colunas da própria impressora, sem lock global
+        bool conclui_documento = spool_ref.concluir_pedido(pedido);
+        colunas_ref.acrescentar(pedido, inicio, duracao, conclui_documento);
+        colunas_ref.marcar_ocupada(false);
+
+        // Mensagem de conclusão do processamento
+        SPOOL_LOG_PEDIDO(TipoEvento::ImpressaoConcluida, id_impressora, pedido.id_processo, pedido.id);
+    }
+};
+
+// Nome de uma métrica de latência no relatório
+const char *nome_metrica(MetricaLatencia metrica)
+{
+    switch (metrica)
+    {
+    case MetricaLatencia::Espera:
+        return "Espera na fila";
+    case MetricaLatencia::Servico:
+        return "Impressão";
+    case MetricaLatencia::PontaAPonta:
+        return "Ponta a ponta";
+    }
+    return "";
+}
+
+// Linha de percentis de um histograma, em ms
+void imprimir_linha_latencias(std::ostream &saida, const std::string &rotulo, const Histograma &histograma)
+{
+    saida << "    " << std::left << std::setw(16) << rotulo << std::right << std::setw(10) << histograma.contagem();
+    for (double p : PERCENTIS_RELATORIO)
+        saida << std::setw(10) << histograma.percentil(p) / 1000.0;
+    saida << std::setw(10) << histograma.maximo() / 1000.0 << "\n";
+}
+
+// Vazão, utilização das impressoras, percentis de latência por prioridade e por impressora e, com
+// limites de espera configurados, quantos pedidos de cada prioridade passaram do limite
+void gerar_relatorio_desempenho(const RegistrosImpressao &registros, std::ostream &saida,
+                                const ConfiguracaoEscalonamento &escalonamento)
+{
+    double janela_s = registros.duracao_janela_s();
+    std::ios_base::fmtflags formato = saida.flags();
+    std::streamsize precisao = saida.precision();
+    saida << std::fixed << std::setprecision(1);
+
+    saida << "\nVazão (janela de " << janela_s << " s): ";
+    if (janela_s > 0)
+        saida << registros.documentos() / janela_s << " pedidos/s, " << registros.total_paginas() / janela_s << " páginas/s\n";
+    else
+        saida << "sem pedidos impressos\n";
+
+    saida << "\nUtilização por Impressora:\n";
+    for (int i = 1; i <= registros.num_impressoras(); ++i)
+    {
+        double ocupado_s = std::chrono::duration<double>(registros.colunas(i).tempo_impressao()).count();
+        saida << "  Impressora " << i << " -> " << (janela_s > 0 ? 100.0 * ocupado_s / janela_s : 0.0) << "%\n";
+    }
+
+    saida << std::setprecision(2);
+    for (MetricaLatencia metrica : {MetricaLatencia::Espera, MetricaLatencia::Servico, MetricaLatencia::PontaAPonta})
+    {
+        saida << "\nLatência - " << nome_metrica(metrica) << " (ms):\n";
+        saida << "    " << std::left << std::setw(16) << "" << std::right << std::setw(10) << "Pedidos"
+              << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(10) << "máx" << "\n";
+        for (int p = PRIORIDADE_MAXIMA; p >= PRIORIDADE_MINIMA; --p)
+        {
+            Histograma histograma;
+            registros.acumular_latencias(metrica, p, 0, histograma);
+            imprimir_linha_latencias(saida, "Prioridade " + std::to_string(p), histograma);
+        }
+        for (int i = 1; i <= registros.num_impressoras(); ++i)
+        {
+            Histograma histograma;
+            registros.acumular_latencias(metrica, 0, i, histograma);
+            imprimir_linha_latencias(saida, "Impressora " + std::to_string(i), histograma);
+        }
+        Histograma histograma;
+        registros.acumular_latencias(metrica, 0, 0, histograma);
+        imprimir_linha_latencias(saida, "Total", histograma);
+    }
+
+    if (escalonamento.dinamico())
+    {
+        saida << "\nLimite de Espera por Prioridade (envelhecimento: ";
+        if (escalonamento.envelhecimento_ms > 0)
+            saida << "+1 nível a cada " << escalonamento.envelhecimento_ms << " ms):\n";
+        else
+            saida << "desligado):\n";
+        for (int p = PRIORIDADE_MAXIMA; p >= PRIORIDADE_MINIMA; --p)
+        {
+            Histograma histograma;
+            registros.acumular_latencias(MetricaLatencia::Espera, p, 0, histograma);
+            int limite_ms = escalonamento.espera_maxima_ms[p - PRIORIDADE_MINIMA];
+            saida << "  Prioridade " << p << " -> espera máxima " << histograma.maximo() / 1000.0 << " ms";
+            if (limite_ms > 0)
+            {
+                EsperasLimite esperas = registros.esperas_acima(p, std::chrono::milliseconds(limite_ms));
+                saida << ", limite " << limite_ms << " ms, " << esperas.acima << " de " << esperas.documentos
+                      << " acima do limite (" << (esperas.acima == 0 ? "cumprido" : "violado") << ")";
+            }
+            saida << "\n";
+        }
+    }
+
+    saida.flags(formato);
+    saida.precision(precisao);
+}
+
+// Documentos acima dos quais o relatório no terminal traz só o resumo
+constexpr std::size_t LIMITE_DETALHES_CONSOLE = 200;
+
+// Função para gerar o relatório final de impressão (na saída padrão ou em um arquivo). Com detalhes,
+// o resumo é seguido do bloco de cada documento, gravado pelo EscritorRelatorio.
+void gerar_relatorio(const RegistrosImpressao &registros_impressao, std::ostream &saida = std::cout,
+                     const ConfiguracaoEscalonamento &escalonamento = ConfiguracaoEscalonamento(),
+                     bool detalhes = true, int threads_formatacao = 1)
+{
+    std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex); // Uma vez para o relatório inteiro
+    saida << "-----------------------------------------\n";
+    saida << "=== RELATÓRIO FINAL ===\n\n";
+
+    // Resumo de impressão por impressora
+    saida << "Resumo de Impressão por Impressora:\n";
+    for (int impressora = 1; impressora <= registros_impressao.num_impressoras(); ++impressora)
+    {
+        saida << "  Impressora " << impressora << " -> Total de páginas impressas: "
+              << registros_impressao.colunas(impressora).total_paginas() << "\n";
+    }
+
+    gerar_relatorio_desempenho(registros_impressao, saida, escalonamento);
+    if (!detalhes)
+        return;
+
+    // Lista detalhada de cada documento processado, mesclando as colunas das impressoras
+    saida << "\nDetalhes dos Documentos Processados:\n";
+    EscritorRelatorio escritor(saida, FormatoRelatorio::Texto, threads_formatacao);
+    escritor.escrever(registros_impressao);
+}
+
+// Formata a razão entre duas vazões como "1.23x"
+std::string formatar_ganho(double razao)
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2) << razao << "x";
+    return oss.str();
+}
+
+// Parâmetros de uma medição do núcleo do spool: produtores e consumidores disputando o spool sem
+// pausas e sem mensagens por pedido
+struct ParametrosMedicao
+{
+    BackendSpool backend = BackendSpool::Mutex;                         // Backend da fila
+    int num_produtores = 1;                                             // Threads chamando add_pedido(s)
+    int num_consumidores = 1;                                           // Threads chamando get_pedido(s)
+    int capacidade_buffer = 256;                                        // Capacidade do buffer
+    int total_pedidos = 100000;                                         // Pedidos enviados (divididos entre os produtores)
+    int tamanho_lote = 1;                                               // > 1: add_pedidos/get_pedidos
+    std::array<double, NUM_PRIORIDADES> pesos_prioridade{1, 1, 1, 1, 1}; // Peso relativo de cada prioridade (1 a 5)
+    DiarioSpool *diario = nullptr;                                      // Diário opcional
+    bool ler_metricas = false;                                          // Uma thread lendo snapshot() a cada 1 ms
+};
+
+// Mede a vazão (pedidos/s) do spool. Com tamanho_lote > 1, produtores e consumidores usam
+// add_pedidos/get_pedidos; com um diário, os consumidores também registram a conclusão de cada pedido.
+// Se informados, os histogramas recebem, em ns, a espera de cada pedido no buffer (do envio à
+// retirada) e a duração de cada chamada de envio (incluindo o bloqueio com o buffer cheio); leituras,
+// se informado, recebe quantas vezes a thread de métricas leu snapshot().
+double medir_spool(const ParametrosMedicao &parametros, Histograma *espera_fila = nullptr,
+                   Histograma *chamada_envio = nullptr, std::uint64_t *leituras = nullptr)
+{
+    Spool spool(parametros.capacidade_buffer, parametros.backend, 30, parametros.diario);
+    std::atomic<int> consumidos(0);
+    int pedidos_por_produtor = parametros.total_pedidos / parametros.num_produtores;
+    int tamanho_lote = parametros.tamanho_lote;
+
+    // Um histograma por thread, pois cada histograma tem um único escritor; mesclados no final
+    std::vector<std::unique_ptr<Histograma>> esperas;
+    std::vector<std::unique_ptr<Histograma>> chamadas;
+    for (int i = 0; espera_fila != nullptr && i < parametros.num_consumidores; ++i)
+        esperas.push_back(std::make_unique<Histograma>());
+    for (int p = 0; chamada_envio != nullptr && p < parametros.num_produtores; ++p)
+        chamadas.push_back(std::make_unique<Histograma>());
+
+    auto inicio = std::chrono::steady_clock::now();
+
+    std::atomic<bool> fim_leitura(false);
+    std::atomic<std::uint64_t> total_leituras(0);
+    std::thread leitor_metricas;
+    if (parametros.ler_metricas)
+        leitor_metricas = std::thread([&spool, &fim_leitura, &total_leituras]()
+                                      {
+                                          std::uint64_t lidas = 0;
+                                          while (!fim_leitura.load(std::memory_order_relaxed))
+                                          {
+                                              MetricasSpool metricas = spool.snapshot();
+                                              lidas += metricas.ocupacao >= 0 ? 1 : 0;
+                                              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                          }
+                                          total_leituras.store(lidas); });
+
+    std::vector<std::thread> consumidores;
+    for (int i = 0; i < parametros.num_consumidores; ++i)
+    {
+        Histograma *espera = esperas.empty() ? nullptr : esperas[i].get();
+        consumidores.emplace_back([&spool, &consumidos, tamanho_lote, espera]()
+                                  {
+                                      std::vector<Pedido> lote(1);
+                                      lote.reserve(tamanho_lote);
+                                      while (true)
+                                      {
+                                          std::size_t retirados = tamanho_lote > 1
+                                                                      ? spool.get_pedidos(lote, tamanho_lote)
+                                                                      : (spool.get_pedido(lote[0]) ? 1 : 0);
+                                          if (retirados == 0)
+                                              return;
+                                          auto agora = espera != nullptr ? std::chrono::system_clock::now()
+                                                                         : std::chrono::system_clock::time_point();
+                                          for (std::size_t k = 0; k < retirados; ++k)
+                                          {
+                                              spool.concluir_pedido(lote[k]);
+                                              if (espera != nullptr)
+                                                  espera->registrar(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                        agora - lote[k].hora_solicitacao)
+                                                                        .count());
+                                          }
+                                          consumidos.fetch_add(static_cast<int>(retirados), std::memory_order_relaxed);
+                                      } });
+    }
+
+    std::vector<std::thread> produtores;
+    for (int p = 0; p < parametros.num_produtores; ++p)
+    {
+        Histograma *chamada = chamadas.empty() ? nullptr : chamadas[p].get();
+        produtores.emplace_back([&spool, &parametros, p, pedidos_por_produtor, tamanho_lote, chamada]()
+                                {
+                                    std::mt19937 gen(p + 1);
+                                    std::discrete_distribution<> prioridade_dist(parametros.pesos_prioridade.begin(),
+                                                                                 parametros.pesos_prioridade.end());
+                                    Pedido pedido;
+                                    pedido.num_paginas = 1;
+                                    pedido.id_processo = p;
+                                    std::vector<Pedido> lote;
+                                    lote.reserve(tamanho_lote);
+                                    for (int i = 0; i < pedidos_por_produtor; ++i)
+                                    {
+                                        pedido.id = i;
+                                        pedido.prioridade = PRIORIDADE_MINIMA + prioridade_dist(gen);
+                                        pedido.hora_solicitacao = std::chrono::system_clock::now();
+                                        if (tamanho_lote > 1)
+                                        {
+                                            lote.push_back(pedido);
+                                            if (static_cast<int>(lote.size()) < tamanho_lote && i + 1 < pedidos_por_produtor)
+                                                continue;
+                                        }
+                                        auto antes = chamada != nullptr ? std::chrono::steady_clock::now()
+                                                                        : std::chrono::steady_clock::time_point();
+                                        if (tamanho_lote == 1)
+                                        {
+                                            // Repete o envio em caso de descarte para manter o total comparável
+                                            while (!spool.add_pedido(pedido))
+                                                ;
+                                        }
+                                        else
+                                        {
+                                            // Reenvia apenas a parte do lote que foi descartada
+                                            std::size_t aceitos = 0;
+                                            while ((aceitos = spool.add_pedidos(lote)) < lote.size())
+                                                lote.erase(lote.begin(), lote.begin() + aceitos);
+                                            lote.clear();
+                                        }
+                                        if (chamada != nullptr)
+                                            chamada->registrar(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                   std::chrono::steady_clock::now() - antes)
+                                                                   .count());
+                                    }
+                                });
+    }
+
+    for (auto &produtor : produtores)
+        produtor.join();
+
+    // Espera a fila esvaziar antes de liberar os consumidores
+    while (consumidos.load() < pedidos_por_produtor * parametros.num_produtores)
+        std::this_thread::yield();
+    spool.encerrar_spool();
+    for (auto &consumidor : consumidores)
+        consumidor.join();
+
+    std::chrono::duration<double> duracao = std::chrono::steady_clock::now() - inicio;
+    fim_leitura.store(true);
+    if (leitor_metricas.joinable())
+        leitor_metricas.join();
+    if (leituras != nullptr)
+        *leituras = total_leituras.load();
+    for (std::size_t i = 0; espera_fila != nullptr && i < esperas.size(); ++i)
+        espera_fila->mesclar(*esperas[i]);
+    for (std::size_t p = 0; chamada_envio != nullptr && p < chamadas.size(); ++p)
+        chamada_envio->mesclar(*chamadas[p]);
+    return consumidos.load() / duracao.count();
+}
+
+// Mede a vazão de um backend com prioridades uniformes (atalho de medir_spool para os benchmarks)
+double medir_vazao_spool(BackendSpool backend, int num_produtores, int num_consumidores,
+                         int capacidade_buffer, int total_pedidos, int tamanho_lote = 1,
+                         DiarioSpool *diario = nullptr)
+{
+    ParametrosMedicao parametros;
+    parametros.backend = backend;
+    parametros.num_produtores = num_produtores;
+    parametros.num_consumidores = num_consumidores;
+    parametros.capacidade_buffer = capacidade_buffer;
+    parametros.total_pedidos = total_pedidos;
+    parametros.tamanho_lote = tamanho_lote;
+    parametros.diario = diario;
+    return medir_spool(parametros);
+}
+
+// Benchmark de contenção: compara a fila com mutex único ao backend lock-free por prioridade
+void executar_benchmark_contencao()
+{
+    logger.definir_nivel(NivelLog::Silencioso); // Mede apenas o spool, sem a saída por pedido
+
+    const int capacidade_buffer = 1024;
+    const int total_pedidos = 200000;
+    const std::vector<std::pair<int, int>> cenarios = {{1, 1}, {4, 4}, {16, 4}, {4, 16}, {64, 16}, {256, 32}};
+
+    std::cout << "=== BENCHMARK DE CONTENÇÃO DO SPOOL ===\n";
+    std::cout << "Capacidade do buffer: " << capacidade_buffer << ", pedidos por cenário: " << total_pedidos << "\n\n";
+    std::cout << std::left << std::setw(12) << "Produtores" << std::setw(14) << "Impressoras"
+              << std::setw(20) << "Mutex (pedidos/s)" << std::setw(23) << "Lock-free (pedidos/s)" << "Ganho\n";
+
+    for (const auto &[num_produtores, num_consumidores] : cenarios)
+    {
+        double vazao_mutex = medir_vazao_spool(BackendSpool::Mutex, num_produtores, num_consumidores,
+                                               capacidade_buffer, total_pedidos);
+        double vazao_lock_free = medir_vazao_spool(BackendSpool::LockFree, num_produtores, num_consumidores,
+                                                   capacidade_buffer, total_pedidos);
+        std::cout << std::left << std::setw(12) << num_produtores << std::setw(14) << num_consumidores
+                  << std::setw(20) << std::fixed << std::setprecision(0) << vazao_mutex
+                  << std::setw(23) << vazao_lock_free << formatar_ganho(vazao_lock_free / vazao_mutex) << "\n";
+    }
+}
+
+// Benchmark de lotes: compara operações pedido a pedido com add_pedidos/get_pedidos
+void executar_benchmark_lotes()
+{
+    logger.definir_nivel(NivelLog::Silencioso); // Mede apenas o spool, sem a saída por pedido
+
+    const int capacidade_buffer = 1024;
+    const int total_pedidos = 200000;
+    const int num_produtores = 16;
+    const int num_consumidores = 4;
+    const std::vector<int> tamanhos_lote = {1, 4, 16, 64};
+
+    std::cout << "\n=== BENCHMARK DE LOTES DO SPOOL ===\n";
+    std::cout << "Produtores: " << num_produtores << ", impressoras: " << num_consumidores
+              << ", capacidade do buffer: " << capacidade_buffer << ", pedidos por cenário: " << total_pedidos << "\n\n";
+    std::cout << std::left << std::setw(8) << "Lote" << std::setw(20) << "Mutex (pedidos/s)" << std::setw(10) << "Ganho"
+              << std::setw(23) << "Lock-free (pedidos/s)" << "Ganho\n";
+
+    double base_mutex = 0.0, base_lock_free = 0.0;
+    for (int tamanho_lote : tamanhos_lote)
+    {
+        double vazao_mutex = medir_vazao_spool(BackendSpool::Mutex, num_produtores, num_consumidores,
+                                               capacidade_buffer, total_pedidos, tamanho_lote);
+        double vazao_lock_free = medir_vazao_spool(BackendSpool::LockFree, num_produtores, num_consumidores,
+                                                   capacidade_buffer, total_pedidos, tamanho_lote);
+        if (tamanho_lote == 1)
+        {
+            base_mutex = vazao_mutex;
+            base_lock_free = vazao_lock_free;
+        }
+        std::cout << std::left << std::setw(8) << tamanho_lote << std::fixed << std::setprecision(0)
+                  << std::setw(20) << vazao_mutex << std::setw(10) << formatar_ganho(vazao_mutex / base_mutex)
+                  << std::setw(23) << vazao_lock_free << formatar_ganho(vazao_lock_free / base_lock_free) << "\n";
+    }
+}
+
+// Benchmark do diário: vazão do spool sem diário, com diário sem msync e com commit em grupo,
+// e o tempo de recuperação de um diário com milhões de registros
+void executar_benchmark_diario()
+{
+    logger.definir_nivel(NivelLog::Silencioso); // Mede apenas o spool, sem a saída por pedido
+
+    const int capacidade_buffer = 1024;
+    const int total_pedidos = 200000;
+    const int num_produtores = 4;
+    const int num_consumidores = 4;
+    const std::filesystem::path diretorio = std::filesystem::temp_directory_path() / "spool_benchmark_diario";
+
+    std::cout << "\n=== BENCHMARK DO DIÁRIO DO SPOOL ===\n";
+    std::cout << "Produtores: " << num_produtores << ", impressoras: " << num_consumidores
+              << ", capacidade do buffer: " << capacidade_buffer << ", pedidos por cenário: " << total_pedidos << "\n\n";
+    std::cout << std::left << std::setw(31) << "Diário" << std::setw(20) << "Mutex (pedidos/s)" << std::setw(10) << "Custo"
+              << std::setw(23) << "Lock-free (pedidos/s)" << "Custo\n";
+
+    const std::vector<std::pair<const char *, int>> cenarios = {
+        {"desligado", -1}, {"sem msync", 0}, {"commit em grupo (10 ms)", 10}, {"commit em grupo (1 ms)", 1}};
+    double base_mutex = 0.0, base_lock_free = 0.0;
+    for (const auto &[nome, intervalo_ms] : cenarios)
+    {
+        double vazoes[2];
+        const BackendSpool backends[2] = {BackendSpool::Mutex, BackendSpool::LockFree};
+        for (int b = 0; b < 2; ++b)
+        {
+            std::filesystem::remove_all(diretorio);
+            std::unique_ptr<DiarioSpool> diario;
+            if (intervalo_ms >= 0)
+                diario = std::make_unique<DiarioSpool>(diretorio.string(), intervalo_ms);
+            vazoes[b] = medir_vazao_spool(backends[b], num_produtores, num_consumidores, capacidade_buffer,
+                                          total_pedidos, 1, diario.get());
+        }
+        if (intervalo_ms < 0)
+        {
+            base_mutex = vazoes[0];
+            base_lock_free = vazoes[1];
+        }
+        std::cout << std::left << std::setw(30) << nome << std::fixed << std::setprecision(0)
+                  << std::setw(20) << vazoes[0] << std::setw(10) << formatar_ganho(vazoes[0] / base_mutex)
+                  << std::setw(23) << vazoes[1] << formatar_ganho(vazoes[1] / base_lock_free) << "\n";
+    }
+
+    // Recuperação: 2 milhões de enfileiramentos, metade retirada e concluída
+    const int enfileirados = 2000000;
+    std::filesystem::remove_all(diretorio);
+    {
+        DiarioSpool diario(diretorio.string(), 0);
+        Pedido pedido;
+        pedido.num_paginas = 1;
+        pedido.id_processo = 1;
+        pedido.hora_solicitacao = std::chrono::system_clock::now();
+        for (int i = 0; i < enfileirados; ++i)
+        {
+            pedido.id = i;
+            pedido.prioridade = PRIORIDADE_MINIMA + i % NUM_PRIORIDADES;
+            pedido.sequencia = diario.registrar_enfileirado(pedido);
+            if (i % 2 == 0)
+            {
+                diario.registrar_retirado(pedido);
+                diario.registrar_concluido(pedido);
+            }
+        }
+    }
+    {
+        auto inicio = std::chrono::steady_clock::now();
+        DiarioSpool reaberto(diretorio.string(), 0);
+        Spool spool(capacidade_buffer, BackendSpool::Mutex, 30, &reaberto); // Fila de prioridade reconstruída
+        std::chrono::duration<double, std::milli> duracao = std::chrono::steady_clock::now() - inicio;
+        const RecuperacaoDiario &recuperacao = reaberto.recuperacao();
+        std::cout << "\nRecuperação: " << recuperacao.registros_lidos << " registros em " << recuperacao.segmentos
+                  << " segmentos, " << recuperacao.pedidos_recuperados << " pedidos pendentes de volta à fila em "
+                  << std::setprecision(1) << duracao.count() << " ms (leitura do diário: " << recuperacao.duracao_ms << " ms)\n";
+    }
+    std::filesystem::remove_all(diretorio);
+}
+
+// Benchmark dos registros de impressão: vetor compartilhado com nomes em std::string e mapa de
+// páginas sob um mutex global (formato anterior) contra as colunas por impressora
+void executar_benchmark_registros()
+{
+    const int num_impressoras = 4;
+    const int registros_por_impressora = 250000;
+    const int total_registros = num_impressoras * registros_por_impressora;
+
+    // Pedidos já concluídos e os nomes usados pelo formato anterior, preparados fora da medição
+    std::vector<std::vector<Pedido>> pedidos(num_impressoras);
+    std::vector<std::vector<std::string>> nomes(num_impressoras);
+    for (int impressora = 0; impressora < num_impressoras; ++impressora)
+    {
+        pedidos[impressora].resize(registros_por_impressora);
+        nomes[impressora].resize(registros_por_impressora);
+        for (int i = 0; i < registros_por_impressora; ++i)
+        {
+            Pedido &pedido = pedidos[impressora][i];
+            pedido.id = impressora * registros_por_impressora + i;
+            pedido.id_processo = 1 + i % 200;
+            nomes[impressora][i] = nome_documento(pedido.id_processo, pedido.id);
+            pedido.num_paginas = 1 + i % 10;
+            pedido.prioridade = 1 + i % 5;
+            pedido.hora_solicitacao = std::chrono::system_clock::now();
+        }
+    }
+
+    std::cout << "\n=== BENCHMARK DOS REGISTROS DE IMPRESSÃO ===\n";
+    std::cout << "Impressoras: " << num_impressoras << ", registros: " << total_registros << "\n\n";
+
+    // Antes: um vetor compartilhado com nome em std::string e contagem de páginas em mapa, sob um mutex
+    struct RegistroLegado
+    {
+        std::string nome_documento;
+        int num_paginas;
+        int id_processo;
+        int id_impressora;
+        std::chrono::system_clock::time_point hora_solicitacao;
+        std::chrono::system_clock::time_point hora_inicio;
+        std::chrono::milliseconds tempo_total;
+        int prioridade;
+    };
+    double vazao_legado, bytes_legado;
+    {
+        std::vector<RegistroLegado> registros;
+        std::unordered_map<int, int> paginas_por_impressora;
+        std::mutex registro_mutex;
+        auto inicio = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int impressora = 0; impressora < num_impressoras; ++impressora)
+        {
+            threads.emplace_back([&, impressora]()
+                                 {
+                                     auto agora = std::chrono::system_clock::now();
+                                     for (int i = 0; i < registros_por_impressora; ++i)
+                                     {
+                                         const Pedido &pedido = pedidos[impressora][i];
+                                         std::lock_guard<std::mutex> lock(registro_mutex);
+                                         RegistroLegado registro;
+                                         registro.nome_documento = nomes[impressora][i];
+                                         registro.num_paginas = pedido.num_paginas;
+                                         registro.id_processo = pedido.id_processo;
+                                         registro.id_impressora = impressora + 1;
+                                         registro.hora_solicitacao = pedido.hora_solicitacao;
+                                         registro.hora_inicio = agora;
+                                         registro.tempo_total = std::chrono::milliseconds(10);
+                                         registro.prioridade = pedido.prioridade;
+                                         registros.push_back(registro);
+                                         paginas_por_impressora[impressora + 1] += pedido.num_paginas;
+                                     } });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        std::chrono::duration<double> duracao = std::chrono::steady_clock::now() - inicio;
+        vazao_legado = total_registros / duracao.count();
+
+        // Memória: capacidade do vetor e texto dos nomes fora do buffer interno da std::string
+        std::size_t bytes = registros.capacity() * sizeof(RegistroLegado);
+        for (const auto &registro : registros)
+        {
+            if (registro.nome_documento.capacity() > std::string().capacity())
+                bytes += registro.nome_documento.capacity() + 1;
+        }
+        bytes_legado = static_cast<double>(bytes) / total_registros;
+    }
+
+    // Depois: colunas por impressora, sem lock e sem strings
+    double vazao_colunas, bytes_colunas;
+    {
+        RegistrosImpressao registros(num_impressoras);
+        auto inicio = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int impressora = 0; impressora < num_impressoras; ++impressora)
+        {
+            threads.emplace_back([&, impressora]()
+                                 {
+                                     auto agora = std::chrono::system_clock::now();
+                                     ColunasImpressora &colunas = registros.colunas(impressora + 1);
+                                     for (const Pedido &pedido : pedidos[impressora])
+                                         colunas.acrescentar(pedido, agora, std::chrono::milliseconds(10)); });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        std::chrono::duration<double> duracao = std::chrono::steady_clock::now() - inicio;
+        vazao_colunas = total_registros / duracao.count();
+
+        std::size_t bytes = 0;
+        for (int impressora = 1; impressora <= num_impressoras; ++impressora)
+            bytes += registros.colunas(impressora).memoria_bytes();
+        bytes_colunas = static_cast<double>(bytes) / total_registros;
+    }
+
+    std::cout << std::left << std::setw(28) << "Armazenamento" << std::setw(20) << "Bytes por registro"
+              << "Inserções/s\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(28) << "Vetor + mutex (antes)" << std::setw(20) << bytes_legado
+              << std::setprecision(0) << vazao_legado << "\n";
+    std::cout << std::setprecision(1) << std::setw(28) << "Colunas por impressora" << std::setw(20) << bytes_colunas
+              << std::setprecision(0) << vazao_colunas << " (" << formatar_ganho(vazao_colunas / vazao_legado) << ")\n";
+}
+
+// Benchmark do relatório: grava 1 milhão de registros em arquivo no formato anterior (horário com
+// localtime e ostringstream duas vezes por documento, um lock por documento) e com o EscritorRelatorio
+// em cada formato, com uma e com várias threads de formatação
+void executar_benchmark_relatorio()
+{
+    const int num_impressoras = 4;
+    const int registros_por_impressora = 250000;
+    const std::size_t total_registros = static_cast<std::size_t>(num_impressoras) * registros_por_impressora;
+    const int num_threads = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+
+    // Registros de impressoras que terminam um pedido a cada 2 ms, preparados fora da medição
+    RegistrosImpressao registros(num_impressoras);
+    auto base = std::chrono::system_clock::now();
+    for (int impressora = 1; impressora <= num_impressoras; ++impressora)
+    {
+        for (int i = 0; i < registros_por_impressora; ++i)
+        {
+            Pedido pedido;
+            pedido.id = i;
+            pedido.id_processo = 1 + i % 200;
+            pedido.num_paginas = 1 + i % 10;
+            pedido.prioridade = 1 + i % 5;
+            pedido.hora_solicitacao = base + std::chrono::milliseconds(2 * i);
+            registros.colunas(impressora).acrescentar(pedido, pedido.hora_solicitacao + std::chrono::milliseconds(1),
+                                                      std::chrono::milliseconds(1));
+        }
+    }
+    std::filesystem::path caminho = std::filesystem::temp_directory_path() / "benchmark_relatorio.tmp";
+
+    std::cout << "\n=== BENCHMARK DO RELATÓRIO EM ARQUIVO ===\n";
+    std::cout << "Registros: " << total_registros << "\n\n";
+    std::cout << std::left << std::setw(28) << "Formato" << std::right << std::setw(8) << "Threads" << std::setw(16)
+              << "Registros/s" << std::setw(10) << "MB/s" << std::setw(20) << "10M registros (s)" << "\n";
+    auto imprimir_linha = [&caminho, total_registros](const std::string &nome, int threads,
+                                                      std::chrono::duration<double> duracao)
+    {
+        double megabytes = static_cast<double>(std::filesystem::file_size(caminho)) / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(28) << nome << std::right << std::setw(8) << threads << std::fixed
+                  << std::setprecision(0) << std::setw(16) << total_registros / duracao.count() << std::setw(10)
+                  << megabytes / duracao.count() << std::setprecision(2) << std::setw(20)
+                  << duracao.count() * 1e7 / total_registros << "\n";
+    };
 
-// Mutex global para sincronizar o acesso ao std::cout
-std::mutex cout_mutex;
+    // Antes: vetor mesclado e, por documento, o lock do terminal e o horário formatado com ostringstream
+    {
+        auto horario_legado = [](std::chrono::system_clock::time_point instante)
+        {
+            std::time_t t = std::chrono::system_clock::to_time_t(instante);
+            std::tm tm;
+#ifdef _WIN32
+            localtime_s(&tm, &t);
+#else
+            localtime_r(&t, &tm);
+#endif
+            std::ostringstream oss;
+            oss << std::put_time(&tm, "%H:%M:%S");
+            return oss.str();
+        };
+        auto inicio = std::chrono::steady_clock::now();
+        std::ofstream arquivo(caminho);
+        std::vector<RegistroImpressao> mesclados;
+        mesclados.reserve(total_registros);
+        registros.percorrer([&mesclados](const RegistroImpressao &registro)
+                            { mesclados.push_back(registro); });
+        for (const auto &registro : mesclados)
+        {
+            std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+            arquivo << "-----------------------------------------\n";
+            arquivo << "Documento         : " << nome_documento(registro.id_processo, registro.id_pedido) << "\n";
+            arquivo << "Páginas           : " << registro.num_paginas << "\n";
+            arquivo << "Processo          : " << registro.id_processo << "\n";
+            arquivo << "Impressora        : " << registro.id_impressora << "\n";
+            arquivo << "Prioridade        : " << registro.prioridade << "\n";
+            arquivo << "Hora Solicitação  : " << horario_legado(registro.hora_solicitacao) << "\n";
+            arquivo << "Hora Impressão    : " << horario_legado(registro.hora_inicio) << "\n";
+            arquivo << "Tempo Total       : " << registro.tempo_total.count() << "ms\n";
+            arquivo << "-----------------------------------------\n\n";
+        }
+        arquivo.close();
+        imprimir_linha("texto (antes)", 1, std::chrono::steady_clock::now() - inicio);
+    }
 
-// Mutex e variável para rastrear o último pedido recebido
-std::mutex last_request_mutex;
-std::chrono::system_clock::time_point last_request_time;
+    // Depois: EscritorRelatorio em cada formato
+    for (FormatoRelatorio formato : {FormatoRelatorio::Texto, FormatoRelatorio::Csv, FormatoRelatorio::JsonLinhas,
+                                     FormatoRelatorio::Binario})
+    {
+        for (int threads : {1, num_threads})
+        {
+            auto inicio = std::chrono::steady_clock::now();
+            std::ofstream arquivo(caminho, std::ios::out | std::ios::binary);
+            EscritorRelatorio(arquivo, formato, threads).escrever(registros);
+            arquivo.close();
+            imprimir_linha(nome_formato(formato), threads, std::chrono::steady_clock::now() - inicio);
+        }
+    }
+    std::filesystem::remove(caminho);
+}
 
-// Estrutura que define um pedido de impressão
-struct Pedido
+// Benchmark do simulador de eventos discretos: um dia de tráfego para 200 impressoras em uma única thread
+void executar_benchmark_simulador()
 {
-    int id;                                                 // Identificador único do pedido
-    std::string nome_documento;                             // Nome do documento a ser impresso
-    int num_paginas;                                        // Número de páginas do documento
-    int prioridade;                                         // Prioridade do pedido (1 a 5)
-    int id_processo;                                        // Identificador do processo que gerou o pedido
-    std::chrono::system_clock::time_point hora_solicitacao; // Horário da solicitação
+    Configuracao config;
+    config.num_processos = 400;
+    config.num_impressoras = 200;
+    config.capacidade_buffer = 256;
+    config.tempo_por_pagina_ms = 50;
+    config.tempo_limite_inatividade_s = 3600;
+    config.carga.pedidos_por_processo = 5000;
+    config.carga.intervalo_ms = 17000; // ~5000 pedidos por processo em um dia
+    config.carga.semente = 42;
+    config.simulado = true;
 
-    // Sobrecarga do operador < para definir a ordem de prioridade na fila
-    bool operator<(const Pedido &outro) const
+    std::cout << "\n=== BENCHMARK DO SIMULADOR ===\n";
+    std::cout << "Processos: " << config.num_processos << ", impressoras: " << config.num_impressoras
+              << ", pedidos: " << config.num_processos * config.carga.pedidos_por_processo << "\n\n";
+
+    RegistrosImpressao registros(config.num_impressoras);
+    SimuladorSpool simulador(config, registros);
+    auto inicio = std::chrono::steady_clock::now();
+    simulador.executar();
+    std::chrono::duration<double> duracao = std::chrono::steady_clock::now() - inicio;
+
+    double horas_simuladas = std::chrono::duration<double, std::ratio<3600>>(simulador.tempo_simulado()).count();
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Tempo simulado          : " << horas_simuladas << " h\n";
+    std::cout << "Tempo real              : " << std::setprecision(3) << duracao.count() << " s\n";
+    std::cout << "Pedidos impressos       : " << registros.total() << " (descartados: " << simulador.descartados() << ")\n";
+    std::cout << std::setprecision(0);
+    std::cout << "Pedidos simulados/s     : " << registros.total() / duracao.count() << "\n";
+    std::cout << "Eventos/s               : " << simulador.eventos_processados() / duracao.count() << "\n";
+}
+
+// Compara as políticas de admissão com o spool sobrecarregado (chegadas acima da capacidade das
+// impressoras), no simulador: descartes, despejos e espera p99 das prioridades 5 e 1
+void executar_benchmark_admissao()
+{
+    Configuracao config;
+    config.num_processos = 64;
+    config.num_impressoras = 8;
+    config.capacidade_buffer = 64;
+    config.tempo_por_pagina_ms = 10;
+    config.tempo_limite_inatividade_s = 3600;
+    config.carga.pedidos_por_processo = 2000;
+    config.carga.intervalo_ms = 300; // ~1,5x a capacidade das impressoras
+    config.carga.semente = 42;
+    config.simulado = true;
+
+    std::cout << "\n=== BENCHMARK DE ADMISSÃO (SOBRECARGA, SIMULADOR) ===\n";
+    std::cout << "Processos: " << config.num_processos << ", impressoras: " << config.num_impressoras
+              << ", capacidade: " << config.capacidade_buffer << ", prazo: " << config.admissao.prazo_ms << " ms\n\n";
+    std::cout << std::left << std::setw(27) << "Política" << std::right << std::setw(11) << "Impressos" << std::setw(12)
+              << "Rejeitados" << std::setw(12) << "Despejados" << std::setw(16) << "p99 espera P5" << std::setw(16)
+              << "p99 espera P1" << "\n";
+
+    const PoliticaAdmissao politicas[] = {PoliticaAdmissao::Bloquear, PoliticaAdmissao::Rejeitar,
+                                          PoliticaAdmissao::DespejarMenorPrioridade, PoliticaAdmissao::DespejarMaisAntigo};
+    for (PoliticaAdmissao politica : politicas)
     {
-        // Maior prioridade (valor maior) tem precedência
-        if (prioridade == outro.prioridade)
+        config.admissao.politica = politica;
+        RegistrosImpressao registros(config.num_impressoras);
+        SimuladorSpool simulador(config, registros);
+        simulador.executar();
+
+        Histograma espera_p5;
+        Histograma espera_p1;
+        registros.acumular_latencias(MetricaLatencia::Espera, PRIORIDADE_MAXIMA, 0, espera_p5);
+        registros.acumular_latencias(MetricaLatencia::Espera, PRIORIDADE_MINIMA, 0, espera_p1);
+        const ResumoAdmissao &admissao = simulador.admissao_pedidos();
+        std::cout << std::left << std::setw(26) << nome_politica(politica) << std::right << std::setw(11)
+                  << registros.total() << std::setw(12) << admissao.rejeitados << std::setw(12) << admissao.despejados
+                  << std::fixed << std::setprecision(1) << std::setw(13) << espera_p5.percentil(99.0) / 1000.0 << " ms"
+                  << std::setw(13) << espera_p1.percentil(99.0) / 1000.0 << " ms\n";
+    }
+}
+
+// Custo da retirada com a fila cheia (100 mil pedidos, prioridades uniformes, solicitações espalhadas
+// em 10 s): std::priority_queue, FIFOs por nível com prioridade estática e com envelhecimento. Depois,
+// um cenário de inanição no simulador: carga de prioridade 5 acima da capacidade das impressoras
+void executar_benchmark_escalonamento()
+{
+    const int pedidos_na_fila = 100000;
+    const int operacoes = 2000000;
+
+    std::cout << "\n=== BENCHMARK DO ESCALONAMENTO ===\n";
+    std::cout << "Pedidos na fila: " << pedidos_na_fila << ", operações (retirada + inserção): " << operacoes << "\n\n";
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> prioridade_dist(PRIORIDADE_MINIMA, PRIORIDADE_MAXIMA);
+    auto base = std::chrono::system_clock::now();
+    std::vector<Pedido> pedidos(pedidos_na_fila + operacoes);
+    for (std::size_t i = 0; i < pedidos.size(); ++i)
+    {
+        pedidos[i].id = static_cast<int>(i);
+        pedidos[i].prioridade = prioridade_dist(gen);
+        pedidos[i].hora_solicitacao = base + std::chrono::microseconds(i * 100);
+    }
+    auto agora = base + std::chrono::seconds(10);
+
+    // Soma dos identificadores retirados, exibida para que o compilador não descarte as retiradas
+    std::int64_t soma_ids = 0;
+    auto medir = [&](auto &&retirar_inserir)
+    {
+        auto inicio = std::chrono::steady_clock::now();
+        for (int i = 0; i < operacoes; ++i)
+            soma_ids += retirar_inserir(pedidos[pedidos_na_fila + i]);
+        std::chrono::duration<double, std::nano> duracao = std::chrono::steady_clock::now() - inicio;
+        return duracao.count() / operacoes;
+    };
+
+    std::priority_queue<Pedido> heap;
+    for (int i = 0; i < pedidos_na_fila; ++i)
+        heap.push(pedidos[i]);
+    double ns_heap = medir([&](const Pedido &novo)
+                           {
+                               int id = heap.top().id;
+                               heap.pop();
+                               heap.push(novo);
+                               return id; });
+
+    FilaPrioridades estatica;
+    for (int i = 0; i < pedidos_na_fila; ++i)
+        estatica.inserir(pedidos[i]);
+    double ns_estatica = medir([&](const Pedido &novo)
+                               {
+                                   int id = estatica.topo().id;
+                                   estatica.remover_topo();
+                                   estatica.inserir(novo);
+                                   return id; });
+
+    ConfiguracaoEscalonamento envelhecimento;
+    envelhecimento.envelhecimento_ms = 500;
+    envelhecimento.espera_maxima_ms = {5000, 4000, 3000, 2000, 1000};
+    FilaPrioridades dinamica(envelhecimento);
+    for (int i = 0; i < pedidos_na_fila; ++i)
+        dinamica.inserir(pedidos[i]);
+    double ns_dinamica = medir([&](const Pedido &novo)
+                               {
+                                   int id = dinamica.topo(agora).id;
+                                   dinamica.remover_topo();
+                                   dinamica.inserir(novo);
+                                   return id; });
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "std::priority_queue                : " << ns_heap << " ns por operação\n";
+    std::cout << "FIFOs por nível, estática          : " << ns_estatica << " ns por operação\n";
+    std::cout << "FIFOs por nível, com envelhecimento: " << ns_dinamica << " ns por operação\n";
+    std::cout << "(soma de verificação: " << soma_ids << ")\n";
+
+    Configuracao config;
+    config.num_processos = 40;
+    config.num_impressoras = 4;
+    config.capacidade_buffer = 200;
+    config.tempo_por_pagina_ms = 10;
+    config.tempo_limite_inatividade_s = 3600;
+    config.carga.pedidos_por_processo = 500;
+    config.carga.intervalo_ms = 150;
+    config.carga.pesos_prioridade = {1, 0, 0, 0, 9};
+    config.carga.semente = 42;
+    config.simulado = true;
+
+    std::cout << "\nInanição (simulador): " << config.num_processos << " processos, " << config.num_impressoras
+              << " impressoras, 90% dos pedidos com prioridade 5\n\n";
+    std::cout << std::left << std::setw(34) << "Escalonamento" << std::right << std::setw(18) << "Espera máx. P1"
+              << std::setw(16) << "p99 espera P5" << "\n";
+
+    ConfiguracaoEscalonamento so_envelhecimento;
+    so_envelhecimento.envelhecimento_ms = 500;
+    ConfiguracaoEscalonamento limite_p1;
+    limite_p1.espera_maxima_ms[0] = 3000;
+    const std::pair<const char *, ConfiguracaoEscalonamento> cenarios[] = {
+        {"prioridade estática", ConfiguracaoEscalonamento()},
+        {"envelhecimento (+1 a cada 500 ms)", so_envelhecimento},
+        {"espera máxima P1 = 3000 ms", limite_p1}};
+    for (const auto &cenario : cenarios)
+    {
+        config.escalonamento = cenario.second;
+        RegistrosImpressao registros(config.num_impressoras);
+        SimuladorSpool simulador(config, registros);
+        simulador.executar();
+
+        Histograma espera_p1;
+        Histograma espera_p5;
+        registros.acumular_latencias(MetricaLatencia::Espera, PRIORIDADE_MINIMA, 0, espera_p1);
+        registros.acumular_latencias(MetricaLatencia::Espera, PRIORIDADE_MAXIMA, 0, espera_p5);
+        std::cout << std::left << std::setw(33) << cenario.first << std::right << std::setw(15)
+                  << espera_p1.maximo() / 1000.0 << " ms" << std::setw(13) << espera_p5.percentil(99.0) / 1000.0
+                  << " ms\n";
+    }
+}
+
+// Compara as políticas de despacho no simulador, com impressoras de velocidades diferentes: makespan
+// (da primeira solicitação ao último término) e tempo médio de conclusão (ponta a ponta), com a
+// diferença em relação à fila compartilhada
+void executar_benchmark_despacho()
+{
+    Configuracao config;
+    config.num_processos = 20;
+    config.num_impressoras = 8;
+    config.tempos_por_pagina_impressoras = {2, 2, 5, 5, 10, 10, 20, 40};
+    config.tempo_limite_inatividade_s = 3600;
+    config.carga.paginas_min = 1;
+    config.carga.paginas_max = 100;
+    config.carga.semente = 42;
+    config.simulado = true;
+
+    std::cout << "\n=== BENCHMARK DO DESPACHO (SIMULADOR) ===\n";
+    std::cout << "Impressoras: " << config.num_impressoras << " (ms por página: 2, 2, 5, 5, 10, 10, 20, 40), páginas: "
+              << config.carga.paginas_min << ":" << config.carga.paginas_max << "\n";
+
+    struct Cenario
+    {
+        const char *nome;
+        int pedidos_por_processo;
+        int intervalo_ms;
+        std::vector<double> pesos;
+        int capacidade;
+    };
+    const Cenario cenarios[] = {
+        {"Lote único (todos os pedidos no início, uma prioridade)", 50, 0, {0, 0, 1, 0, 0}, 100000},
+        {"Chegadas contínuas (~90% da capacidade, cinco prioridades)", 200, 650, {1, 1, 1, 1, 1}, 256}};
+    const PoliticaDespacho politicas[] = {PoliticaDespacho::Compartilhada, PoliticaDespacho::MenorPrimeiro,
+                                          PoliticaDespacho::PorTamanho, PoliticaDespacho::FilasLocais};
+
+    for (const Cenario &cenario : cenarios)
+    {
+        config.carga.pedidos_por_processo = cenario.pedidos_por_processo;
+        config.carga.intervalo_ms = cenario.intervalo_ms;
+        config.carga.pesos_prioridade = cenario.pesos;
+        config.capacidade_buffer = cenario.capacidade;
+
+        std::cout << "\n" << cenario.nome << ", " << config.num_processos * cenario.pedidos_por_processo << " pedidos\n";
+        std::cout << std::left << std::setw(16) << "Despacho" << std::right << std::setw(14) << "Makespan"
+                  << std::setw(10) << "Ganho" << std::setw(23) << "Conclusão média" << std::setw(10) << "Ganho" << "\n";
+
+        double makespan_base = 0.0;
+        double conclusao_base = 0.0;
+        for (PoliticaDespacho politica : politicas)
         {
-            // Se as prioridades forem iguais, o pedido mais antigo tem precedência
-            return hora_solicitacao > outro.hora_solicitacao;
+            config.despacho = politica;
+            RegistrosImpressao registros(config.num_impressoras);
+            SimuladorSpool simulador(config, registros);
+            simulador.executar();
+
+            Histograma ponta_a_ponta;
+            registros.acumular_latencias(MetricaLatencia::PontaAPonta, 0, 0, ponta_a_ponta);
+            double makespan = registros.duracao_janela_s();
+            double conclusao = ponta_a_ponta.media() / 1e6;
+            if (politica == PoliticaDespacho::Compartilhada)
+            {
+                makespan_base = makespan;
+                conclusao_base = conclusao;
+            }
+            std::cout << std::left << std::setw(16) << nome_despacho(politica) << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(12) << makespan << " s" << std::setprecision(1)
+                      << std::setw(9) << 100.0 * (makespan_base - makespan) / makespan_base << "%" << std::setprecision(2)
+                      << std::setw(20) << conclusao << " s" << std::setprecision(1) << std::setw(9)
+                      << 100.0 * (conclusao_base - conclusao) / conclusao_base << "%\n";
         }
-        return prioridade < outro.prioridade;
     }
-};
+}
 
-// Estrutura que armazena os dados de um pedido processado
-struct RegistroImpressao
+// Pedidos gerados por segundo por um único GeradorPedidos (páginas, prioridade e intervalo de cada
+// pedido, sem o spool), para cada processo de chegada e distribuição de páginas, e a leitura e a
+// reprodução de um trace de um milhão de pedidos
+void executar_benchmark_carga()
 {
-    std::string nome_documento;                             // Nome do documento
-    int num_paginas;                                        // Número de páginas
-    int id_processo;                                        // Identificador do processo solicitante
-    int id_impressora;                                      // Identificador da impressora utilizada
-    std::chrono::system_clock::time_point hora_solicitacao; // Horário da solicitação
-    std::chrono::system_clock::time_point hora_inicio;      // Horário de início da impressão
-    std::chrono::milliseconds tempo_total;                  // Tempo total de impressão
-    int prioridade;                                         // Prioridade do pedido
-};
+    const int total_pedidos = 2000000;
+    std::cout << "\n=== BENCHMARK DO GERADOR DE CARGA ===\n";
+    std::cout << "Pedidos por cenário: " << total_pedidos << " (uma thread, sem o spool; meta: 1 milhão/s)\n\n";
+    std::cout << std::left << std::setw(32) << "Carga" << std::right << std::setw(16) << "Pedidos/s" << std::setw(19)
+              << "Intervalo médio" << std::setw(17) << "Páginas médias" << "\n";
 
-// Contador global de processos ativos
-std::atomic<int> processos_ativos(0);
+    // Médias de uma medição
+    struct Medias
+    {
+        double intervalo_ms = 0.0;
+        double paginas = 0.0;
+    };
 
-// Classe que gerencia o spool de impressão
-class Spool
+    // Gera todos os pedidos do gerador e retorna a vazão, com as médias dos intervalos e das páginas
+    auto medir = [](GeradorPedidos &gerador, Medias &medias)
+    {
+        Pedido pedido;
+        std::int64_t soma_intervalos_us = 0;
+        std::int64_t soma_paginas = 0;
+        auto hora = std::chrono::system_clock::now();
+        auto inicio = std::chrono::steady_clock::now();
+        while (!gerador.terminou())
+        {
+            soma_intervalos_us += gerador.proximo(pedido, hora);
+            soma_paginas += pedido.num_paginas;
+        }
+        std::chrono::duration<double> duracao = std::chrono::steady_clock::now() - inicio;
+        double quantidade = std::max(1, gerador.quantidade());
+        medias.intervalo_ms = soma_intervalos_us / 1000.0 / quantidade;
+        medias.paginas = soma_paginas / quantidade;
+        return gerador.quantidade() / duracao.count();
+    };
+    auto imprimir = [](const std::string &nome, double vazao, const Medias &medias)
+    {
+        std::cout << std::left << std::setw(32) << nome << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(16) << vazao << std::setprecision(2) << std::setw(15) << medias.intervalo_ms << " ms"
+                  << std::setw(15) << medias.paginas << (vazao < 1e6 ? "  abaixo da meta" : "") << "\n";
+    };
+
+    ParametrosCarga carga;
+    carga.pedidos_por_processo = total_pedidos;
+    carga.semente = 42;
+    carga.paginas_max = 1000;
+    carga.periodo_diurno_s = 60;
+    const ProcessoChegada chegadas[] = {ProcessoChegada::Fixo, ProcessoChegada::Poisson, ProcessoChegada::Rajadas,
+                                        ProcessoChegada::Diurno};
+    const DistribuicaoPaginas distribuicoes[] = {DistribuicaoPaginas::Uniforme, DistribuicaoPaginas::Pareto};
+    for (DistribuicaoPaginas distribuicao : distribuicoes)
+    {
+        for (ProcessoChegada chegada : chegadas)
+        {
+            carga.chegada = chegada;
+            carga.distribuicao_paginas = distribuicao;
+            GeradorPedidos gerador(1, carga);
+            Medias medias;
+            double vazao = medir(gerador, medias);
+            imprimir(std::string(nome_chegada(chegada)) + (distribuicao == DistribuicaoPaginas::Pareto ? ", pareto" : ", uniforme"),
+                     vazao, medias);
+        }
+    }
+
+    // Trace de um milhão de pedidos em quatro processos, gravado e lido de volta
+    const int pedidos_trace = 1000000;
+    const int processos_trace = 4;
+    std::filesystem::path caminho = std::filesystem::temp_directory_path() / "benchmark_trace.csv";
+    {
+        std::ofstream arquivo(caminho, std::ios::binary);
+        arquivo << "instante_ms,processo,paginas,prioridade\n";
+        std::mt19937 gen(42);
+        for (int i = 0; i < pedidos_trace; ++i)
+            arquivo << i / 10 << "." << i % 10 << "," << 1 + i % processos_trace << "," << 1 + gen() % 100 << ","
+                    << 1 + gen() % NUM_PRIORIDADES << "\n";
+    }
+    auto inicio = std::chrono::steady_clock::now();
+    carga.trace = TraceCarga::ler(caminho.string());
+    std::chrono::duration<double> leitura = std::chrono::steady_clock::now() - inicio;
+    std::filesystem::remove(caminho);
+    std::cout << std::left << std::setw(32) << "trace, leitura" << std::right << std::fixed << std::setprecision(0)
+              << std::setw(16) << carga.trace->total() / leitura.count() << "\n";
+
+    Medias medias;
+    double soma_vazoes = 0.0;
+    for (int processo = 1; processo <= processos_trace; ++processo)
+    {
+        GeradorPedidos gerador(processo, carga);
+        soma_vazoes += medir(gerador, medias);
+    }
+    imprimir("trace, reprodução", soma_vazoes / processos_trace, medias);
+}
+
+// Latência ponta a ponta dos documentos grandes de prioridade 5 com e sem divisão em partes, no
+// simulador: com as impressoras ociosas, as partes de um documento são impressas em paralelo; com
+// carga mista, as partes disputam as impressoras com os demais pedidos
+void executar_benchmark_divisao()
 {
-public:
-    // Construtor que define a capacidade máxima do buffer
-    Spool(int capacidade_buffer)
-        : capacidade(capacidade_buffer), encerrar(false) {}
+    Configuracao config;
+    config.num_impressoras = 8;
+    config.tempo_por_pagina_ms = 10;
+    config.capacidade_buffer = 256;
+    config.tempo_limite_inatividade_s = 3600;
+    config.carga.semente = 42;
+    config.simulado = true;
 
-    // Função para adicionar um pedido ao buffer
-    bool add_pedido(const Pedido &pedido)
+    std::cout << "\n=== BENCHMARK DA DIVISÃO DE DOCUMENTOS (SIMULADOR) ===\n";
+    std::cout << "Impressoras: " << config.num_impressoras << ", " << config.tempo_por_pagina_ms << " ms por página\n";
+
+    struct Cenario
+    {
+        const char *nome;
+        int num_processos;
+        int pedidos_por_processo;
+        int intervalo_ms;
+        int paginas_min;
+        std::vector<double> pesos;
+    };
+    const Cenario cenarios[] = {
+        {"Impressoras ociosas (documentos de 200 a 400 páginas, prioridade 5)", 1, 200, 5000, 200, {0, 0, 0, 0, 1}},
+        {"Carga mista (~70% da capacidade, 1 a 400 páginas, cinco prioridades)", 8, 200, 2800, 1, {1, 1, 1, 1, 1}}};
+    const int divisoes[] = {0, 100, 50, 25};
+
+    for (const Cenario &cenario : cenarios)
+    {
+        config.num_processos = cenario.num_processos;
+        config.carga.pedidos_por_processo = cenario.pedidos_por_processo;
+        config.carga.intervalo_ms = cenario.intervalo_ms;
+        config.carga.paginas_min = cenario.paginas_min;
+        config.carga.paginas_max = 400;
+        config.carga.pesos_prioridade = cenario.pesos;
+
+        std::cout << "\n" << cenario.nome << ", " << cenario.num_processos * cenario.pedidos_por_processo << " documentos\n";
+        std::cout << std::left << std::setw(16) << "Partes de" << std::right << std::setw(10) << "Partes" << std::setw(16)
+                  << "p50 P5" << std::setw(14) << "p99 P5" << std::setw(16) << "p99 todas" << std::setw(10) << "Ganho"
+                  << "\n";
+
+        double p50_base = 0.0;
+        for (int paginas_por_parte : divisoes)
+        {
+            config.paginas_por_parte = paginas_por_parte;
+            RegistrosImpressao registros(config.num_impressoras);
+            SimuladorSpool simulador(config, registros);
+            simulador.executar();
+
+            Histograma ponta_a_ponta_p5;
+            Histograma ponta_a_ponta;
+            registros.acumular_latencias(MetricaLatencia::PontaAPonta, PRIORIDADE_MAXIMA, 0, ponta_a_ponta_p5);
+            registros.acumular_latencias(MetricaLatencia::PontaAPonta, 0, 0, ponta_a_ponta);
+            double p50 = ponta_a_ponta_p5.percentil(50.0) / 1e6;
+            if (paginas_por_parte == 0)
+                p50_base = p50;
+            std::string rotulo = paginas_por_parte == 0 ? "sem divisão" : std::to_string(paginas_por_parte) + " páginas";
+            std::cout << std::left << std::setw(17) << rotulo << std::right << std::setw(10) << registros.total()
+                      << std::fixed << std::setprecision(2) << std::setw(14) << p50 << " s" << std::setw(12)
+                      << ponta_a_ponta_p5.percentil(99.0) / 1e6 << " s" << std::setw(14)
+                      << ponta_a_ponta.percentil(99.0) / 1e6 << " s" << std::setw(9)
+                      << formatar_ganho(p50 > 0 ? p50_base / p50 : 0.0) << "\n";
+        }
+    }
+}
+
+// Benchmark da preempção e do prazo de drenagem, com threads reais: espera na fila dos pedidos de
+// prioridade 5 que chegam com documentos longos de prioridade 1 em impressão, com e sem preempção,
+// e o tempo que as impressoras levam para parar no encerramento com o buffer cheio, com e sem prazo
+void executar_benchmark_preempcao()
+{
+    logger.definir_nivel(NivelLog::Silencioso);
+
+    std::cout << "\n=== BENCHMARK DA PREEMPÇÃO E DA DRENAGEM (THREADS) ===\n";
+    ParametrosCarga carga;
+    carga.pedidos_por_processo = 20;
+    carga.paginas_min = 1;
+    carga.paginas_max = 60;
+    carga.pesos_prioridade = {1, 0, 0, 0, 1};
+    carga.intervalo_ms = 150;
+    carga.chegada = ProcessoChegada::Poisson;
+    carga.semente = 42;
+    const int num_processos = 4;
+    const int num_impressoras = 2;
+    const int tempo_por_pagina_ms = 2;
+    std::cout << num_processos << " processos Poisson, " << num_impressoras << " impressoras, " << tempo_por_pagina_ms
+              << " ms por página, 1 a 60 páginas, prioridades 1 e 5 (~80% de ocupação)\n";
+    std::cout << std::left << std::setw(21) << "Preempção" << std::right << std::setw(16) << "Espera p50 P5"
+              << std::setw(16) << "Espera p99 P5" << std::setw(17) << "Ponta p50 P1" << std::setw(15) << "Preempções"
+              << std::setw(10) << "Ganho" << "\n";
+
+    double p50_base = 0.0;
+    for (int prioridade_preempcao : {0, PRIORIDADE_MAXIMA})
     {
-        std::unique_lock<std::mutex> lock(mutex_buffer);
-        // Atualiza o tempo da última solicitação
+        ConfiguracaoDespacho despacho;
+        despacho.prioridade_preempcao = prioridade_preempcao;
+        Spool spool(256, BackendSpool::Mutex, 30, nullptr, ConfiguracaoAdmissao(), ConfiguracaoEscalonamento(), despacho);
+        RegistrosImpressao registros(num_impressoras);
+        processos_ativos = num_processos;
+
+        std::vector<std::unique_ptr<Processo>> processos;
+        for (int i = 1; i <= num_processos; ++i)
         {
-            std::lock_guard<std::mutex> time_lock(last_request_mutex);
-            last_request_time = std::chrono::system_clock::now();
+            processos.emplace_back(std::make_unique<Processo>(i, spool, carga));
+            processos.back()->start();
         }
-        // Tenta adicionar o pedido ao buffer, esperando por até 1 segundo
-        if (!cond_var_buffer.wait_for(lock, std::chrono::seconds(1), [this]()
-                                      { return buffer.size() < capacidade || encerrar.load(); }))
+        std::vector<std::unique_ptr<Impressora>> impressoras;
+        for (int i = 1; i <= num_impressoras; ++i)
         {
-            // Timeout: não houve espaço disponível
-            {
-                std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                std::cout << "Buffer cheio. Pedido " << pedido.nome_documento << " foi descartado.\n\n";
-            }
-            return false; // Indica que o pedido foi descartado
+            impressoras.emplace_back(std::make_unique<Impressora>(i, spool, registros.colunas(i), tempo_por_pagina_ms));
+            impressoras.back()->start();
         }
-        if (encerrar.load())
-            return false;
-        buffer.push(pedido); // Adiciona o pedido à fila de prioridade
+        spool.wait_until_finished();
+        for (auto &processo : processos)
+            processo->join();
+        for (auto &impressora : impressoras)
+            impressora->join();
+
+        Histograma p5;
+        Histograma p1;
+        registros.acumular_latencias(MetricaLatencia::Espera, PRIORIDADE_MAXIMA, 0, p5);
+        registros.acumular_latencias(MetricaLatencia::PontaAPonta, PRIORIDADE_MINIMA, 0, p1);
+        double p50 = p5.percentil(50.0) / 1000.0;
+        if (prioridade_preempcao == 0)
+            p50_base = p50;
+        std::cout << std::left << std::setw(19) << (prioridade_preempcao == 0 ? "desligada" : "prioridade 5")
+                  << std::right << std::fixed << std::setprecision(1) << std::setw(13) << p50 << " ms" << std::setw(13)
+                  << p5.percentil(99.0) / 1000.0 << " ms" << std::setw(14) << p1.percentil(50.0) / 1000.0 << " ms"
+                  << std::setw(13) << spool.interrupcoes().preempcoes << std::setw(10)
+                  << formatar_ganho(p50 > 0 ? p50_base / p50 : 0.0) << "\n";
+    }
+
+    // Encerramento com 400 documentos de 10 páginas no buffer: sem prazo, as impressoras imprimem tudo
+    const int pedidos_no_buffer = 400;
+    std::cout << "\nEncerramento com " << pedidos_no_buffer << " documentos de 10 páginas no buffer, " << num_impressoras
+              << " impressoras, 1 ms por página\n";
+    std::cout << std::left << std::setw(18) << "Prazo" << std::right << std::setw(15) << "Até parar" << std::setw(12)
+              << "Impressos" << std::setw(13) << "Descartados" << std::setw(13) << "Abandonados" << "\n";
+    for (int prazo_ms : {-1, 100, 0})
+    {
+        ConfiguracaoDespacho despacho;
+        despacho.prazo_drenagem_ms = prazo_ms;
+        Spool spool(pedidos_no_buffer, BackendSpool::Mutex, 30, nullptr, ConfiguracaoAdmissao(), ConfiguracaoEscalonamento(),
+                    despacho);
+        RegistrosImpressao registros(num_impressoras);
+        for (int i = 0; i < pedidos_no_buffer; ++i)
+            spool.add_pedido(Pedido{i, 10, static_cast<std::int16_t>(PRIORIDADE_MINIMA + i % NUM_PRIORIDADES), 0, 1,
+                                    std::chrono::system_clock::now()});
+
+        auto inicio = std::chrono::steady_clock::now();
+        spool.encerrar_spool();
+        std::vector<std::unique_ptr<Impressora>> impressoras;
+        for (int i = 1; i <= num_impressoras; ++i)
+        {
+            impressoras.emplace_back(std::make_unique<Impressora>(i, spool, registros.colunas(i), 1));
+            impressoras.back()->start();
+        }
+        for (auto &impressora : impressoras)
+            impressora->join();
+        std::chrono::duration<double, std::milli> duracao = std::chrono::steady_clock::now() - inicio;
+
+        ResumoInterrupcoes interrupcoes = spool.interrupcoes();
+        std::cout << std::left << std::setw(18) << (prazo_ms < 0 ? "sem prazo" : std::to_string(prazo_ms) + " ms")
+                  << std::right << std::fixed << std::setprecision(1) << std::setw(11) << duracao.count() << " ms"
+                  << std::setw(12) << registros.documentos() << std::setw(13) << interrupcoes.descartados_drenagem
+                  << std::setw(13) << interrupcoes.impressoes_abandonadas << "\n";
+    }
+}
+
+// Mede a vazão (pedidos/s) de um cluster: o produtor p envia ao spool do processo p + 1 e o consumidor
+// c retira do spool c % num_spools, roubando dos vizinhos quando o próprio está vazio. roubados
+// recebe os pedidos retirados de um vizinho.
+double medir_cluster(BackendSpool backend, int num_spools, int num_produtores, int num_consumidores,
+                     int capacidade_buffer, int total_pedidos, std::uint64_t &roubados)
+{
+    ClusterSpool cluster(num_spools, capacidade_buffer, backend, 30, ConfiguracaoAdmissao(), ConfiguracaoEscalonamento(),
+                         ConfiguracaoDespacho());
+    std::atomic<int> consumidos(0);
+    int pedidos_por_produtor = total_pedidos / num_produtores;
+
+    auto inicio = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> consumidores;
+    for (int c = 0; c < num_consumidores; ++c)
+    {
+        consumidores.emplace_back([&cluster, &consumidos, c, num_spools]()
+                                  {
+                                      std::vector<Pedido> lote;
+                                      lote.reserve(1);
+                                      Spool *origem = nullptr;
+                                      while (cluster.get_pedidos(c % num_spools, lote, 1, 0, origem) > 0)
+                                          consumidos.fetch_add(1, std::memory_order_relaxed); });
+    }
+
+    std::vector<std::thread> produtores;
+    for (int p = 0; p < num_produtores; ++p)
+    {
+        produtores.emplace_back([&cluster, p, pedidos_por_produtor]()
+                                {
+                                    Spool &spool = cluster.spool_do_processo(p + 1);
+                                    Pedido pedido;
+                                    pedido.num_paginas = 1;
+                                    pedido.id_processo = p + 1;
+                                    for (int i = 0; i < pedidos_por_produtor; ++i)
+                                    {
+                                        pedido.id = i;
+                                        pedido.prioridade = PRIORIDADE_MINIMA + i % NUM_PRIORIDADES;
+                                        pedido.hora_solicitacao = std::chrono::system_clock::now();
+                                        while (!spool.add_pedido(pedido))
+                                            ;
+                                    } });
+    }
+
+    for (auto &produtor : produtores)
+        produtor.join();
+    while (consumidos.load() < pedidos_por_produtor * num_produtores)
+        std::this_thread::yield();
+    cluster.encerrar_spools();
+    for (auto &consumidor : consumidores)
+        consumidor.join();
+
+    std::chrono::duration<double> duracao = std::chrono::steady_clock::now() - inicio;
+    roubados = cluster.roubados();
+    return consumidos.load() / duracao.count();
+}
+
+// Benchmark do cluster: vazão com 1 a 8 spools para os mesmos produtores e consumidores, a fração de
+// pedidos roubados e a distribuição do anel de hash consistente
+void executar_benchmark_cluster()
+{
+    logger.definir_nivel(NivelLog::Silencioso);
+
+    const int num_produtores = 16;
+    const int num_consumidores = 16;
+    const int capacidade_buffer = 256;
+    const int total_pedidos = 200000;
+    std::cout << "\n=== BENCHMARK DO CLUSTER DE SPOOLS ===\n";
+    std::cout << "Produtores: " << num_produtores << ", impressoras: " << num_consumidores << ", capacidade por spool: "
+              << capacidade_buffer << ", pedidos: " << total_pedidos << "\n\n";
+    std::cout << std::left << std::setw(8) << "Spools" << std::right << std::setw(18) << "Mutex (p/s)" << std::setw(9)
+              << "Ganho" << std::setw(12) << "Roubados" << std::setw(22) << "Lock-free (p/s)" << std::setw(9) << "Ganho"
+              << std::setw(12) << "Roubados" << "\n";
 
-        // Impressão sincronizada da mensagem de recebimento do pedido
+    double base_mutex = 0.0;
+    double base_lock_free = 0.0;
+    for (int num_spools : {1, 2, 4, 8})
+    {
+        std::uint64_t roubados_mutex = 0;
+        std::uint64_t roubados_lock_free = 0;
+        double vazao_mutex = medir_cluster(BackendSpool::Mutex, num_spools, num_produtores, num_consumidores,
+                                           capacidade_buffer, total_pedidos, roubados_mutex);
+        double vazao_lock_free = medir_cluster(BackendSpool::LockFree, num_spools, num_produtores, num_consumidores,
+                                               capacidade_buffer, total_pedidos, roubados_lock_free);
+        if (num_spools == 1)
         {
-            std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-            std::cout << "-----------------------------------------\n";
-            std::cout << "Spool recebeu pedido " << pedido.nome_documento << " com "
-                      << pedido.num_paginas << " páginas, prioridade " << pedido.prioridade << ".\n";
-            std::cout << "-----------------------------------------\n\n";
+            base_mutex = vazao_mutex;
+            base_lock_free = vazao_lock_free;
         }
+        std::cout << std::left << std::setw(8) << num_spools << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(18) << vazao_mutex << std::setw(9) << formatar_ganho(vazao_mutex / base_mutex)
+                  << std::setprecision(1) << std::setw(11) << 100.0 * roubados_mutex / total_pedidos << "%"
+                  << std::setprecision(0) << std::setw(22) << vazao_lock_free << std::setw(9)
+                  << formatar_ganho(vazao_lock_free / base_lock_free) << std::setprecision(1) << std::setw(11)
+                  << 100.0 * roubados_lock_free / total_pedidos << "%\n";
+    }
 
-        cond_var_buffer.notify_one(); // Notifica que um novo pedido foi adicionado
-        return true;                  // Indica que o pedido foi adicionado com sucesso
+    // Anel: equilíbrio de 10000 processos entre 4 spools e processos movidos ao acrescentar um quinto
+    const int num_processos = 10000;
+    AnelConsistente anel_4(4);
+    AnelConsistente anel_5(5);
+    std::array<int, 4> por_spool{};
+    int movidos = 0;
+    for (int id = 1; id <= num_processos; ++id)
+    {
+        int spool = anel_4.spool_do_processo(id);
+        ++por_spool[spool];
+        movidos += anel_5.spool_do_processo(id) != spool ? 1 : 0;
     }
+    auto [menor, maior] = std::minmax_element(por_spool.begin(), por_spool.end());
+    std::cout << "\nAnel com " << AnelConsistente::NOS_VIRTUAIS << " nós virtuais por spool: " << num_processos
+              << " processos em 4 spools, de " << *menor << " a " << *maior << " por spool; com um quinto spool, "
+              << std::setprecision(1) << 100.0 * movidos / num_processos << "% dos processos mudam de spool (ideal 20%)\n";
+}
 
-    // Função para obter um pedido do buffer
-    bool get_pedido(Pedido &pedido)
+// Custo das métricas ao vivo: vazão do spool com e sem uma thread lendo snapshot() a cada 1 ms, bem
+// acima da frequência de uma coleta do Prometheus. Os contadores são atualizados em todos os casos;
+// a diferença é o tráfego de cache causado pelo leitor.
+void executar_benchmark_metricas()
+{
+    logger.definir_nivel(NivelLog::Silencioso);
+
+    const int repeticoes = 3;
+    std::cout << "\n=== BENCHMARK DAS MÉTRICAS AO VIVO ===\n";
+    std::cout << "Produtores: 4, impressoras: 4, capacidade: 1024, 200000 pedidos, melhor de " << repeticoes << "\n\n";
+    std::cout << std::left << std::setw(11) << "Backend" << std::right << std::setw(18) << "Sem leitor (p/s)"
+              << std::setw(18) << "Com leitor (p/s)" << std::setw(13) << "Variação" << std::setw(15) << "Leituras/s" << "\n";
+
+    for (BackendSpool backend : {BackendSpool::Mutex, BackendSpool::LockFree})
     {
-        std::unique_lock<std::mutex> lock(mutex_buffer);
-        // Espera até que haja um pedido na fila ou que o sistema esteja encerrando
-        cond_var_buffer.wait(lock, [this]()
-                             { return !buffer.empty() || encerrar.load(); });
+        ParametrosMedicao parametros;
+        parametros.backend = backend;
+        parametros.num_produtores = 4;
+        parametros.num_consumidores = 4;
+        parametros.capacidade_buffer = 1024;
+        parametros.total_pedidos = 200000;
 
-        if (buffer.empty())
+        // Alterna as medições para que variações da máquina afetem os dois casos igualmente
+        double sem_leitor = 0.0;
+        double com_leitor = 0.0;
+        double leituras_por_segundo = 0.0;
+        for (int r = 0; r < repeticoes; ++r)
         {
-            // Se a fila está vazia e o sistema está encerrando
-            return false; // Indica que não há mais pedidos para processar
+            parametros.ler_metricas = false;
+            sem_leitor = std::max(sem_leitor, medir_spool(parametros));
+            parametros.ler_metricas = true;
+            std::uint64_t leituras = 0;
+            double vazao = medir_spool(parametros, nullptr, nullptr, &leituras);
+            if (vazao > com_leitor)
+            {
+                com_leitor = vazao;
+                leituras_por_segundo = leituras * vazao / parametros.total_pedidos;
+            }
         }
+        std::ostringstream variacao;
+        variacao << std::showpos << std::fixed << std::setprecision(1) << (com_leitor / sem_leitor - 1.0) * 100.0 << "%";
+        std::cout << std::left << std::setw(11) << (backend == BackendSpool::LockFree ? "lockfree" : "mutex") << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(18) << sem_leitor << std::setw(18) << com_leitor << std::setw(11) << variacao.str()
+                  << std::setw(15) << leituras_por_segundo << "\n";
+    }
+}
 
-        pedido = buffer.top();        // Obtém o pedido de maior prioridade
-        buffer.pop();                 // Remove o pedido da fila
-        cond_var_buffer.notify_one(); // Notifica que um pedido foi removido
-        return true;
+#ifdef SPOOL_CONTAR_ALOCACOES
+// Conta as alocações no heap no caminho estável dos pedidos pelo spool: produtores preenchem os pedidos
+// com GeradorPedidos e os enviam com add_pedido/add_pedidos, e consumidores os retiram com
+// get_pedido/get_pedidos e registram a conclusão. Com fracao_cancelada, os produtores cancelam parte
+// dos pedidos aceitos, que contam como consumidos quando o cancelamento vale. A contagem começa quando
+// os pedidos de aquecimento saem do spool. Retorna as alocações por pedido medido.
+double medir_alocacoes_por_pedido(BackendSpool backend, PoliticaDespacho politica, int tamanho_lote,
+                                  double fracao_cancelada = 0.0)
+{
+    const int num_produtores = 2;
+    const int num_consumidores = 2;
+    const int pedidos_aquecimento = 20000;
+    const int pedidos_medidos = 200000;
+    const int total_pedidos = pedidos_aquecimento + pedidos_medidos;
+
+    ConfiguracaoDespacho despacho;
+    despacho.politica = politica;
+    despacho.tempos_por_pagina_ms.assign(num_consumidores, 1);
+    despacho.cancelamento = fracao_cancelada > 0.0;
+    Spool spool(256, backend, 30, nullptr, ConfiguracaoAdmissao(), ConfiguracaoEscalonamento(), despacho);
+
+    ParametrosCarga carga;
+    carga.pedidos_por_processo = total_pedidos / num_produtores;
+    carga.fracao_cancelada = fracao_cancelada;
+    carga.semente = 42;
+
+    std::atomic<int> consumidos(0);
+    std::atomic<std::uint64_t> alocacoes_inicio(0);
+    std::atomic<std::uint64_t> alocacoes_fim(0);
+    auto contar_consumidos = [&](int quantidade)
+    {
+        int antes = consumidos.fetch_add(quantidade);
+        int depois = antes + quantidade;
+        if (antes < pedidos_aquecimento && depois >= pedidos_aquecimento)
+            alocacoes_inicio.store(alocacoes_heap.load());
+        if (depois == total_pedidos)
+            alocacoes_fim.store(alocacoes_heap.load());
+    };
+
+    std::vector<std::thread> consumidores;
+    for (int i = 0; i < num_consumidores; ++i)
+    {
+        consumidores.emplace_back([&, i]()
+                                  {
+                                      std::vector<Pedido> lote(1);
+                                      lote.reserve(tamanho_lote);
+                                      while (true)
+                                      {
+                                          std::size_t retirados = tamanho_lote > 1
+                                                                      ? spool.get_pedidos(lote, tamanho_lote, i + 1)
+                                                                      : (spool.get_pedido(lote[0], i + 1) ? 1 : 0);
+                                          if (retirados == 0)
+                                              return;
+                                          for (std::size_t k = 0; k < retirados; ++k)
+                                              spool.concluir_pedido(lote[k]);
+                                          contar_consumidos(static_cast<int>(retirados));
+                                      } });
     }
 
-    // Função que espera até que o sistema esteja inativo e então sinaliza o encerramento
-    void wait_until_finished()
+    std::vector<std::thread> produtores;
+    for (int p = 0; p < num_produtores; ++p)
     {
-        // Inicializa o tempo da última solicitação como o tempo atual
+        produtores.emplace_back([&, p]()
+                                {
+                                    GeradorPedidos gerador(p + 1, carga);
+                                    Pedido pedido;
+                                    std::vector<Pedido> lote;
+                                    lote.reserve(tamanho_lote);
+                                    while (!gerador.terminou())
+                                    {
+                                        gerador.proximo(pedido, std::chrono::system_clock::now());
+                                        if (tamanho_lote == 1)
+                                        {
+                                            while (!spool.add_pedido(pedido))
+                                                ;
+                                            if (gerador.sortear_cancelamento() && spool.cancelar_pedido(pedido.id_processo, pedido.id))
+                                                contar_consumidos(1);
+                                            continue;
+                                        }
+                                        lote.push_back(pedido);
+                                        if (static_cast<int>(lote.size()) == tamanho_lote || gerador.terminou())
+                                        {
+                                            std::size_t aceitos = 0;
+                                            while ((aceitos = spool.add_pedidos(lote)) < lote.size())
+                                                lote.erase(lote.begin(), lote.begin() + aceitos);
+                                            lote.clear();
+                                        }
+                                    } });
+    }
+
+    for (auto &produtor : produtores)
+        produtor.join();
+    while (consumidos.load() < total_pedidos)
+        std::this_thread::yield();
+    spool.encerrar_spool();
+    for (auto &consumidor : consumidores)
+        consumidor.join();
+
+    return static_cast<double>(alocacoes_fim.load() - alocacoes_inicio.load()) / pedidos_medidos;
+}
+#endif
+
+// Verificação de alocações: o caminho estável de um pedido (geração, admissão, fila, retirada e
+// conclusão) não pode alocar memória em nenhum backend ou despacho. Retorna false se algum alocar.
+// Sem o contador de alocações (build comum), só avisa que a verificação ficou de fora.
+bool executar_verificacao_alocacoes()
+{
+    std::cout << "\n=== VERIFICAÇÃO DE ALOCAÇÕES POR PEDIDO ===\n";
+#ifndef SPOOL_CONTAR_ALOCACOES
+    std::cout << "Desativada neste build: compile com -DSPOOL_CONTAR_ALOCACOES (alvo benchmark do CMake).\n";
+    return true;
+#else
+    logger.definir_nivel(NivelLog::Silencioso); // Mede apenas o spool, sem a saída por pedido
+
+    std::cout << "Produtores: 2, consumidores: 2, buffer: 256, pedidos: 20000 de aquecimento + 200000 medidos\n\n";
+    std::cout << std::left << std::setw(31) << "Cenário" << std::right << std::setw(22) << "Alocações/pedido"
+              << std::setw(12) << "Resultado" << "\n";
+
+    struct Cenario
+    {
+        const char *nome;
+        BackendSpool backend;
+        PoliticaDespacho politica;
+        int tamanho_lote;
+        double fracao_cancelada;
+    };
+    const Cenario cenarios[] = {
+        {"mutex", BackendSpool::Mutex, PoliticaDespacho::Compartilhada, 1, 0.0},
+        {"mutex, lotes de 16", BackendSpool::Mutex, PoliticaDespacho::Compartilhada, 16, 0.0},
+        {"lock-free", BackendSpool::LockFree, PoliticaDespacho::Compartilhada, 1, 0.0},
+        {"lock-free, lotes de 16", BackendSpool::LockFree, PoliticaDespacho::Compartilhada, 16, 0.0},
+        {"mutex, menor-primeiro", BackendSpool::Mutex, PoliticaDespacho::MenorPrimeiro, 1, 0.0},
+        {"mutex, filas-locais", BackendSpool::Mutex, PoliticaDespacho::FilasLocais, 1, 0.0},
+        {"mutex, 10% cancelados", BackendSpool::Mutex, PoliticaDespacho::Compartilhada, 1, 0.1}};
+
+    bool sem_alocacoes = true;
+    for (const Cenario &cenario : cenarios)
+    {
+        double por_pedido = medir_alocacoes_por_pedido(cenario.backend, cenario.politica, cenario.tamanho_lote,
+                                                       cenario.fracao_cancelada);
+        sem_alocacoes = sem_alocacoes && por_pedido == 0.0;
+        std::cout << std::left << std::setw(30) << cenario.nome << std::right << std::fixed << std::setprecision(4)
+                  << std::setw(20) << por_pedido << std::setw(12) << (por_pedido == 0.0 ? "ok" : "FALHOU") << "\n";
+    }
+    return sem_alocacoes;
+#endif
+}
+
+// Executa a emissão de mensagens em rajadas, como as threads do spool entre uma pausa e outra,
+// e retorna o tempo total gasto pelas threads dentro das chamadas de log
+template <typename Emissor>
+std::chrono::duration<double> emitir_em_rajadas(int num_threads, int eventos_por_thread, Emissor emitir)
+{
+    const int tamanho_rajada = 64;
+    std::atomic<std::int64_t> tempo_emitindo_ns(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&tempo_emitindo_ns, &emitir, t, eventos_por_thread]()
+                             {
+                                 std::chrono::steady_clock::duration tempo(0);
+                                 for (int i = 0; i < eventos_por_thread; i += tamanho_rajada)
+                                 {
+                                     auto inicio = std::chrono::steady_clock::now();
+                                     for (int j = i; j < std::min(i + tamanho_rajada, eventos_por_thread); ++j)
+                                         emitir(t, j);
+                                     tempo += std::chrono::steady_clock::now() - inicio;
+                                     std::this_thread::sleep_for(std::chrono::microseconds(200));
+                                 }
+                                 tempo_emitindo_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(tempo).count()); });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    return std::chrono::nanoseconds(tempo_emitindo_ns.load());
+}
+
+// Teste de carga do log: threads emitindo mensagens por pedido com escrita síncrona
+// (mutex global e descarga por mensagem, como no terminal) e com o logger assíncrono
+void executar_benchmark_log()
+{
+    const int num_threads = 16;
+    const int eventos_por_thread = 20000;
+    const int total_eventos = num_threads * eventos_por_thread;
+    std::filesystem::path caminho = std::filesystem::temp_directory_path() / "spool_benchmark_log.txt";
+
+    std::cout << "\n=== TESTE DE CARGA DO LOG ===\n";
+    std::cout << "Threads: " << num_threads << ", mensagens por thread: " << eventos_por_thread
+              << " (rajadas de 64), saída: " << caminho.string() << "\n\n";
+
+    // Escrita síncrona: cada mensagem é formatada e gravada sob o mutex global
+    std::chrono::duration<double> tempo_sincrono;
+    {
+        std::ofstream arquivo(caminho);
+        tempo_sincrono = emitir_em_rajadas(num_threads, eventos_por_thread, [&arquivo](int t, int i)
+                                           {
+                                               std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+                                               arquivo << "-----------------------------------------\n";
+                                               arquivo << "Spool recebeu pedido arquivo_" << t << "_" << i << " com "
+                                                       << 1 + i % 10 << " páginas, prioridade " << 1 + i % 5 << ".\n";
+                                               arquivo << "-----------------------------------------\n\n";
+                                               arquivo.flush(); });
+    }
+
+    // Logger assíncrono: as threads só publicam eventos estruturados em seus buffers
+    std::chrono::duration<double> tempo_assincrono;
+    std::uint64_t descartados_antes = logger.descartados();
+    {
+        std::ofstream arquivo(caminho);
+        logger.definir_nivel(NivelLog::Detalhado);
+        logger.iniciar(arquivo);
+        tempo_assincrono = emitir_em_rajadas(num_threads, eventos_por_thread, [](int t, int i)
+                                             { logger.registrar(NivelLog::Detalhado, TipoEvento::PedidoRecebido, t, i, 1 + i % 10, 1 + i % 5); });
+        logger.encerrar();
+        logger.definir_nivel(NivelLog::Silencioso);
+    }
+    std::uint64_t descartados = logger.descartados() - descartados_antes;
+    std::filesystem::remove(caminho);
+
+    // Vazão = mensagens por segundo de tempo gasto pelas threads emissoras dentro do log
+    double vazao_sincrona = total_eventos / tempo_sincrono.count();
+    double vazao_assincrona = total_eventos / tempo_assincrono.count();
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "Síncrono: " << vazao_sincrona << " mensagens/s por thread emissora ("
+              << 1e9 / vazao_sincrona << " ns por mensagem)\n";
+    std::cout << "Assíncrono: " << vazao_assincrona << " mensagens/s por thread emissora ("
+              << 1e9 / vazao_assincrona << " ns por mensagem, " << formatar_ganho(vazao_assincrona / vazao_sincrona) << ")\n";
+    std::cout << "Mensagens descartadas por buffer cheio: " << descartados << " de " << total_eventos << "\n";
+}
+
+// Escreve uma leitura das métricas no formato de exposição em texto do Prometheus (versão 0.0.4)
+void escrever_metricas_prometheus(std::ostream &saida, const MetricasSpool &metricas)
+{
+    auto cabecalho = [&saida](const char *nome, const char *tipo, const char *ajuda)
+    {
+        saida << "# HELP " << nome << ' ' << ajuda << "\n# TYPE " << nome << ' ' << tipo << '\n';
+    };
+    saida << std::fixed << std::setprecision(6);
+
+    cabecalho("spool_capacidade_pedidos", "gauge", "Capacidade do buffer do spool.");
+    saida << "spool_capacidade_pedidos " << metricas.capacidade << '\n';
+    cabecalho("spool_ocupacao_pedidos", "gauge", "Pedidos no buffer do spool.");
+    saida << "spool_ocupacao_pedidos " << metricas.ocupacao << '\n';
+    cabecalho("spool_fila_pedidos", "gauge", "Pedidos no buffer por prioridade.");
+    for (int p = PRIORIDADE_MINIMA; p <= PRIORIDADE_MAXIMA; ++p)
+        saida << "spool_fila_pedidos{prioridade=\"" << p << "\"} "
+              << metricas.fila_por_prioridade[p - PRIORIDADE_MINIMA] << '\n';
+
+    cabecalho("spool_pedidos_enfileirados_total", "counter", "Pedidos aceitos no buffer.");
+    saida << "spool_pedidos_enfileirados_total " << metricas.admissao.aceitos << '\n';
+    cabecalho("spool_pedidos_retirados_total", "counter", "Pedidos retirados pelas impressoras.");
+    saida << "spool_pedidos_retirados_total " << metricas.retirados << '\n';
+    cabecalho("spool_pedidos_descartados_total", "counter", "Pedidos recusados ou despejados, por motivo.");
+    saida << "spool_pedidos_descartados_total{motivo=\"rejeitado\"} " << metricas.admissao.rejeitados << '\n'
+          << "spool_pedidos_descartados_total{motivo=\"limitado\"} " << metricas.admissao.limitados << '\n'
+          << "spool_pedidos_descartados_total{motivo=\"despejado\"} " << metricas.admissao.despejados << '\n';
+
+    if (!metricas.impressoras.empty())
+    {
+        cabecalho("spool_impressora_ocupada", "gauge", "1 se a impressora está imprimindo, 0 se ociosa.");
+        for (const auto &impressora : metricas.impressoras)
+            saida << "spool_impressora_ocupada{impressora=\"" << impressora.id_impressora << "\"} "
+                  << (impressora.ocupada ? 1 : 0) << '\n';
+        cabecalho("spool_impressora_pedidos_total", "counter", "Documentos concluídos por impressora.");
+        for (const auto &impressora : metricas.impressoras)
+            saida << "spool_impressora_pedidos_total{impressora=\"" << impressora.id_impressora << "\"} "
+                  << impressora.impressos << '\n';
+        cabecalho("spool_impressora_paginas_total", "counter", "Páginas impressas por impressora.");
+        for (const auto &impressora : metricas.impressoras)
+            saida << "spool_impressora_paginas_total{impressora=\"" << impressora.id_impressora << "\"} "
+                  << impressora.paginas << '\n';
+
+        // Percentis em segundos, como pede a convenção do Prometheus
+        cabecalho("spool_espera_segundos", "summary", "Espera na fila dos pedidos já iniciados, por prioridade.");
+        for (int p = PRIORIDADE_MINIMA; p <= PRIORIDADE_MAXIMA; ++p)
         {
-            std::lock_guard<std::mutex> time_lock(last_request_mutex);
-            last_request_time = std::chrono::system_clock::now();
+            const LatenciaMetricas &espera = metricas.espera_por_prioridade[p - PRIORIDADE_MINIMA];
+            for (std::size_t i = 0; i < PERCENTIS_RELATORIO.size(); ++i)
+                saida << "spool_espera_segundos{prioridade=\"" << p << "\",quantile=\""
+                      << std::defaultfloat << PERCENTIS_RELATORIO[i] / 100.0 << "\"} " << std::fixed
+                      << espera.percentis[i] / 1000.0 << '\n';
+            saida << "spool_espera_segundos_sum{prioridade=\"" << p << "\"} " << espera.soma_ms / 1000.0 << '\n'
+                  << "spool_espera_segundos_count{prioridade=\"" << p << "\"} " << espera.pedidos << '\n';
         }
+    }
+}
 
-        // Inicia a thread de monitoramento de inatividade
-        std::thread monitor_thread(&Spool::monitorar_inatividade, this);
+// Servidor HTTP mínimo em 127.0.0.1 que responde a qualquer requisição com snapshot() do spool no
+// formato do Prometheus. Uma única thread atende as conexões uma a uma; o spool não sabe do servidor,
+// e o único custo no caminho dos pedidos são os contadores que snapshot() lê.
+class ServidorMetricas
+{
+public:
+    // Construtor que abre a porta (0 = escolhida pelo sistema) e inicia a thread de atendimento
+    ServidorMetricas(const Spool &spool, int porta) : spool(spool)
+    {
+#ifdef _WIN32
+        (void)porta;
+        throw std::runtime_error("o endpoint de métricas requer sockets POSIX (sistemas POSIX)");
+#else
+        descritor = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (descritor < 0)
+            throw std::runtime_error("métricas: não foi possível criar o socket");
+        int reutilizar = 1;
+        ::setsockopt(descritor, SOL_SOCKET, SO_REUSEADDR, &reutilizar, sizeof(reutilizar));
 
-        // Espera até que o sistema esteja encerrando
-        monitor_thread.join();
+        sockaddr_in endereco{};
+        endereco.sin_family = AF_INET;
+        endereco.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        endereco.sin_port = htons(static_cast<std::uint16_t>(porta));
+        socklen_t tamanho = sizeof(endereco);
+        if (::bind(descritor, reinterpret_cast<sockaddr *>(&endereco), sizeof(endereco)) < 0 ||
+            ::listen(descritor, 16) < 0 ||
+            ::getsockname(descritor, reinterpret_cast<sockaddr *>(&endereco), &tamanho) < 0)
+        {
+            ::close(descritor);
+            throw std::runtime_error("métricas: não foi possível escutar na porta " + std::to_string(porta));
+        }
+        porta_escuta = ntohs(endereco.sin_port);
+        atendimento = std::thread(&ServidorMetricas::atender, this);
+#endif
     }
 
-    // Função para sinalizar o encerramento do spool (fallback)
-    void encerrar_spool()
+    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
+    ServidorMetricas(const ServidorMetricas &) = delete;
+    ServidorMetricas &operator=(const ServidorMetricas &) = delete;
+
+    // Para a thread de atendimento e fecha o socket
+    ~ServidorMetricas()
     {
-        encerrar.store(true);
-        cond_var_buffer.notify_all();
+        parar.store(true);
+        if (atendimento.joinable())
+            atendimento.join();
+#ifndef _WIN32
+        if (descritor >= 0)
+            ::close(descritor);
+#endif
+    }
+
+    // Porta em que o servidor escuta
+    int porta() const
+    {
+        return porta_escuta;
     }
 
 private:
-    std::priority_queue<Pedido> buffer;      // Fila de prioridade para os pedidos
-    std::mutex mutex_buffer;                 // Mutex para proteger o acesso ao buffer
-    std::condition_variable cond_var_buffer; // Variável de condição para sincronização
-    int capacidade;                          // Capacidade máxima do buffer
-    std::atomic<bool> encerrar;              // Flag para indicar o encerramento do sistema
+    // Aceita conexões até o pedido de parada; a espera por conexão tem prazo para observar a parada
+    void atender()
+    {
+#ifndef _WIN32
+        while (!parar.load())
+        {
+            pollfd escuta{descritor, POLLIN, 0};
+            if (::poll(&escuta, 1, 100) <= 0)
+                continue;
+            int conexao = ::accept(descritor, nullptr, nullptr);
+            if (conexao < 0)
+                continue;
+            responder(conexao);
+            ::close(conexao);
+        }
+#endif
+    }
 
-    // Função de monitoramento de inatividade
-    void monitorar_inatividade()
+    // Lê a requisição (o caminho é ignorado) e envia a leitura das métricas
+    void responder([[maybe_unused]] int conexao)
     {
-        const int tempo_limite = 30; // Tempo limite de inatividade em segundos
-        while (!encerrar.load())
+#ifndef _WIN32
+        pollfd leitura{conexao, POLLIN, 0};
+        char requisicao[1024];
+        if (::poll(&leitura, 1, 1000) > 0)
+            (void)::recv(conexao, requisicao, sizeof(requisicao), 0);
+
+        std::ostringstream corpo;
+        escrever_metricas_prometheus(corpo, spool.snapshot());
+        std::string texto = corpo.str();
+        std::string resposta = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                               std::to_string(texto.size()) + "\r\nConnection: close\r\n\r\n" + texto;
+        std::size_t enviados = 0;
+        while (enviados < resposta.size())
         {
-            std::this_thread::sleep_for(std::chrono::seconds(1)); // Verifica a cada segundo
-            std::chrono::system_clock::time_point agora = std::chrono::system_clock::now();
-            std::chrono::system_clock::time_point ultimo_pedido;
-            {
-                std::lock_guard<std::mutex> time_lock(last_request_mutex);
-                ultimo_pedido = last_request_time;
-            }
-            auto duracao = std::chrono::duration_cast<std::chrono::seconds>(agora - ultimo_pedido).count();
-            if (duracao >= tempo_limite)
-            { // Verifica se passaram 30 segundos
-                {
-                    std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                    std::cout << "\nNenhuma nova solicitação de impressão recebida por 30 segundos. Sinalizando encerramento.\n\n";
-                }
-                encerrar.store(true);         // Sinaliza para as impressoras encerrarem
-                cond_var_buffer.notify_all(); // Notifica todas as impressoras
-                break;
-            }
-            else
-            {
-                int tempo_restante = tempo_limite - static_cast<int>(duracao);
-                {
-                    std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                    std::cout << "\rRelatório será gerado em " << tempo_restante << " segundos.        " << std::flush;
-                }
-            }
+            ssize_t parte = ::send(conexao, resposta.data() + enviados, resposta.size() - enviados, MSG_NOSIGNAL);
+            if (parte <= 0)
+                return;
+            enviados += static_cast<std::size_t>(parte);
         }
+#endif
     }
+
+    const Spool &spool;              // Spool observado
+    int descritor = -1;              // Socket de escuta
+    int porta_escuta = 0;            // Porta efetiva (útil com a porta 0)
+    std::atomic<bool> parar{false};  // Pedido de parada da thread de atendimento
+    std::thread atendimento;         // Thread que atende as conexões
 };
 
-// Classe que representa uma Impressora
-class Impressora
+// Contadores de uma execução, comuns aos dois motores
+struct ResumoExecucao
 {
-public:
-    // Construtor que inicializa a impressora com seu ID, referência ao spool, registros, contador de páginas e tempo por página
-    Impressora(int id, Spool &spool, std::vector<RegistroImpressao> &registros,
-               std::unordered_map<int, int> &paginas_por_impressora, std::mutex &registro_mutex,
-               int tempo_por_pagina_ms)
-        : id_impressora(id), spool_ref(spool), registros_ref(registros),
-          paginas_por_impressora_ref(paginas_por_impressora), registro_mutex_ref(registro_mutex),
-          tempo_por_pagina_ms(tempo_por_pagina_ms) {}
+    int pedidos_gerados = 0;                      // Pedidos gerados pelos processos
+    int pedidos_descartados = 0;                  // Pedidos descartados pelo spool
+    double duracao_s = 0.0;                       // Tempo real da execução
+    double tempo_simulado_s = -1.0;               // Tempo no relógio simulado (negativo no modo com threads)
+    std::uint64_t eventos = 0;                    // Eventos tratados pelo simulador
+    RecuperacaoDiario diario;                     // Recuperação feita na abertura do diário
+    std::uint64_t segmentos_diario_removidos = 0; // Segmentos apagados pela compactação do diário
+    ResumoAdmissao admissao;                      // Pedidos aceitos, rejeitados, limitados e despejados
+    std::uint64_t pedidos_roubados = 0;           // Pedidos retirados de um spool vizinho (vários spools)
+    ResumoInterrupcoes interrupcoes;              // Cancelamentos, descartes na drenagem, preempções e abandonos
+    ResumoRastro rastro;                          // Trace exportado (com --rastro)
+};
 
-    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
-    Impressora(const Impressora &) = delete;
-    Impressora &operator=(const Impressora &) = delete;
+// Abre o diário configurado (nulo quando desligado) e guarda o resultado da recuperação no resumo
+std::unique_ptr<DiarioSpool> abrir_diario(const Configuracao &config, ResumoExecucao &resumo)
+{
+    if (config.diretorio_diario.empty())
+        return nullptr;
+    auto diario = std::make_unique<DiarioSpool>(config.diretorio_diario, config.diario_sincronizacao_ms,
+                                                static_cast<std::size_t>(config.diario_registros_sincronizacao));
+    resumo.diario = diario->recuperacao();
+    return diario;
+}
 
-    // Função que inicia a thread da impressora
-    void start()
+// Executa processos e impressoras em threads reais
+void executar_com_threads(const Configuracao &config, RegistrosImpressao &registros, ResumoExecucao &resumo)
+{
+    processos_ativos = config.num_processos; // Inicializa o contador de processos ativos
+
+    // Cria o spool com os parâmetros definidos (e os pedidos recuperados do diário, se houver)
+    std::unique_ptr<DiarioSpool> diario = abrir_diario(config, resumo);
+    Spool spool(config.capacidade_buffer, config.backend, config.tempo_limite_inatividade_s, diario.get(),
+                config.admissao, config.escalonamento, configuracao_despacho(config));
+    spool.observar_impressoras(registros);
+    std::unique_ptr<ServidorMetricas> servidor_metricas;
+    if (config.porta_metricas > 0)
+        servidor_metricas = std::make_unique<ServidorMetricas>(spool, config.porta_metricas);
+
+    auto inicio = std::chrono::steady_clock::now();
+
+    // Cria e inicia os processos que geram pedidos de impressão
+    std::vector<std::unique_ptr<Processo>> processos;
+    processos.reserve(config.num_processos); // Reserva espaço para evitar realocações
+    for (int i = 1; i <= config.num_processos; ++i)
     {
-        thread_impressora = std::thread(&Impressora::run, this);
+        processos.emplace_back(std::make_unique<Processo>(i, spool, config.carga, config.tamanho_lote));
+        processos.back()->start();
     }
 
-    // Função que espera a thread da impressora terminar
-    void join()
+    // Cria e inicia as impressoras usando std::unique_ptr
+    std::vector<std::unique_ptr<Impressora>> impressoras;
+    impressoras.reserve(config.num_impressoras); // Reserva espaço para evitar realocações
+    for (int i = 1; i <= config.num_impressoras; ++i)
     {
-        if (thread_impressora.joinable())
-            thread_impressora.join();
+        impressoras.emplace_back(std::make_unique<Impressora>(i, spool, registros.colunas(i),
+                                                              tempo_por_pagina_impressora(config, i), config.tamanho_lote));
+        impressoras.back()->start();
     }
 
-private:
-    int id_impressora;                                        // Identificador da impressora
-    Spool &spool_ref;                                         // Referência ao spool de impressão
-    std::vector<RegistroImpressao> &registros_ref;            // Referência aos registros de impressão
-    std::unordered_map<int, int> &paginas_por_impressora_ref; // Referência ao contador de páginas por impressora
-    std::mutex &registro_mutex_ref;                           // Referência ao mutex para registrar impressões
-    int tempo_por_pagina_ms;                                  // Tempo de impressão por página
-    std::thread thread_impressora;                            // Thread da impressora
+    // Espera até que todos os processos tenham terminado e a fila esteja vazia
+    spool.wait_until_finished();
 
-    // Função que simula o funcionamento da impressora
-    void run()
+    // Aguarda o término de todas as threads dos processos
+    for (auto &processo : processos)
     {
-        while (true)
-        {
-            Pedido pedido;
-            bool existe_pedido = spool_ref.get_pedido(pedido);
-            if (!existe_pedido)
-            {
-                // Nenhum pedido para processar e o spool está encerrando
-                std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                std::cout << "Impressora " << id_impressora << " está encerrando.\n\n";
-                break;
-            }
+        processo->join();
+        resumo.pedidos_gerados += processo->gerados();
+        resumo.pedidos_descartados += processo->descartados();
+    }
 
-            // Mensagem de início do processamento
-            {
-                std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                std::cout << "-----------------------------------------\n";
-                std::cout << "Impressora " << id_impressora << " iniciou processamento de "
-                          << pedido.nome_documento << " com " << pedido.num_paginas
-                          << " páginas, prioridade " << pedido.prioridade << ".\n";
-                std::cout << "-----------------------------------------\n\n";
-            }
+    // Aguarda o término de todas as threads das impressoras
+    for (auto &impressora : impressoras)
+    {
+        impressora->join();
+    }
+    if (diario)
+        resumo.segmentos_diario_removidos = diario->segmentos_removidos();
+    resumo.admissao = spool.contadores_admissao().ler();
+    resumo.interrupcoes = spool.interrupcoes();
 
-            auto inicio = std::chrono::system_clock::now(); // Horário de início da impressão
-            // Simula o tempo de impressão
-            std::this_thread::sleep_for(std::chrono::milliseconds(tempo_por_pagina_ms * pedido.num_paginas));
-            auto fim = std::chrono::system_clock::now(); // Horário de fim da impressão
+    resumo.duracao_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
 
-            // Calcula o tempo total de impressão
-            std::chrono::milliseconds duracao = std::chrono::duration_cast<std::chrono::milliseconds>(fim - inicio);
+// Executa processos e impressoras em threads reais com vários spools: cada processo envia ao spool do
+// anel de hash consistente, e a impressora i pertence ao spool (i - 1) % num_spools
+void executar_com_cluster(const Configuracao &config, RegistrosImpressao &registros, ResumoExecucao &resumo)
+{
+    processos_ativos = config.num_processos; // Inicializa o contador de processos ativos
 
-            // Registro da impressão
-            {
-                std::lock_guard<std::mutex> lock(registro_mutex_ref);
-                RegistroImpressao registro;
-                registro.nome_documento = pedido.nome_documento;
-                registro.num_paginas = pedido.num_paginas;
-                registro.id_processo = pedido.id_processo;
-                registro.id_impressora = id_impressora;
-                registro.hora_solicitacao = pedido.hora_solicitacao;
-                registro.hora_inicio = inicio;
-                registro.tempo_total = duracao;
-                registro.prioridade = pedido.prioridade;
-                registros_ref.push_back(registro);
-                paginas_por_impressora_ref[id_impressora] += pedido.num_paginas;
-            }
+    ClusterSpool cluster(config.num_spools, config.capacidade_buffer, config.backend, config.tempo_limite_inatividade_s,
+                         config.admissao, config.escalonamento, configuracao_despacho(config));
 
-            // Mensagem de conclusão do processamento
-            {
-                std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                std::cout << "-----------------------------------------\n";
-                std::cout << "Impressora " << id_impressora << " concluiu processamento de "
-                          << pedido.nome_documento << ".\n";
-                std::cout << "-----------------------------------------\n\n";
-            }
-        }
+    auto inicio = std::chrono::steady_clock::now();
+
+    std::vector<std::unique_ptr<Processo>> processos;
+    processos.reserve(config.num_processos);
+    for (int i = 1; i <= config.num_processos; ++i)
+    {
+        processos.emplace_back(std::make_unique<Processo>(i, cluster.spool_do_processo(i), config.carga, config.tamanho_lote));
+        processos.back()->start();
     }
-};
 
-// Função auxiliar para ler e validar entradas inteiras
-int ler_entrada(const std::string &prompt, int minimo)
-{
-    int valor;
-    while (true)
+    std::vector<std::unique_ptr<Impressora>> impressoras;
+    impressoras.reserve(config.num_impressoras);
+    for (int i = 1; i <= config.num_impressoras; ++i)
     {
-        {
-            std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-            std::cout << prompt;
-        }
-        std::cin >> valor;
+        int indice_spool = (i - 1) % config.num_spools;
+        impressoras.emplace_back(std::make_unique<Impressora>(i, cluster.spool(indice_spool), registros.colunas(i),
+                                                              tempo_por_pagina_impressora(config, i), config.tamanho_lote,
+                                                              &cluster, indice_spool));
+        impressoras.back()->start();
+    }
 
-        // Verifica se a leitura foi bem-sucedida
-        if (std::cin.fail())
-        {
-            std::cin.clear();                                                   // Limpa o estado de erro
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Descarte a entrada inválida
-            {
-                std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                std::cout << "Entrada inválida! Por favor, insira um número inteiro válido.\n\n";
-            }
-            continue;
-        }
+    // Cada spool encerra pelo seu monitor; o fim dos processos é avisado a todos eles
+    cluster.iniciar_monitores();
+    for (auto &processo : processos)
+    {
+        processo->join();
+        resumo.pedidos_gerados += processo->gerados();
+        resumo.pedidos_descartados += processo->descartados();
+    }
+    cluster.notificar_monitores();
+    cluster.wait_until_finished();
 
-        // Descarte qualquer caractere extra no buffer de entrada
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    for (auto &impressora : impressoras)
+        impressora->join();
+    resumo.admissao = cluster.contadores_admissao();
+    resumo.pedidos_roubados = cluster.roubados();
+    resumo.interrupcoes = cluster.interrupcoes();
 
-        // Verifica se o valor atende ao critério mínimo
-        if (valor >= minimo)
-        {
-            break;
-        }
-        else
-        {
-            {
-                std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                std::cout << "Valor inválido! O valor deve ser no mínimo " << minimo << ".\n\n";
-            }
-        }
-    }
-    return valor;
+    resumo.duracao_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
 }
 
-// Função para coletar os dados de entrada do usuário
-void coletar_dados(int &num_processos, int &num_impressoras, int &capacidade_buffer, int &tempo_por_pagina_ms)
+// Executa processos e impressoras como máquinas de estados em um pool de threads do tamanho dos núcleos
+void executar_com_executor(const Configuracao &config, RegistrosImpressao &registros, ResumoExecucao &resumo)
 {
-    {
-        std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-        std::cout << "Bem-vindo ao Simulador de Pool de Impressão!\n\n";
-    }
+    processos_ativos = config.num_processos; // Inicializa o contador de processos ativos
 
-    // Coleta a quantidade de processos (mínimo 1)
-    num_processos = ler_entrada("Quantidade de processos (mínimo 1): ", 1);
+    std::unique_ptr<DiarioSpool> diario = abrir_diario(config, resumo);
+    Spool spool(config.capacidade_buffer, config.backend, config.tempo_limite_inatividade_s, diario.get(),
+                config.admissao, config.escalonamento, configuracao_despacho(config));
+    spool.observar_impressoras(registros);
+    std::unique_ptr<ServidorMetricas> servidor_metricas;
+    if (config.porta_metricas > 0)
+        servidor_metricas = std::make_unique<ServidorMetricas>(spool, config.porta_metricas);
+    int num_threads = config.threads_executor > 0
+                          ? config.threads_executor
+                          : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    PoolExecucao pool(num_threads);
+    RodaTemporizadores roda;
+    ContadorConclusao conclusao(config.num_processos + config.num_impressoras);
 
-    // Coleta a quantidade de impressoras (mínimo 1)
-    num_impressoras = ler_entrada("Quantidade de impressoras (mínimo 1): ", 1);
+    auto inicio = std::chrono::steady_clock::now();
 
-    // Coleta a capacidade máxima do buffer (mínimo 1)
-    capacidade_buffer = ler_entrada("Capacidade máxima do buffer (mínimo 1): ", 1);
+    std::vector<std::unique_ptr<ProcessoAssincrono>> processos;
+    processos.reserve(config.num_processos);
+    for (int i = 1; i <= config.num_processos; ++i)
+        processos.emplace_back(std::make_unique<ProcessoAssincrono>(i, spool, config.carga, config.tamanho_lote,
+                                                                    pool, roda, conclusao));
 
-    // Coleta o tempo de impressão por página (mínimo 10 ms)
-    tempo_por_pagina_ms = ler_entrada("Tempo de impressão por página (ms, mínimo 10): ", 10);
+    std::vector<std::unique_ptr<ImpressoraAssincrona>> impressoras;
+    impressoras.reserve(config.num_impressoras);
+    for (int i = 1; i <= config.num_impressoras; ++i)
+        impressoras.emplace_back(std::make_unique<ImpressoraAssincrona>(i, spool, registros.colunas(i),
+                                                                        tempo_por_pagina_impressora(config, i), config.tamanho_lote,
+                                                                        pool, roda, conclusao));
+
+    // As tarefas só começam depois de todas criadas
+    for (auto &processo : processos)
+        processo->acordar();
+    for (auto &impressora : impressoras)
+        impressora->acordar();
+
+    // Espera até que todos os processos tenham terminado e a fila esteja vazia
+    spool.wait_until_finished();
+    conclusao.aguardar();
 
+    // Para temporizadores e threads antes de destruir as tarefas
+    roda.parar();
+    pool.parar();
+
+    for (const auto &processo : processos)
     {
-        std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-        std::cout << "\n";
+        resumo.pedidos_gerados += processo->gerados();
+        resumo.pedidos_descartados += processo->descartados();
     }
+    if (diario)
+        resumo.segmentos_diario_removidos = diario->segmentos_removidos();
+    resumo.admissao = spool.contadores_admissao().ler();
+    resumo.interrupcoes = spool.interrupcoes();
+    resumo.duracao_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
 }
 
-// Classe que representa um processo que gera pedidos de impressão
-class Processo
+// Executa o mesmo modelo no simulador de eventos discretos, em uma única thread
+void executar_simulacao(const Configuracao &config, RegistrosImpressao &registros, ResumoExecucao &resumo)
 {
-public:
-    // Construtor que inicializa o processo com seu ID, número máximo de pedidos e referência ao spool
-    Processo(int pid, int max_pedidos, Spool &spool)
-        : id(pid), max_pedidos(max_pedidos), spool_ref(spool), pedidos_enviados(0) {}
-
-    // Deleta o construtor de cópia e o operador de atribuição para evitar cópias
-    Processo(const Processo &) = delete;
-    Processo &operator=(const Processo &) = delete;
+    SimuladorSpool simulador(config, registros);
+    auto inicio = std::chrono::steady_clock::now();
+    simulador.executar();
+    resumo.duracao_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    resumo.pedidos_gerados = simulador.gerados();
+    resumo.pedidos_descartados = simulador.descartados();
+    resumo.admissao = simulador.admissao_pedidos();
+    resumo.tempo_simulado_s = std::chrono::duration<double>(simulador.tempo_simulado()).count();
+    resumo.eventos = simulador.eventos_processados();
+}
 
-    // Função para iniciar a thread do processo
-    void start()
+// Percentis de um histograma como objeto JSON, em milésimos da unidade registrada (ms para µs)
+void escrever_latencias_json(std::ostream &json, const Histograma &histograma)
+{
+    json << "{\"pedidos\":" << histograma.contagem();
+    for (double p : PERCENTIS_RELATORIO)
     {
-        thread_process = std::thread(&Processo::run, this);
+        char nome[16];
+        std::snprintf(nome, sizeof(nome), "p%g", p);
+        json << ",\"" << nome << "\":" << histograma.percentil(p) / 1000.0;
     }
+    json << ",\"media\":" << histograma.media() / 1000.0 << ",\"max\":" << histograma.maximo() / 1000.0 << "}";
+}
 
-    // Função para esperar a thread do processo terminar
-    void join()
-    {
-        if (thread_process.joinable())
-            thread_process.join();
-    }
+// Resumo de uma execução headless em uma linha JSON, na saída padrão
+void imprimir_resumo_json(const Configuracao &config, const ResumoExecucao &resumo, const RegistrosImpressao &registros)
+{
+    std::int64_t paginas = 0;
+    for (int i = 1; i <= registros.num_impressoras(); ++i)
+        paginas += registros.colunas(i).total_paginas();
+    std::size_t impressos = registros.documentos();
 
-private:
-    int id;                     // Identificador do processo
-    int max_pedidos;            // Número máximo de pedidos que o processo pode gerar
-    Spool &spool_ref;           // Referência ao spool de impressão
-    int pedidos_enviados;       // Contador de pedidos enviados
-    std::thread thread_process; // Thread do processo
+    // No simulador a vazão é medida no relógio simulado
+    double tempo_s = resumo.tempo_simulado_s >= 0 ? resumo.tempo_simulado_s : resumo.duracao_s;
 
-    // Função que executa o processo, gerando pedidos de impressão
-    void run()
-    {
-        try
-        {
-            // Inicialização do gerador de números aleatórios
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_int_distribution<> paginas_dist(1, 10);   // Distribuição para número de páginas
-            std::uniform_int_distribution<> prioridade_dist(1, 5); // Distribuição para prioridade
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\"motor\":\"" << (config.simulado ? "simulado" : config.executor ? "executor" : "threads") << "\""
+         << ",\"processos\":" << config.num_processos
+         << ",\"impressoras\":" << config.num_impressoras
+         << ",\"capacidade_buffer\":" << config.capacidade_buffer
+         << ",\"ms_por_pagina\":" << config.tempo_por_pagina_ms
+         << ",\"despacho\":\"" << nome_despacho(config.despacho) << "\""
+         << ",\"backend\":\"" << (config.backend == BackendSpool::LockFree ? "lockfree" : "mutex") << "\""
+         << ",\"lote\":" << config.tamanho_lote
+         << ",\"pedidos_por_processo\":" << config.carga.pedidos_por_processo
+         << ",\"semente\":" << config.carga.semente
+         << ",\"pedidos_gerados\":" << resumo.pedidos_gerados
+         << ",\"pedidos_descartados\":" << resumo.pedidos_descartados
+         << ",\"pedidos_impressos\":" << impressos
+         << ",\"paginas_impressas\":" << paginas
+         << ",\"duracao_s\":" << resumo.duracao_s;
+    if (config.num_spools > 1)
+        json << ",\"spools\":" << config.num_spools << ",\"pedidos_roubados\":" << resumo.pedidos_roubados;
+    if (config.carga.trace)
+        json << ",\"trace_pedidos\":" << config.carga.trace->total();
+    else if (config.carga.chegada != ProcessoChegada::Fixo)
+        json << ",\"chegadas\":\"" << nome_chegada(config.carga.chegada) << "\"";
+    if (config.paginas_por_parte > 0)
+        json << ",\"paginas_por_parte\":" << config.paginas_por_parte << ",\"partes_impressas\":" << registros.total();
+    if (config.simulado)
+        json << ",\"tempo_simulado_s\":" << resumo.tempo_simulado_s << ",\"eventos\":" << resumo.eventos;
+    json << ",\"pedidos_por_s\":" << (tempo_s > 0 ? impressos / tempo_s : 0.0)
+         << ",\"paginas_por_s\":" << (tempo_s > 0 ? paginas / tempo_s : 0.0)
+         << ",\"paginas_por_impressora\":[";
+    for (int i = 1; i <= registros.num_impressoras(); ++i)
+        json << (i > 1 ? "," : "") << registros.colunas(i).total_paginas();
 
-            while (pedidos_enviados < max_pedidos)
-            {
-                Pedido pedido;
-                pedido.id = pedidos_enviados++;
-                pedido.nome_documento = "arquivo_" + std::to_string(id) + "_" + std::to_string(pedido.id);
-                pedido.num_paginas = paginas_dist(gen);   // Gera um número aleatório de páginas
-                pedido.prioridade = prioridade_dist(gen); // Gera uma prioridade aleatória
-                pedido.id_processo = id;
-                pedido.hora_solicitacao = std::chrono::system_clock::now(); // Registra o horário da solicitação
-
-                // Impressão sincronizada da mensagem de geração do pedido
-                {
-                    std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                    std::cout << "-----------------------------------------\n";
-                    std::cout << "Processo " << id << " gerou pedido " << pedido.nome_documento
-                              << " com " << pedido.num_paginas << " páginas, prioridade " << pedido.prioridade << ".\n";
-                    std::cout << "-----------------------------------------\n\n";
-                }
+    // Utilização das impressoras na janela observada (da primeira solicitação ao último término)
+    double janela_s = registros.duracao_janela_s();
+    json << "],\"janela_s\":" << janela_s << ",\"utilizacao_impressoras\":[";
+    for (int i = 1; i <= registros.num_impressoras(); ++i)
+    {
+        double ocupado_s = std::chrono::duration<double>(registros.colunas(i).tempo_impressao()).count();
+        json << (i > 1 ? "," : "") << (janela_s > 0 ? ocupado_s / janela_s : 0.0);
+    }
+    if (!config.tempos_por_pagina_impressoras.empty())
+    {
+        json << "],\"ms_por_pagina_impressoras\":[";
+        for (int i = 1; i <= config.num_impressoras; ++i)
+            json << (i > 1 ? "," : "") << tempo_por_pagina_impressora(config, i);
+    }
 
-                bool sucesso = spool_ref.add_pedido(pedido); // Adiciona o pedido ao spool
-                if (!sucesso)
-                {
-                    // Opcional: registrar que o pedido foi descartado
-                    {
-                        std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-                        std::cout << "Processo " << id << " notificou que o pedido " << pedido.nome_documento << " foi descartado.\n\n";
-                    }
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Espera antes de gerar o próximo pedido
-            }
-        }
-        catch (const std::exception &e)
-        {
-            std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-            std::cerr << "Erro no processo " << id << ": " << e.what() << "\n";
-        }
-        catch (...)
+    // Latências totais e por prioridade, em ms
+    const std::pair<MetricaLatencia, const char *> metricas[] = {{MetricaLatencia::Espera, "espera"},
+                                                                 {MetricaLatencia::Servico, "servico"},
+                                                                 {MetricaLatencia::PontaAPonta, "ponta_a_ponta"}};
+    json << "],\"latencias_ms\":{";
+    for (std::size_t m = 0; m < std::size(metricas); ++m)
+    {
+        Histograma total;
+        registros.acumular_latencias(metricas[m].first, 0, 0, total);
+        json << (m > 0 ? "," : "") << "\"" << metricas[m].second << "\":{\"total\":";
+        escrever_latencias_json(json, total);
+        json << ",\"por_prioridade\":{";
+        for (int p = PRIORIDADE_MAXIMA; p >= PRIORIDADE_MINIMA; --p)
         {
-            std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-            std::cerr << "Erro desconhecido no processo " << id << ".\n";
+            Histograma histograma;
+            registros.acumular_latencias(metricas[m].first, p, 0, histograma);
+            json << (p < PRIORIDADE_MAXIMA ? "," : "") << "\"" << p << "\":";
+            escrever_latencias_json(json, histograma);
         }
-        processos_ativos--; // Decrementa o contador de processos ativos ao finalizar
+        json << "}}";
+    }
+    json << "}";
+    json << ",\"admissao\":{\"politica\":\"" << nome_politica(config.admissao.politica) << "\""
+         << ",\"prazo_ms\":" << config.admissao.prazo_ms
+         << ",\"taxa_por_processo\":" << config.admissao.taxa_por_processo
+         << ",\"aceitos\":" << resumo.admissao.aceitos
+         << ",\"rejeitados\":" << resumo.admissao.rejeitados
+         << ",\"limitados\":" << resumo.admissao.limitados
+         << ",\"despejados\":" << resumo.admissao.despejados << "}";
+    if (config.prioridade_preempcao > 0 || config.prazo_drenagem_ms >= 0 || config.carga.fracao_cancelada > 0.0)
+    {
+        json << ",\"interrupcoes\":{\"preempcao\":" << config.prioridade_preempcao
+             << ",\"prazo_drenagem_ms\":" << config.prazo_drenagem_ms
+             << ",\"fracao_cancelada\":" << config.carga.fracao_cancelada
+             << ",\"cancelados\":" << resumo.interrupcoes.cancelados
+             << ",\"descartados_drenagem\":" << resumo.interrupcoes.descartados_drenagem
+             << ",\"preempcoes\":" << resumo.interrupcoes.preempcoes
+             << ",\"impressoes_abandonadas\":" << resumo.interrupcoes.impressoes_abandonadas
+             << ",\"trechos_impressos\":" << registros.total() << "}";
+    }
+    if (config.escalonamento.dinamico())
+    {
+        json << ",\"escalonamento\":{\"envelhecimento_ms\":" << config.escalonamento.envelhecimento_ms
+             << ",\"espera_maxima\":{";
+        for (int p = PRIORIDADE_MAXIMA; p >= PRIORIDADE_MINIMA; --p)
         {
-            std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-            std::cout << "Processo " << id << " finalizou.\n\n";
+            Histograma histograma;
+            registros.acumular_latencias(MetricaLatencia::Espera, p, 0, histograma);
+            int limite_ms = config.escalonamento.espera_maxima_ms[p - PRIORIDADE_MINIMA];
+            json << (p < PRIORIDADE_MAXIMA ? "," : "") << "\"" << p << "\":{\"limite_ms\":" << limite_ms
+                 << ",\"espera_max_ms\":" << histograma.maximo() / 1000.0 << ",\"acima_do_limite\":"
+                 << (limite_ms > 0 ? registros.esperas_acima(p, std::chrono::milliseconds(limite_ms)).acima : 0) << "}";
         }
+        json << "}}";
     }
-};
-
-// Função auxiliar para converter um time_point para string formatada
-std::string time_point_to_string(const std::chrono::system_clock::time_point &tp)
-{
-    std::time_t t = std::chrono::system_clock::to_time_t(tp);
-    std::tm tm;
-#ifdef _WIN32
-    localtime_s(&tm, &t); // Função segura para Windows
-#else
-    localtime_r(&t, &tm); // Função segura para Unix/Linux
-#endif
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%H:%M:%S"); // Formato HH:MM:SS
-    return oss.str();
+    if (!config.diretorio_diario.empty())
+    {
+        json << ",\"diario\":{\"segmentos_lidos\":" << resumo.diario.segmentos
+             << ",\"registros_lidos\":" << resumo.diario.registros_lidos
+             << ",\"registros_invalidos\":" << resumo.diario.registros_invalidos
+             << ",\"pedidos_recuperados\":" << resumo.diario.pedidos_recuperados
+             << ",\"recuperacao_ms\":" << resumo.diario.duracao_ms
+             << ",\"segmentos_removidos\":" << resumo.segmentos_diario_removidos << "}";
+    }
+    if (!config.arquivo_rastro.empty())
+    {
+        json << ",\"rastro\":{\"threads\":" << resumo.rastro.threads
+             << ",\"eventos\":" << resumo.rastro.eventos
+             << ",\"sobrescritos\":" << resumo.rastro.sobrescritos << "}";
+    }
+    json << ",\"mensagens_log_descartadas\":" << logger.descartados() << "}\n";
+    std::cout << json.str();
 }
 
-// Função para gerar o relatório final de impressão
-void gerar_relatorio(const std::vector<RegistroImpressao> &registros, const std::unordered_map<int, int> &paginas_por_impressora)
+// Suite de benchmarks do núcleo do spool (alvo benchmark_spool do CMake): vazão e latência de
+// add_pedido/get_pedido em cada backend, variando produtores e consumidores (1 a 64), a capacidade do
+// buffer e a mistura de prioridades, sem pausas e sem mensagens. Os resultados saem em um objeto JSON,
+// um cenário por backend, com latências em µs, para acompanhar regressões de qualquer backend.
+void escrever_suite_benchmark(std::ostream &json, int pedidos_por_cenario)
 {
+    struct MisturaPrioridades
     {
-        std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-        std::cout << "-----------------------------------------\n";
-        std::cout << "=== RELATÓRIO FINAL ===\n\n";
+        const char *nome;
+        std::array<double, NUM_PRIORIDADES> pesos;
+    };
+    const MisturaPrioridades uniforme{"uniforme", {1, 1, 1, 1, 1}};
+    const MisturaPrioridades unica{"unica", {0, 0, 1, 0, 0}};
+    const MisturaPrioridades baixa{"80-baixa", {16, 1, 1, 1, 1}}; // 80% na prioridade 1
 
-        // Resumo de impressão por impressora
-        std::cout << "Resumo de Impressão por Impressora:\n";
-        for (const auto &[impressora, paginas] : paginas_por_impressora)
+    struct Cenario
+    {
+        const char *grupo;
+        int produtores;
+        int consumidores;
+        int capacidade;
+        const MisturaPrioridades *mistura;
+    };
+    std::vector<Cenario> cenarios;
+    for (int n = 1; n <= 64; n *= 2)
+        cenarios.push_back({"threads", n, n, 256, &uniforme});
+    cenarios.push_back({"assimetrico", 1, 16, 256, &uniforme});
+    cenarios.push_back({"assimetrico", 16, 1, 256, &uniforme});
+    for (int capacidade : {16, 4096})
+        cenarios.push_back({"capacidade", 4, 4, capacidade, &uniforme});
+    for (const MisturaPrioridades *mistura : {&unica, &baixa})
+        cenarios.push_back({"prioridades", 4, 4, 256, mistura});
+    const BackendSpool backends[] = {BackendSpool::Mutex, BackendSpool::LockFree};
+
+    logger.definir_nivel(NivelLog::Silencioso); // Mede apenas o spool, sem a saída por pedido
+
+    json << std::fixed << std::setprecision(3);
+    json << "{\"suite\":\"spool\",\"pedidos_por_cenario\":" << pedidos_por_cenario
+         << ",\"threads_hardware\":" << std::thread::hardware_concurrency() << ",\"cenarios\":[";
+    bool primeiro = true;
+    for (const Cenario &cenario : cenarios)
+    {
+        for (BackendSpool backend : backends)
         {
-            std::cout << "  Impressora " << impressora << " -> Total de páginas impressas: " << paginas << "\n";
+            const char *nome_backend = backend == BackendSpool::LockFree ? "lockfree" : "mutex";
+            ParametrosMedicao parametros;
+            parametros.backend = backend;
+            parametros.num_produtores = cenario.produtores;
+            parametros.num_consumidores = cenario.consumidores;
+            parametros.capacidade_buffer = cenario.capacidade;
+            parametros.total_pedidos = pedidos_por_cenario;
+            parametros.pesos_prioridade = cenario.mistura->pesos;
+
+            Histograma espera_fila;
+            Histograma chamada_envio;
+            auto inicio = std::chrono::steady_clock::now();
+            double vazao = medir_spool(parametros, &espera_fila, &chamada_envio);
+            std::chrono::duration<double> duracao = std::chrono::steady_clock::now() - inicio;
+
+            json << (primeiro ? "" : ",") << "\n{\"grupo\":\"" << cenario.grupo << "\",\"backend\":\"" << nome_backend
+                 << "\",\"produtores\":" << cenario.produtores << ",\"consumidores\":" << cenario.consumidores
+                 << ",\"capacidade\":" << cenario.capacidade << ",\"prioridades\":\"" << cenario.mistura->nome
+                 << "\",\"pedidos\":" << espera_fila.contagem() << ",\"duracao_s\":" << duracao.count()
+                 << ",\"pedidos_por_s\":" << vazao << ",\"espera_fila_us\":";
+            escrever_latencias_json(json, espera_fila);
+            json << ",\"chamada_add_us\":";
+            escrever_latencias_json(json, chamada_envio);
+            json << "}";
+            primeiro = false;
+
+            // Progresso na saída de erro, para não misturar com o JSON
+            std::cerr << cenario.grupo << " " << nome_backend << " " << cenario.produtores << "x"
+                      << cenario.consumidores << " capacidade " << cenario.capacidade << " " << cenario.mistura->nome
+                      << ": " << static_cast<long long>(vazao) << " pedidos/s\n";
         }
+    }
+    json << "\n]}\n";
+}
 
-        std::cout << "\nDetalhes dos Documentos Processados:\n";
+// Modo da suite: ./spool_program --benchmark-json[=ARQUIVO] [--pedidos=N]. Sem arquivo, o JSON vai
+// para a saída padrão.
+int executar_suite_benchmark(int argc, char *argv[])
+{
+    std::string arquivo_saida;
+    int pedidos_por_cenario = 200000;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string argumento = argv[i];
+            std::size_t igual = argumento.find('=');
+            std::string chave = argumento.substr(0, igual);
+            std::string valor = igual == std::string::npos ? "" : argumento.substr(igual + 1);
+            if (chave == "--benchmark-json")
+                arquivo_saida = valor;
+            else if (chave == "--pedidos")
+                pedidos_por_cenario = converter_inteiro("pedidos", valor, 64);
+            else
+                throw std::invalid_argument("opção desconhecida na suite de benchmarks: " + argumento);
+        }
+    }
+    catch (const std::invalid_argument &e)
+    {
+        std::cerr << "Erro: " << e.what() << "\nUse --ajuda para ver as opções.\n";
+        return 2;
     }
 
-    // Lista detalhada de cada documento processado
-    for (const auto &registro : registros)
+    if (arquivo_saida.empty())
     {
-        std::lock_guard<std::mutex> cout_lock_guard(cout_mutex);
-        std::cout << "-----------------------------------------\n";
-        std::cout << "Documento         : " << registro.nome_documento << "\n";
-        std::cout << "Páginas           : " << registro.num_paginas << "\n";
-        std::cout << "Processo          : " << registro.id_processo << "\n";
-        std::cout << "Impressora        : " << registro.id_impressora << "\n";
-        std::cout << "Prioridade        : " << registro.prioridade << "\n";
-        std::cout << "Hora Solicitação  : " << time_point_to_string(registro.hora_solicitacao) << "\n";
-        std::cout << "Hora Impressão    : " << time_point_to_string(registro.hora_inicio) << "\n";
-        std::cout << "Tempo Total       : " << registro.tempo_total.count() << "ms\n";
-        std::cout << "-----------------------------------------\n\n";
+        escrever_suite_benchmark(std::cout, pedidos_por_cenario);
+        return 0;
     }
+    std::ofstream arquivo(arquivo_saida);
+    if (!arquivo)
+    {
+        std::cerr << "Erro: não foi possível gravar os resultados em '" << arquivo_saida << "'\n";
+        return 1;
+    }
+    escrever_suite_benchmark(arquivo, pedidos_por_cenario);
+    std::cerr << "Resultados gravados em " << arquivo_saida << "\n";
+    return 0;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    int num_processos, num_impressoras, capacidade_buffer, tempo_por_pagina_ms;
+    // Modo de benchmark: ./spool_program --benchmark
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        executar_benchmark_contencao();
+        executar_benchmark_lotes();
+        executar_benchmark_diario();
+        executar_benchmark_log();
+        executar_benchmark_registros();
+        executar_benchmark_relatorio();
+        executar_benchmark_simulador();
+        executar_benchmark_carga();
+        executar_benchmark_admissao();
+        executar_benchmark_escalonamento();
+        executar_benchmark_despacho();
+        executar_benchmark_divisao();
+        executar_benchmark_preempcao();
+        executar_benchmark_metricas();
+        executar_benchmark_cluster();
+        return executar_verificacao_alocacoes() ? 0 : 1;
+    }
+
+    // Suite de benchmarks com resultados em JSON: ./spool_program --benchmark-json[=ARQUIVO]
+    if (argc > 1 && std::string(argv[1]).rfind("--benchmark-json", 0) == 0)
+        return executar_suite_benchmark(argc, argv);
 
-    // Coleta dos dados de entrada do usuário
-    coletar_dados(num_processos, num_impressoras, capacidade_buffer, tempo_por_pagina_ms);
+    Configuracao config;
+    if (argc > 1)
+    {
+        // Modo headless: parâmetros da linha de comando e/ou de um arquivo de configuração
+        std::string primeiro = argv[1];
+        if (primeiro == "--ajuda" || primeiro == "-h")
+        {
+            imprimir_ajuda();
+            return 0;
+        }
+        try
+        {
+            ler_argumentos(argc, argv, config);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            std::cerr << "Erro: " << e.what() << "\nUse --ajuda para ver as opções.\n";
+            return 2;
+        }
+    }
+    else
+    {
+        // Coleta dos dados de entrada do usuário
+        coletar_dados(config);
+    }
 
-    processos_ativos = num_processos; // Inicializa o contador de processos ativos
+    // Inicia a escrita assíncrona das mensagens (na saída de erro no modo headless)
+    logger.definir_nivel(config.nivel_log);
+    logger.iniciar(config.headless ? std::cerr : std::cout);
 
-    Spool spool(capacidade_buffer); // Cria o spool com a capacidade definida
+    RegistrosImpressao registros(config.num_impressoras); // Colunas de registros, uma por impressora
 
-    std::vector<RegistroImpressao> registros;            // Vetor para armazenar os registros de impressão
-    std::unordered_map<int, int> paginas_por_impressora; // Mapa para contar páginas por impressora
-    std::mutex registro_mutex;                           // Mutex para proteger o acesso aos registros
+#ifdef SPOOL_RASTREAMENTO
+    if (!config.arquivo_rastro.empty())
+        rastreador.ativar();
+#endif
 
-    // Inicializa o contador de páginas por impressora
-    for (int i = 1; i <= num_impressoras; ++i)
+    ResumoExecucao resumo;
+    try
     {
-        paginas_por_impressora[i] = 0;
+        if (config.simulado)
+            executar_simulacao(config, registros, resumo);
+        else if (config.executor)
+            executar_com_executor(config, registros, resumo);
+        else if (config.num_spools > 1)
+            executar_com_cluster(config, registros, resumo);
+        else
+            executar_com_threads(config, registros, resumo);
     }
-
-    // Cria e inicia os processos que geram pedidos de impressão
-    std::vector<std::unique_ptr<Processo>> processos;
-    processos.reserve(num_processos); // Reserva espaço para evitar realocações
-    for (int i = 1; i <= num_processos; ++i)
+    catch (const std::exception &e)
     {
-        processos.emplace_back(std::make_unique<Processo>(i, 5, spool)); // Cada processo gera 5 pedidos
-        processos.back()->start();
+        // Falha ao abrir ou recuperar o diário
+        logger.encerrar();
+        std::cerr << "Erro: " << e.what() << "\n";
+        return 1;
     }
 
-    // Cria e inicia as impressoras usando std::unique_ptr
-    std::vector<std::unique_ptr<Impressora>> impressoras;
-    impressoras.reserve(num_impressoras); // Reserva espaço para evitar realocações
-    for (int i = 1; i <= num_impressoras; ++i)
+    // Grava as mensagens pendentes antes do relatório
+    logger.encerrar();
+
+#ifdef SPOOL_RASTREAMENTO
+    // Com todas as threads encerradas, nenhum buffer de rastro está sendo escrito
+    if (!config.arquivo_rastro.empty())
     {
-        impressoras.emplace_back(std::make_unique<Impressora>(i, spool, registros, paginas_por_impressora, registro_mutex, tempo_por_pagina_ms));
-        impressoras.back()->start();
+        try
+        {
+            resumo.rastro = rastreador.exportar(config.arquivo_rastro);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Erro: " << e.what() << "\n";
+            return 1;
+        }
     }
+#endif
 
-    // Espera até que todos os processos tenham terminado e a fila esteja vazia
-    spool.wait_until_finished();
+    if (config.headless)
+    {
+        if (!config.arquivo_relatorio.empty())
+        {
+            int threads_relatorio = config.threads_relatorio > 0
+                                        ? config.threads_relatorio
+                                        : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+            std::ofstream arquivo(config.arquivo_relatorio, config.formato_relatorio == FormatoRelatorio::Binario
+                                                              ? std::ios::out | std::ios::binary
+                                                              : std::ios::out);
+            if (arquivo && config.formato_relatorio == FormatoRelatorio::Texto)
+                gerar_relatorio(registros, arquivo, config.escalonamento, true, threads_relatorio);
+            else if (arquivo)
+                EscritorRelatorio(arquivo, config.formato_relatorio, threads_relatorio).escrever(registros);
+            arquivo.close();
+            if (!arquivo)
+            {
+                std::cerr << "Erro: não foi possível gravar o relatório em '" << config.arquivo_relatorio << "'\n";
+                return 1;
+            }
+        }
+        imprimir_resumo_json(config, resumo, registros);
+        return 0;
+    }
 
-    // Aguarda o término de todas as threads dos processos
-    for (auto &processo : processos)
     {
-        processo->join();
+        std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+        std::cout << "Admissão (" << nome_politica(config.admissao.politica) << "): " << resumo.admissao.aceitos
+                  << " aceitos, " << resumo.admissao.rejeitados << " rejeitados, " << resumo.admissao.despejados
+                  << " despejados\n\n";
     }
 
-    // Aguarda o término de todas as threads das impressoras
-    for (auto &impressora : impressoras)
+    if (logger.descartados() > 0)
     {
-        impressora->join();
+        std::lock_guard<MutexSaida> cout_lock_guard(cout_mutex);
+        std::cout << "Mensagens de log descartadas por buffer cheio: " << logger.descartados() << "\n\n";
     }
 
-    // Gera o relatório final de impressão
-    gerar_relatorio(registros, paginas_por_impressora);
+    // Gera o relatório final de impressão; em execuções grandes, só o resumo vai para o terminal
+    bool detalhes = registros.total() <= LIMITE_DETALHES_CONSOLE;
+    gerar_relatorio(registros, std::cout, config.escalonamento, detalhes);
+    if (!detalhes)
+        std::cout << "\n" << registros.total() << " documentos processados; os detalhes de cada um ficam fora do "
+                  << "terminal acima de " << LIMITE_DETALHES_CONSOLE << " (use --relatorio=ARQUIVO no modo headless).\n";
 
     return 0;
 }